@@ -1,9 +1,28 @@
 #include "APU.hpp"
 #include "GBInternal.hpp"
 
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define APU_X86 1
+#include <emmintrin.h>
+#else
+#define APU_X86 0
+#endif
+
+#if APU_X86 && !defined(_MSC_VER)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define TARGET_SSE2
+#endif
+
 APU::APU()
 {
-
+	// Cuts off below about 14Hz
+	for (size_t i = 0; i < nChannels; i++)
+	{
+		Outputs[i].BassShift = 9;
+	}
 }
 
 APU::~APU()
@@ -63,90 +82,286 @@ void APU::connectGB(GBInternal* gb)
 		Channels[i]->connectGB(gb);
 	}
 
+	gb->scheduler.schedule(Scheduler::FrameSequencer, 0);
+
 }
 
-void APU::AudioSample(void* userdata, Uint8* stream, int len)
+void APU::produce(int16_t* Out, uint32_t nFrames)
 {
+	// The buffers only hold so many samples, so
+	// big requests are made a piece at a time.
+	while (nFrames > 0)
+	{
+		uint32_t n = nFrames < BlockFrames ? nFrames : BlockFrames;
 
-	APU* apu = static_cast<APU*>(userdata);
+		// Run emulation until every sample asked for is complete,
+		// which can take more than one go since the number of
+		// T-cycles per sample isn't a whole number.
+		uint32_t nComplete;
+		for (;;)
+		{
+			catchUp(gb->nClockCycles);
 
-	Sint16* buffer = reinterpret_cast<Sint16*>(stream);
-	int nSamples = len / sizeof(Sint16);
+			if ((nComplete = Outputs[0].available(gb->nClockCycles)) >= n)
+			{
+				break;
+			}
+
+			gb->runUntil(gb->nClockCycles + (uint64_t)((n - nComplete) / Outputs[0].rate()) + 1);
+		}
 
-	// Placeholder for analog value output
-	// by DAC.
-	uint8_t DigitalVal;
-	Sint16 AnalogVal;
+		mix(Out, n);
 
-	Sint16 RightChannel = 0, LeftChannel = 0;
+		Out += n * 2;
+		nFrames -= n;
+	}
+}
+
+uint32_t APU::take(int16_t* Out, uint32_t MaxFrames)
+{
+	catchUp(gb->nClockCycles);
 
-	for (int j = 0; j < nSamples; j += 2)
+	uint32_t n = std::min(Outputs[0].available(gb->nClockCycles), MaxFrames);
+	if (n > BlockFrames)
 	{
-		// Run emulation until next sample
-		for (int k = 0; k < 1000 * 4.19 / 44.1; k++)
+		n = BlockFrames;
+	}
+
+	mix(Out, n);
+
+	return n;
+}
+
+void APU::setRatio(double Ratio)
+{
+	// Every change up to SyncedTo has already been placed
+	// at the old rate, the rest are placed at the new one.
+	double Rate = (double)SampleRate / ClockSpeed * Ratio;
+
+	for (size_t i = 0; i < nChannels; i++)
+	{
+		Outputs[i].setRate(Rate, SyncedTo);
+	}
+}
+
+void APU::output(uint64_t Time)
+{
+	for (size_t i = 0; i < nChannels; i++)
+	{
+		// The DAC turns the channel's 0 to 15 into 1 down to -1
+		// in arbitrary units, and outputs nothing while it's off.
+		// The high-pass in the buffers takes out the DC offset 
+		// this leaves, the same as the capacitors in the console.
+		int32_t Level = 0;
+		if (Channels[i]->DACon)
 		{
-			apu->gb->clock();
+			Level = (15 - 2 * Channels[i]->GetSample()) * DACStep;
 		}
 
-		LeftChannel = 0;
-		RightChannel = 0;
+		if (Level != LastLevel[i])
+		{
+			Outputs[i].addDelta(Time, Level - LastLevel[i]);
+			LastLevel[i] = Level;
+		}
+	}
+}
+
+void APU::mix(int16_t* Out, uint32_t nFrames)
+{
+	for (size_t i = 0; i < nChannels; i++)
+	{
+		Outputs[i].read(ChannelSamples[i], nFrames);
+	}
+
+	// The samples up to each write are mixed with the values
+	// from before it, the rest with the current ones.
+	uint32_t First = 0;
+	size_t k = 0;
+	for (; k < MixerWrites.size() && MixerWrites[k].Sample < nFrames; k++)
+	{
+		uint32_t Last = std::max(First, MixerWrites[k].Sample);
+		mixRange(Out, First, Last, MixerWrites[k].NR50, MixerWrites[k].NR51);
+		First = Last;
+	}
+
+	if (k < MixerWrites.size())
+	{
+		mixRange(Out, First, nFrames, MixerWrites[k].NR50, MixerWrites[k].NR51);
+	}
+	else
+	{
+		mixRange(Out, First, nFrames, NR50->reg, NR51->reg);
+	}
+
+	MixerWrites.erase(MixerWrites.begin(), MixerWrites.begin() + k);
+	for (MixerWrite& w : MixerWrites)
+	{
+		w.Sample -= nFrames;
+	}
+}
+
+TARGET_SSE2 void APU::mixRange(int16_t* Out, uint32_t First, uint32_t Last, uint8_t Volume, uint8_t Panning)
+{
+	// Volume is NR50, 0 doesn't mute a side so 1 is added to it.
+	// Bits 0-3 of the panning (NR51) put channels 1-4 on the right,
+	// bits 4-7 put them on the left.
+	int32_t GainL = ((Volume >> 4) & 7) + 1;
+	int32_t GainR = (Volume & 7) + 1;
 
-		// Loop over all channels
-		for (size_t i = 0; i < 4; i++)
+	uint32_t i = First;
+
+#if APU_X86
+	if (UseSIMD)
+	{
+		__m128i MaskL[nChannels], MaskR[nChannels];
+		for (int c = 0; c < nChannels; c++)
 		{
-			// Get sample
-			DigitalVal = apu->Channels[i]->GetSample();
-
-			// The digitial value is then passed through
-			// a DAC which maps 0x0 to 0xF to the range 1 to -1
-			// in arbitrary units. This is then high pass filtered
-			// to remove the DC offset incurred. Otherwise you might
-			// hear some static since the speakers need to remain 
-			// displaced. What I do here avoids all these issues without
-			// low pass filtering at the cost of killing half the dynamic 
-			// range.
-			AnalogVal = 50 * DigitalVal;
-
-			// =========== Mixer =========== 
-			// Channel right sterio output
-			if ((apu->NR51->reg >> i) & 1)
-			{
-				RightChannel += AnalogVal;
-			}
+			MaskL[c] = _mm_set1_epi16((Panning >> (c + 4)) & 1 ? -1 : 0);
+			MaskR[c] = _mm_set1_epi16((Panning >> c) & 1 ? -1 : 0);
+		}
+
+		__m128i VolL = _mm_set1_epi16((int16_t)GainL);
+		__m128i VolR = _mm_set1_epi16((int16_t)GainR);
+
+		for (; i + 8 <= Last; i += 8)
+		{
+			__m128i L = _mm_setzero_si128();
+			__m128i R = _mm_setzero_si128();
 
-			// Channel left sterio output
-			if ((apu->NR51->reg >> (i + 4)) & 1)
+			for (int c = 0; c < nChannels; c++)
 			{
-				LeftChannel += AnalogVal;
+				__m128i Samples = _mm_loadu_si128((const __m128i*)(ChannelSamples[c] + i));
+				L = _mm_adds_epi16(L, _mm_and_si128(Samples, MaskL[c]));
+				R = _mm_adds_epi16(R, _mm_and_si128(Samples, MaskR[c]));
 			}
+
+			// Scaled by the volume in 32 bits and saturated back to 16
+			__m128i LLow = _mm_mullo_epi16(L, VolL), LHigh = _mm_mulhi_epi16(L, VolL);
+			__m128i RLow = _mm_mullo_epi16(R, VolR), RHigh = _mm_mulhi_epi16(R, VolR);
+
+			L = _mm_packs_epi32(_mm_unpacklo_epi16(LLow, LHigh), _mm_unpackhi_epi16(LLow, LHigh));
+			R = _mm_packs_epi32(_mm_unpacklo_epi16(RLow, RHigh), _mm_unpackhi_epi16(RLow, RHigh));
+
+			// Left and right samples interleaved
+			_mm_storeu_si128((__m128i*)(Out + i * 2), _mm_unpacklo_epi16(L, R));
+			_mm_storeu_si128((__m128i*)(Out + i * 2 + 8), _mm_unpackhi_epi16(L, R));
 		}
+	}
+#endif
 
-		// The master volume register NR50 contains
-		// a scale value for the left and right channels.
-		// Note we have added 1 since 0 should not mute the
-		// channel.
-		LeftChannel *= apu->NR50->VolL + 1;
-		RightChannel *= apu->NR50->VolR + 1;
+	// Saturates the same way as SSE2
+	auto Clamp = [](int32_t x) { return std::max(-32768, std::min(32767, x)); };
 
+	for (; i < Last; i++)
+	{
+		int32_t L = 0, R = 0;
+
+		for (int c = 0; c < nChannels; c++)
+		{
+			if ((Panning >> (c + 4)) & 1)
+			{
+				L = Clamp(L + ChannelSamples[c][i]);
+			}
+
+			if ((Panning >> c) & 1)
+			{
+				R = Clamp(R + ChannelSamples[c][i]);
+			}
+		}
 
-		buffer[j] = LeftChannel;
-		buffer[j + 1] = RightChannel;
+		Out[i * 2] = (int16_t)Clamp(L * GainL);
+		Out[i * 2 + 1] = (int16_t)Clamp(R * GainR);
 	}
 }
 
-void APU::clock()
+void APU::clock(uint64_t Cycle)
 {
 	if (!NR52->bAPU)
 	{
+		Steps = 0;
 		return;
 	}
 
-	// Pass clock signal to each channel
+	// Pass clock signal to each channel, the DAC outputs
+	// only have to be looked at again if one of them changed.
+	bool Changed = false;
 	for (size_t i = 0; i < nChannels; i++)
 	{
-		Channels[i]->clock();
+		Changed |= Channels[i]->clock(Cycle);
 	}
 
+	Steps = 0;
+
+	// The new output is heard from the end of this T-cycle,
+	// which is where a sample taken after it would have seen it.
+	if (Changed)
+	{
+		output(Cycle + 1);
+	}
+}
+
+void APU::catchUp(uint64_t Until)
+{
+	if (!Lazy)
+	{
+		for (; SyncedTo < Until; SyncedTo++)
+		{
+			clock(SyncedTo);
+			nCyclesClocked++;
+		}
+
+		return;
+	}
+
+	// Nothing changes while the APU is off, the registers
+	// can't be written and the channels aren't clocked.
+	if (!NR52->bAPU)
+	{
+		Steps = 0;
+		SyncedTo = std::max(SyncedTo, Until);
+		return;
+	}
+
+	while (SyncedTo < Until)
+	{
+		// After a register write or a frame sequencer step the
+		// channels re-evaluate everything on the next T-cycle.
+		bool Dirty = Steps != 0;
+		for (size_t i = 0; i < nChannels; i++)
+		{
+			Dirty |= Channels[i]->Dirty;
+		}
+
+		if (Dirty)
+		{
+			clock(SyncedTo++);
+			nCyclesClocked++;
+			continue;
+		}
+
+		// Otherwise the output stays the same until
+		// the next step in one of the channels.
+		uint64_t Step = Until;
+		for (size_t i = 0; i < nChannels; i++)
+		{
+			Step = std::min(Step, Channels[i]->nextStep(SyncedTo));
+		}
+
+		uint64_t To = Step < Until ? Step + 1 : Until;
+
+		for (size_t i = 0; i < nChannels; i++)
+		{
+			Channels[i]->skip(SyncedTo, To);
+		}
+
+		SyncedTo = To;
+
+		if (Step < Until)
+		{
+			output(To);
+			nStepsSkipped++;
+		}
+	}
 }
 
 
@@ -154,6 +369,8 @@ uint8_t APU::read(uint16_t addr)
 {
 	// addr >= 0xFF10 && addr <= 0xFF3F
 
+	catchUp(gb->nClockCycles);
+
 	if (addr == 0xFF10)		// NRx1: Channel 1 length timer & duty cycle
 	{
 		// Initial length timer cannot be read
@@ -183,6 +400,8 @@ void APU::write(uint16_t addr, uint8_t data)
 {
 	// addr >= 0xFF10 && addr <= 0xFF3F
 
+	catchUp(gb->nClockCycles);
+
 	// APU registers cannot be written to 
 	// while it is off except NR52 to turn
 	// it on.
@@ -191,6 +410,24 @@ void APU::write(uint16_t addr, uint8_t data)
 		return;
 	}
 
+	for (size_t i = 0; i < nChannels; i++)
+	{
+		Channels[i]->Dirty = true;
+	}
+
+	// Writes whose samples are beyond what the buffers hold are
+	// never mixed, and only the first write to apply from a sample
+	// matters, the values it keeps are the ones before that sample.
+	if (addr == 0xFF24 || addr == 0xFF25)
+	{
+		uint32_t Sample = Outputs[0].available(gb->nClockCycles);
+
+		if (Sample < Outputs[0].capacity() && (MixerWrites.empty() || MixerWrites.back().Sample != Sample))
+		{
+			MixerWrites.push_back({ Sample, NR50->reg, NR51->reg });
+		}
+	}
+
 	if (addr == 0xFF12)	// NR12: Channel 1 volume & envelope
 	{
 		// If initial volume is changed then we want to restart the sweep unit
@@ -288,4 +525,30 @@ void APU::write(uint16_t addr, uint8_t data)
 	{
 		gb->RAM[addr] = data;
 	}
+}
+
+void APU::frameSequencer()
+{
+	uint64_t Now = gb->nClockCycles;
+
+	// The channels pick these up when they're 
+	// clocked for this T-cycle.
+	catchUp(Now);
+	Steps = LengthStep;
+
+	if (Now % (1 << 15) == 0)
+	{
+		Steps |= SweepStep;
+	}
+
+	if (Now % (1 << 16) == 0)
+	{
+		Steps |= EnvelopeStep;
+	}
+
+	// Nothing else in this T-cycle can change the APU
+	// so the channels are clocked for it straight away.
+	catchUp(Now + 1);
+
+	gb->scheduler.schedule(Scheduler::FrameSequencer, Now + (1 << 14));
 }
\ No newline at end of file
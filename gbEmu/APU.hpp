@@ -4,7 +4,8 @@
 #include "Pulse.hpp"
 #include "Wave.hpp"
 #include "Noise.hpp"
-#include "SDL.h"
+#include "BlipBuffer.hpp"
+#include <vector>
 
 class GB;
 
@@ -17,18 +18,114 @@ public:
 	~APU();
 	void connectGB(GBInternal* gb);
 
+	// Both catch the channels up first
 	uint8_t read(uint16_t addr);
 	void write(uint16_t addr, uint8_t data);
-	void clock();
-	
 
-	// Static so it can referenced as callback function
-	static void AudioSample(void* userdata, Uint8* stream, int len);
+	// Clocks the channels for T-cycle Cycle
+	void clock(uint64_t Cycle);
+
+	// Clocks the channels for every T-cycle before Until. They're 
+	// only clocked one T-cycle at a time straight after a register
+	// write or a frame sequencer step, otherwise they're moved from
+	// one step in their output to the next. This only happens when 
+	// a register is accessed, the frame sequencer is clocked or 
+	// samples are produced, instead of on every T-cycle.
+	void catchUp(uint64_t Until);
+
+	// T-cycle the channels have been clocked up to
+	uint64_t SyncedTo = 0;
+
+	// When off the channels are clocked on every T-cycle by the 
+	// system like they used to be, which should give the same output.
+	bool Lazy = true;
+
+	// T-cycles the channels were clocked for one at a time 
+	// and the number of steps they were moved to otherwise.
+	uint64_t nCyclesClocked = 0;
+	uint64_t nStepsSkipped = 0;
+
+	// Called by the scheduler every 2^14 T-cycles (256Hz)
+	void frameSequencer();
+
+	// Units clocked by the frame sequencer on the current T-cycle
+	enum
+	{
+		LengthStep = 1 << 0,	// 256Hz
+		SweepStep = 1 << 1,		// 128Hz
+		EnvelopeStep = 1 << 2,	// 64Hz
+	};
+	uint8_t Steps = 0;
 	
+
+	// Runs the system for the next nFrames stereo samples at
+	// SampleRate, writing them to Out with the left one first.
+	void produce(int16_t* Out, uint32_t nFrames);
+
+	// Takes up to MaxFrames of the stereo samples complete so far
+	// without running the system. Returns how many there were.
+	uint32_t take(int16_t* Out, uint32_t MaxFrames);
+
+	// Makes Ratio times as many samples per T-cycle from now on,
+	// for keeping up with an audio device running slightly fast
+	// or slow. The pitch goes down by as much.
+	void setRatio(double Ratio);
+
+	const static uint32_t SampleRate = 44100;
+	const static uint32_t ClockSpeed = 4194304;
+
 	// Channels
 	const static uint8_t nChannels = 4;
 	SoundChannel* Channels[nChannels];
 
+	// Each channel's DAC output only changes when the channel's does,
+	// so only the changes are recorded, at the T-cycle they happen on.
+	// Each channel's samples are made from them band-limited, with
+	// the DC offset the DACs leave taken out by a high-pass.
+	BlipBuffer Outputs[nChannels] = {
+		{ ClockSpeed, SampleRate }, { ClockSpeed, SampleRate },
+		{ ClockSpeed, SampleRate }, { ClockSpeed, SampleRate } };
+
+	// DAC output of each channel since the last change
+	int32_t LastLevel[nChannels] = {};
+
+	// One step of a DAC's output in the samples. All four channels
+	// at their loudest on one side with NR50 turned all the way up
+	// come to 15 * 64 * 4 * 8 = 30720, just under the 16-bit limit.
+	const static int32_t DACStep = 64;
+
+	// Records any change in each channel's DAC 
+	// output as happening from T-cycle Time onwards
+	void output(uint64_t Time);
+
+	// Stereo samples mixed at a time
+	const static uint32_t BlockFrames = 1024;
+
+	// Samples of each channel being mixed
+	int16_t ChannelSamples[nChannels][BlockFrames];
+
+	// Takes the next nFrames samples of every channel and mixes
+	// them into Out, panned by NR51 and scaled by NR50.
+	void mix(int16_t* Out, uint32_t nFrames);
+
+	// Mixes ChannelSamples from First up to Last with the given
+	// NR50 and NR51, 8 samples at a time with SSE2.
+	void mixRange(int16_t* Out, uint32_t First, uint32_t Last, uint8_t Volume, uint8_t Panning);
+
+	// The mixer can be switched to scalar code to compare against
+	bool UseSIMD = true;
+
+	// Samples are mixed long after NR50 and NR51 were written, so 
+	// every write keeps the values from before it along with the
+	// first sample the new ones apply to.
+	struct MixerWrite
+	{
+		uint32_t Sample;
+		uint8_t NR50;
+		uint8_t NR51;
+	};
+	std::vector<MixerWrite> MixerWrites;
+
 	Pulse pulse1{0};
 	Pulse pulse2{1};
 	Wave wave{2};
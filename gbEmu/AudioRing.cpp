@@ -0,0 +1,85 @@
+#include "AudioRing.hpp"
+#include <algorithm>
+
+AudioRing::AudioRing(uint32_t Capacity)
+{
+	uint32_t Size = 1;
+	while (Size < Capacity)
+	{
+		Size <<= 1;
+	}
+
+	Mask = Size - 1;
+	Buffer.resize(Size * 2);
+}
+
+uint32_t AudioRing::push(const int16_t* Frames, uint32_t nFrames)
+{
+	uint64_t H = Head.load(std::memory_order_relaxed);
+	uint64_t T = Tail.load(std::memory_order_acquire);
+
+	uint32_t Space = capacity() - (uint32_t)(H - T);
+	uint32_t n = std::min(nFrames, Space);
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		uint32_t At = (uint32_t)((H + i) & Mask) * 2;
+		Buffer[At] = Frames[i * 2];
+		Buffer[At + 1] = Frames[i * 2 + 1];
+	}
+
+	// The samples have to be written before the consumer sees them
+	Head.store(H + n, std::memory_order_release);
+
+	if (n < nFrames)
+	{
+		nOverruns.fetch_add(nFrames - n, std::memory_order_relaxed);
+	}
+
+	return n;
+}
+
+uint32_t AudioRing::pop(int16_t* Frames, uint32_t nFrames)
+{
+	uint64_t T = Tail.load(std::memory_order_relaxed);
+	uint64_t H = Head.load(std::memory_order_acquire);
+
+	uint32_t Queued = (uint32_t)(H - T);
+	uint32_t n = std::min(nFrames, Queued);
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		uint32_t At = (uint32_t)((T + i) & Mask) * 2;
+		Frames[i * 2] = Buffer[At];
+		Frames[i * 2 + 1] = Buffer[At + 1];
+	}
+
+	// The samples have to be read before the producer overwrites them
+	Tail.store(T + n, std::memory_order_release);
+
+	if (n < nFrames)
+	{
+		nUnderruns.fetch_add(nFrames - n, std::memory_order_relaxed);
+	}
+
+	Fill.store(Queued, std::memory_order_relaxed);
+	if (Queued < LowestFill.load(std::memory_order_relaxed))
+	{
+		LowestFill.store(Queued, std::memory_order_relaxed);
+	}
+
+	return n;
+}
+
+uint32_t AudioRing::size()
+{
+	uint64_t T = Tail.load(std::memory_order_acquire);
+	uint64_t H = Head.load(std::memory_order_acquire);
+
+	return (uint32_t)(H - T);
+}
+
+uint32_t AudioRing::takeLowestFill()
+{
+	return LowestFill.exchange(UINT32_MAX, std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <vector>
+
+/// <summary>
+/// Queue of stereo samples passed from the emulation thread to the
+/// audio callback. There is only ever one thread pushing and one
+/// popping, so each side only moves its own position and neither
+/// has to take a lock, which the audio callback mustn't do. Samples
+/// the callback asks for which aren't there yet and samples pushed
+/// when the queue is full are counted instead of waited for.
+/// </summary>
+class AudioRing
+{
+public:
+	// Capacity in stereo samples, rounded up to a power of two
+	AudioRing(uint32_t Capacity = 1 << 13);
+
+	// Queues up to nFrames stereo samples (left first), the
+	// ones which don't fit are dropped. Returns how many fit.
+	uint32_t push(const int16_t* Frames, uint32_t nFrames);
+
+	// Takes up to nFrames stereo samples, returns how many there were
+	uint32_t pop(int16_t* Frames, uint32_t nFrames);
+
+	// Stereo samples queued, safe to call from either side
+	uint32_t size();
+	uint32_t capacity() { return Mask + 1; }
+
+	// Stereo samples the callback went without and
+	// samples dropped because the queue was full.
+	std::atomic<uint64_t> nUnderruns{ 0 };
+	std::atomic<uint64_t> nOverruns{ 0 };
+
+	// Samples queued when the callback last took some, and the
+	// fewest since takeLowestFill() was last called.
+	std::atomic<uint32_t> Fill{ 0 };
+	uint32_t takeLowestFill();
+
+private:
+	std::vector<int16_t> Buffer;
+	uint32_t Mask;
+
+	// Total stereo samples ever pushed and popped, each only
+	// changed by its own side. Head - Tail are queued.
+	std::atomic<uint64_t> Head{ 0 };
+	std::atomic<uint64_t> Tail{ 0 };
+
+	std::atomic<uint32_t> LowestFill{ UINT32_MAX };
+};
\ No newline at end of file
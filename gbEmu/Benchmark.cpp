@@ -0,0 +1,1024 @@
+#include "Benchmark.hpp"
+#include "PostProcess.hpp"
+#include "EmulationThread.hpp"
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <cstring>
+#include <random>
+#include <vector>
+
+Benchmark::Benchmark(std::string gbFilename) : gbFilename(gbFilename)
+{
+	std::cout << std::fixed << std::setprecision(2);
+}
+
+void Benchmark::run()
+{
+	cpu();
+	blockCache();
+	jit();
+	stepping();
+	halt();
+	idleLoops();
+	memory();
+	lazyFlags();
+	construction();
+	scanlines();
+	tileCache();
+	compositor();
+	frameSkip();
+	objects();
+	renderThread();
+	postProcess();
+	audio();
+	apu();
+	mixer();
+}
+
+GBInternal* Benchmark::create()
+{
+	// Not every register is initialized by the constructors, 
+	// start from zeroed memory so each run starts out the 
+	// same as the first game loaded after launching.
+	void* Memory = ::operator new(sizeof(GBInternal));
+	memset(Memory, 0, sizeof(GBInternal));
+
+	return new (Memory) GBInternal(gbFilename);
+}
+
+double Benchmark::elapsed(std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+double Benchmark::runSystem(GBInternal* gb)
+{
+	uint64_t nCycles = (uint64_t)nSeconds * ClockSpeed;
+
+	auto t0 = std::chrono::steady_clock::now();
+	gb->runUntil(nCycles);
+
+	return elapsed(t0);
+}
+
+double Benchmark::runCPU(GBInternal* gb)
+{
+	uint64_t nCycles = (uint64_t)nSeconds * ClockSpeed;
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (uint64_t i = 0; i < nCycles; i++)
+	{
+		gb->cpu.clock();
+		gb->nClockCycles++;
+	}
+
+	return elapsed(t0);
+}
+
+void Benchmark::cpu()
+{
+	// Full system, every component is clocked as it 
+	// would be when playing the game.
+	{
+		std::unique_ptr<GBInternal> gb(create());
+		double t = runSystem(gb.get());
+
+		std::cout << "[cpu] full system: " << t << " s for " << nSeconds << " emulated s ("
+			<< nSeconds / t << "x realtime), "
+			<< gb->cpu.nInstructions / t * 1e-6 << " MIPS" << std::endl;
+	}
+
+	// CPU only, the remaining components aren't clocked
+	// so this measures the interpreter by itself. Games 
+	// waiting on LY or interrupts will just spin, which 
+	// is still a stream of instructions.
+	{
+		std::unique_ptr<GBInternal> gb(create());
+		double t = runCPU(gb.get());
+
+		std::cout << "[cpu] cpu only:    " << t << " s for " << nSeconds << " emulated s ("
+			<< nSeconds / t << "x realtime), "
+			<< gb->cpu.nInstructions / t * 1e-6 << " MIPS" << std::endl;
+	}
+}
+
+void Benchmark::blockCache()
+{
+	// Same as the cpu only benchmark with and without 
+	// the decoded instructions being cached.
+	for (bool Enabled : { false, true })
+	{
+		std::unique_ptr<GBInternal> gb(create());
+		gb->blockCache.Enabled = Enabled;
+		double t = runCPU(gb.get());
+
+		std::cout << "[blockCache] " << (Enabled ? "enabled:  " : "disabled: ")
+			<< gb->cpu.nInstructions / t * 1e-6 << " MIPS";
+
+		if (Enabled)
+		{
+			std::cout << ", hit rate " << 100 * gb->blockCache.hitRate() << "% ("
+				<< gb->blockCache.nHits << " hits, "
+				<< gb->blockCache.nMisses << " decoded, "
+				<< gb->blockCache.nUncached << " uncached)";
+		}
+
+		std::cout << std::endl;
+	}
+}
+
+void Benchmark::jit()
+{
+	for (bool Enabled : { false, true })
+	{
+		std::unique_ptr<GBInternal> gb(create());
+		gb->jit.Enabled = Enabled;
+		double tCPU = runCPU(gb.get());
+		double MIPS = gb->cpu.nInstructions / tCPU * 1e-6;
+
+		gb.reset(create());
+		gb->jit.Enabled = Enabled;
+		double tSystem = runSystem(gb.get());
+
+		std::cout << "[jit] " << (Enabled ? "enabled:  " : "disabled: ")
+			<< MIPS << " MIPS cpu only, " << nSeconds / tSystem << "x realtime full system";
+
+		if (Enabled)
+		{
+			std::cout << ", " << gb->jit.nTranslated << " runs translated, "
+				<< 100.0 * gb->jit.nInstructions / gb->cpu.nInstructions << "% of instructions native, "
+				<< gb->jit.nRollbacks << " rollbacks, " << gb->jit.nExits << " stopped by memory accesses";
+		}
+
+		std::cout << std::endl;
+	}
+
+	// The interpreter and the JIT are clocked side by side. The
+	// JIT core is ahead while a run's cycles are counted down so
+	// the registers are only compared when both are between
+	// instructions, rollbacks included.
+	std::unique_ptr<GBInternal> Interpreter(create());
+	std::unique_ptr<GBInternal> Native(create());
+	Interpreter->jit.Enabled = false;
+	Native->jit.Enabled = true;
+
+	uint64_t nCycles = (uint64_t)nSeconds * ClockSpeed;
+	uint64_t nMismatches = 0;
+
+	for (uint64_t i = 0; i < nCycles; i++)
+	{
+		Interpreter->clock();
+		Native->clock();
+
+		SM83& c = Interpreter->cpu;
+		SM83& n = Native->cpu;
+
+		if (c.cycle != 0 || n.cycle != 0 || n.Run != nullptr)
+		{
+			continue;
+		}
+
+		if (((c.A << 8) | c.flags()) != ((n.A << 8) | n.flags()) || c.BC != n.BC || 
+			c.DE != n.DE || c.HL != n.HL || c.SP != n.SP || c.PC != n.PC)
+		{
+			if (nMismatches == 0)
+			{
+				std::cout << "[jit] first mismatch at T-cycle " << i << std::hex
+					<< ", PC " << c.PC << " against " << n.PC
+					<< ", AF " << ((c.A << 8) | c.flags()) << " against " << ((n.A << 8) | n.flags())
+					<< std::dec << std::endl;
+			}
+
+			nMismatches++;
+		}
+	}
+
+	bool SameMemory = memcmp(Interpreter->RAM, Native->RAM, sizeof(Interpreter->RAM)) == 0;
+
+	std::cout << "[jit] differential: " << Interpreter->cpu.nInstructions << " instructions, "
+		<< nMismatches << " T-cycles with different registers, memory "
+		<< (SameMemory ? "identical" : "different") << std::endl;
+}
+
+void Benchmark::stepping()
+{
+	// Full system clocked every T-cycle against the
+	// CPU running an instruction at a time.
+	for (bool Stepping : { false, true })
+	{
+		std::unique_ptr<GBInternal> gb(create());
+		gb->Stepping = Stepping;
+		gb->SkipHalt = false;
+		double t = runSystem(gb.get());
+
+		std::cout << "[stepping] " << (Stepping ? "enabled:  " : "disabled: ")
+			<< nSeconds / t << "x realtime, "
+			<< gb->cpu.nInstructions / t * 1e-6 << " MIPS" << std::endl;
+	}
+}
+
+
+void Benchmark::halt()
+{
+	for (bool Stepping : { false, true })
+	{
+		for (bool SkipHalt : { false, true })
+		{
+			std::unique_ptr<GBInternal> gb(create());
+			gb->Stepping = Stepping;
+			gb->SkipHalt = SkipHalt;
+			double t = runSystem(gb.get());
+
+			std::cout << "[halt] " << (Stepping ? "stepping, " : "clocking, ")
+				<< (SkipHalt ? "skipped:     " : "not skipped: ")
+				<< nSeconds / t << "x realtime";
+
+			if (SkipHalt)
+			{
+				uint64_t nCycles = (uint64_t)nSeconds * ClockSpeed;
+
+				std::cout << ", " << 100.0 * gb->nHaltSkipped / nCycles << "% of T-cycles skipped, "
+					<< (gb->nFrames == 0 ? 0 : gb->nHaltSkipped / gb->nFrames) << " per frame on average, "
+					<< gb->nHaltSkippedLastFrame << " in the last frame";
+			}
+
+			std::cout << std::endl;
+		}
+	}
+}
+
+void Benchmark::idleLoops()
+{
+	// Only done when stepping. Skipping has to end up bit 
+	// identical to stepping through the loop, RAM, the CPU 
+	// registers and the clock are compared with the run 
+	// which doesn't skip.
+	std::vector<uint8_t> Reference;
+
+	for (bool Enabled : { false, true })
+	{
+		std::unique_ptr<GBInternal> gb(create());
+		gb->Stepping = true;
+		gb->idleLoop.Enabled = Enabled;
+		double t = runSystem(gb.get());
+
+		SM83& c = gb->cpu;
+		uint16_t Registers[] = { (uint16_t)((c.A << 8) | c.flags()), c.BC, c.DE, c.HL, c.SP, c.PC };
+
+		std::vector<uint8_t> State(gb->RAM, gb->RAM + sizeof(gb->RAM));
+		State.insert(State.end(), (uint8_t*)Registers, (uint8_t*)(Registers + 6));
+		State.insert(State.end(), (uint8_t*)&gb->nClockCycles, (uint8_t*)(&gb->nClockCycles + 1));
+		if (!Enabled)
+		{
+			Reference = State;
+		}
+
+		std::cout << "[idle] " << (Enabled ? "skipped:     " : "not skipped: ")
+			<< nSeconds / t << "x realtime" << (State == Reference ? "" : ", state DIFFERS");
+
+		if (Enabled)
+		{
+			uint64_t nCycles = (uint64_t)nSeconds * ClockSpeed;
+
+			std::cout << ", " << 100.0 * gb->idleLoop.nSkipped / nCycles << "% of T-cycles skipped in "
+				<< gb->idleLoop.nSkips << " skips" << std::endl;
+
+			gb->idleLoop.printLog(std::cout);
+		}
+		else
+		{
+			std::cout << std::endl;
+		}
+	}
+}
+
+double Benchmark::accessRate(GBInternal* gb, uint16_t addr, bool Write, bool UsePageTable)
+{
+	const uint32_t nAccesses = 1 << 24;
+
+	gb->UsePageTable = UsePageTable;
+	gb->mapMemory();
+
+	uint8_t Sum = 0;
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < nAccesses; i++)
+	{
+		if (Write)
+		{
+			gb->write(addr + (i & 0x3F), (uint8_t)i);
+		}
+		else
+		{
+			Sum += gb->read(addr + (i & 0x3F));
+		}
+	}
+	double t = elapsed(t0);
+
+	// Keeps the reads from being optimised away
+	gb->RAM[0xC000] = Sum;
+
+	return nAccesses / t * 1e-6;
+}
+
+void Benchmark::memory()
+{
+	struct Region
+	{
+		const char* Name;
+		uint16_t addr;
+		bool Writable;	// Writes to ROM would switch banks
+	};
+
+	const Region Regions[] = {
+		{ "ROM bank 0", 0x0000, false },
+		{ "ROM bank n", 0x4000, false },
+		{ "VRAM      ", 0x8000, true },
+		{ "Cart RAM  ", 0xA000, true },
+		{ "WRAM      ", 0xC000, true },
+		{ "Echo RAM  ", 0xE000, false },
+		{ "OAM       ", 0xFE00, false },
+		{ "IO        ", 0xFF40, false },
+		{ "HRAM      ", 0xFF80, true },
+	};
+
+	std::unique_ptr<GBInternal> gb(create());
+
+	// Enable cartridge RAM
+	gb->write(0x0000, 0x0A);
+
+	for (const Region& r : Regions)
+	{
+		std::cout << "[memory] " << r.Name << " read "
+			<< accessRate(gb.get(), r.addr, false, false) << " -> "
+			<< accessRate(gb.get(), r.addr, false, true) << " M/s";
+
+		if (r.Writable)
+		{
+			std::cout << ", write "
+				<< accessRate(gb.get(), r.addr, true, false) << " -> "
+				<< accessRate(gb.get(), r.addr, true, true) << " M/s";
+		}
+
+		std::cout << std::endl;
+	}
+}
+
+void Benchmark::lazyFlags()
+{
+	for (bool Lazy : { false, true })
+	{
+		std::unique_ptr<GBInternal> gb(create());
+		gb->cpu.useLazyFlags(Lazy);
+		double tCPU = runCPU(gb.get());
+		double MIPS = gb->cpu.nInstructions / tCPU * 1e-6;
+
+		gb.reset(create());
+		gb->cpu.useLazyFlags(Lazy);
+		double tSystem = runSystem(gb.get());
+
+		std::cout << "[lazyFlags] " << (Lazy ? "lazy:  " : "eager: ")
+			<< MIPS << " MIPS cpu only, " << nSeconds / tSystem << "x realtime full system" << std::endl;
+	}
+
+	// Both cores are clocked side by side and the registers compared
+	// after every T-cycle, the pending flags are worked out without
+	// disturbing the lazy core so flags left pending across several 
+	// instructions are checked as well.
+	std::unique_ptr<GBInternal> Eager(create());
+	std::unique_ptr<GBInternal> Lazy(create());
+	Eager->cpu.useLazyFlags(false);
+	Lazy->cpu.useLazyFlags(true);
+
+	uint64_t nCycles = (uint64_t)nSeconds * ClockSpeed;
+	uint64_t nMismatches = 0;
+
+	for (uint64_t i = 0; i < nCycles; i++)
+	{
+		Eager->clock();
+		Lazy->clock();
+
+		SM83& e = Eager->cpu;
+		SM83& l = Lazy->cpu;
+
+		if (e.AF != ((l.A << 8) | l.flags()) || e.BC != l.BC || e.DE != l.DE || 
+			e.HL != l.HL || e.SP != l.SP || e.PC != l.PC)
+		{
+			if (nMismatches == 0)
+			{
+				std::cout << "[lazyFlags] first mismatch at T-cycle " << i << std::hex
+					<< ", PC " << e.PC << ", AF " << e.AF << " against " << ((l.A << 8) | l.flags())
+					<< std::dec << std::endl;
+			}
+
+			nMismatches++;
+		}
+	}
+
+	bool SameMemory = memcmp(Eager->RAM, Lazy->RAM, sizeof(Eager->RAM)) == 0;
+
+	std::cout << "[lazyFlags] differential: " << Eager->cpu.nInstructions << " instructions, "
+		<< nMismatches << " T-cycles with different registers, memory "
+		<< (SameMemory ? "identical" : "different") << std::endl;
+}
+
+void Benchmark::construction()
+{
+	const uint32_t nInstances = 1000;
+
+	// The CPU by itself and the whole system including 
+	// loading the cartridge from disk.
+	auto t0 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < nInstances; i++)
+	{
+		std::unique_ptr<SM83> cpu(new SM83());
+	}
+	double tCPU = elapsed(t0);
+
+	t0 = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < nInstances; i++)
+	{
+		std::unique_ptr<GBInternal> gb(create());
+	}
+	double tSystem = elapsed(t0);
+
+	std::cout << "[construction] SM83: " << tCPU / nInstances * 1e9 << " ns, "
+		<< sizeof(SM83) << " bytes, GBInternal: " << tSystem / nInstances * 1e9 << " ns, "
+		<< sizeof(GBInternal) << " bytes" << std::endl;
+}
+
+void Benchmark::scanlines()
+{
+	// The renderer is picked when building, dot and scanline builds
+	// have to print the same hash for the same cartridge. The FIFO 
+	// renderer should match them on ordinary games. It differs where
+	// SCX, VRAM or the like change part way through a line, as it reads
+	// them when the hardware does, where the window reaches the right 
+	// edge (the others leave its last 6 pixels) and where a game 
+	// depends on how long mode 3 takes.
+	std::unique_ptr<GBInternal> gb(create());
+	uint64_t nCycles = (uint64_t)nSeconds * ClockSpeed;
+	uint64_t Hash = 14695981039346656037ull;
+	uint64_t nFrames = 0;
+
+	auto t0 = std::chrono::steady_clock::now();
+
+	// A line at a time so each frame is hashed 
+	// once it's complete at the start of VBlank.
+	while (gb->nClockCycles < nCycles)
+	{
+		gb->runUntil(gb->nClockCycles + 456);
+
+		if (gb->nFrames != nFrames)
+		{
+			nFrames = gb->nFrames;
+
+			const uint8_t* Frame = &gb->ppu.DotMatrix[0][0];
+			for (size_t i = 0; i < sizeof(gb->ppu.DotMatrix); i++)
+			{
+				Hash = (Hash ^ Frame[i]) * 1099511628211ull;	// FNV-1a
+			}
+		}
+	}
+
+	double t = elapsed(t0);
+
+	std::cout << "[scanlines] " << PPU::Policy::name() << " renderer: " << nSeconds / t << "x realtime";
+
+	if (PPU::Policy::Batched)
+	{
+		uint64_t nLines = gb->ppu.nLinesBatched + gb->ppu.nLinesDotted;
+
+		std::cout << ", " << (nLines == 0 ? 0.0 : 100.0 * gb->ppu.nLinesBatched / nLines) 
+			<< "% of lines drawn in one go, " << gb->ppu.nLinesDotted << " fell back to per dot";
+	}
+
+	std::cout << ", " << nFrames << " frames hash to " << std::hex << Hash << std::dec << std::endl;
+}
+
+void Benchmark::tileCache()
+{
+	for (bool Enabled : { false, true })
+	{
+		std::unique_ptr<GBInternal> gb(create());
+		gb->tileCache.Enabled = Enabled;
+		gb->mapMemory();
+		double t = runSystem(gb.get());
+
+		std::cout << "[tileCache] " << (Enabled ? "enabled:  " : "disabled: ") << nSeconds / t << "x realtime";
+
+		if (Enabled)
+		{
+			std::cout << ", hit rate " << 100 * gb->tileCache.hitRate() << "% ("
+				<< gb->tileCache.nHits << " hits, "
+				<< gb->tileCache.nMisses << " expanded, "
+				<< gb->tileCache.nInvalidations << " invalidated)";
+		}
+
+		std::cout << std::endl;
+	}
+}
+
+void Benchmark::compositor()
+{
+	// Random layers, with objects over roughly a quarter of the pixels
+	const int nLines = 256;
+	std::vector<Compositor::Layers> Lines(nLines);
+	std::mt19937 Random(1);
+
+	for (Compositor::Layers& Line : Lines)
+	{
+		for (int x = 0; x < 20 * 8; x++)
+		{
+			Line.BG[x] = Random() % 4;
+			Line.Object[x] = Random() % 4 == 0 ? Random() % 8 : 0;
+			Line.Priority[x] = Random() % 2 ? 0xFF : 0;
+		}
+	}
+
+	const uint8_t BGShades[4] = { 0, 1, 2, 3 };
+	const uint8_t ObjectShades[8] = { 0, 1, 2, 3, 3, 2, 1, 0 };
+
+	static uint8_t Reference[nLines][20 * 8];
+	static uint8_t Out[nLines][20 * 8];
+
+	Compositor c;
+	Compositor::Kind Best = c.kind();
+
+	for (Compositor::Kind k : { Compositor::Scalar, Compositor::SSE2, Compositor::AVX2 })
+	{
+		if (!c.use(k))
+		{
+			continue;
+		}
+
+		// Each line is composed in full, as it is
+		// unless the line was changed part way.
+		const int nRepeats = 2000;
+		auto t0 = std::chrono::steady_clock::now();
+
+		for (int r = 0; r < nRepeats; r++)
+		{
+			for (int l = 0; l < nLines; l++)
+			{
+				c.compose(Lines[l], BGShades, ObjectShades, 0, 20 * 8, Out[l]);
+			}
+		}
+
+		double t = elapsed(t0);
+
+		if (k == Compositor::Scalar)
+		{
+			memcpy(Reference, Out, sizeof(Out));
+		}
+
+		// Lines starting and ending part way also have to match
+		c.compose(Lines[0], BGShades, ObjectShades, 3, 157, Out[0]);
+		c.compose(Lines[0], BGShades, ObjectShades, 0, 3, Out[0]);
+		c.compose(Lines[0], BGShades, ObjectShades, 157, 20 * 8, Out[0]);
+
+		std::cout << "[compositor] " << std::setw(6) << std::left << c.name() << std::right << ": "
+			<< (double)nRepeats * nLines * 20 * 8 / (t * 1e9) << " pixels/ns"
+			<< (memcmp(Reference, Out, sizeof(Out)) == 0 ? "" : ", DIFFERENT from scalar")
+			<< (k == Best ? " (used)" : "") << std::endl;
+	}
+}
+
+void Benchmark::frameSkip()
+{
+	// Memory at the end of drawing every frame, skipping 
+	// frames mustn't change anything but DotMatrix.
+	std::vector<uint8_t> Reference;
+
+	for (uint32_t N : { 1, 2, 4, 8, 0 })
+	{
+		std::unique_ptr<GBInternal> gb(create());
+
+		if (N == 0)
+		{
+			gb->ppu.FrameSkip = PPU::RenderNone;
+		}
+		else if (N > 1)
+		{
+			gb->ppu.FrameSkip = PPU::RenderOneInN;
+			gb->ppu.FrameSkipN = N;
+		}
+
+		double t = runSystem(gb.get());
+
+		std::vector<uint8_t> Memory(gb->RAM, gb->RAM + sizeof(gb->RAM));
+		if (N == 1)
+		{
+			Reference = Memory;
+		}
+
+		std::cout << "[frameSkip] ";
+		if (N == 0)
+		{
+			std::cout << "no frames:     ";
+		}
+		else
+		{
+			std::cout << "1 in " << N << " frames: ";
+		}
+
+		std::cout << nSeconds / t << "x realtime, " << gb->ppu.nFramesRendered << " drawn, "
+			<< gb->ppu.nFramesSkipped << " skipped" << (Memory == Reference ? "" : ", memory DIFFERS") << std::endl;
+	}
+}
+
+void Benchmark::objects()
+{
+	// A sprite heavy scene, all 40 objects on screen with 
+	// as many lines as possible having the maximum of 10.
+	std::unique_ptr<GBInternal> gb(create());
+	std::mt19937 Random(1);
+
+	for (uint8_t i = 0; i < 40; i++)
+	{
+		gb->RAM[0xFE00 + i * 4 + 0] = 16 + (i % 4) * 36 + Random() % 8;	// Y
+		gb->RAM[0xFE00 + i * 4 + 1] = Random() % 168;					// X
+		gb->RAM[0xFE00 + i * 4 + 2] = Random() % 256;					// Tile
+		gb->RAM[0xFE00 + i * 4 + 3] = Random() % 256;					// Attributes
+	}
+
+	*gb->ppu.LCDC = 0x93;	// LCD, objects and background on
+
+	for (bool Index : { false, true })
+	{
+		gb->ppu.ObjectIndex = Index;
+
+		// OAM is usually copied by DMA once a frame 
+		// so the lists are built again every frame.
+		const int nFrames = 20000;
+		auto t0 = std::chrono::steady_clock::now();
+
+		for (int f = 0; f < nFrames; f++)
+		{
+			gb->ppu.objectsChanged();
+
+			for (uint8_t Line = 0; Line < 18 * 8; Line++)
+			{
+				*gb->ppu.LY = Line;
+				gb->ppu.findObjects();
+			}
+		}
+
+		double t = elapsed(t0);
+
+		std::cout << "[objects] sprite heavy, " << (Index ? "per-line lists: " : "scanning OAM:   ")
+			<< t * 1e9 / (nFrames * 18 * 8) << " ns per line" << std::endl;
+	}
+
+	// The whole system should end up exactly the same either way
+	std::vector<uint8_t> Reference;
+
+	for (bool Index : { false, true })
+	{
+		std::unique_ptr<GBInternal> gb(create());
+		gb->ppu.ObjectIndex = Index;
+		double t = runSystem(gb.get());
+
+		std::vector<uint8_t> State(gb->RAM, gb->RAM + sizeof(gb->RAM));
+		State.insert(State.end(), &gb->ppu.DotMatrix[0][0], &gb->ppu.DotMatrix[0][0] + sizeof(gb->ppu.DotMatrix));
+
+		if (!Index)
+		{
+			Reference = State;
+		}
+
+		std::cout << "[objects] cartridge,    " << (Index ? "per-line lists: " : "scanning OAM:   ")
+			<< nSeconds / t << "x realtime";
+
+		if (Index)
+		{
+			std::cout << ", lists built " << (double)gb->ppu.nObjectIndexBuilds / gb->nFrames << " times a frame"
+				<< (State == Reference ? "" : ", state DIFFERS");
+		}
+
+		std::cout << std::endl;
+	}
+}
+
+void Benchmark::renderThread()
+{
+	uint64_t Reference = 0;
+
+	for (bool Threaded : { false, true })
+	{
+		// Speed with the thread left to catch up on its own
+		std::unique_ptr<GBInternal> gb(create());
+		if (Threaded)
+		{
+			gb->ppu.renderOnThread();
+		}
+
+		auto t0 = std::chrono::steady_clock::now();
+		gb->runUntil((uint64_t)nSeconds * ClockSpeed);
+		if (Threaded)
+		{
+			gb->ppu.renderThread.wait();
+		}
+
+		double t = elapsed(t0);
+
+		// Every frame has to come out the same, so a second run waits 
+		// for the thread to finish each frame and hashes it.
+		gb.reset(create());
+		if (Threaded)
+		{
+			gb->ppu.renderOnThread();
+		}
+
+		uint64_t nCycles = (uint64_t)nSeconds * ClockSpeed;
+		uint64_t Hash = 14695981039346656037ull;
+		uint64_t nFrames = 0;
+
+		while (gb->nClockCycles < nCycles)
+		{
+			gb->runUntil(gb->nClockCycles + 456);
+
+			if (gb->nFrames != nFrames)
+			{
+				nFrames = gb->nFrames;
+
+				if (Threaded)
+				{
+					gb->ppu.renderThread.wait();
+				}
+
+				const uint8_t* Frame = &gb->ppu.DotMatrix[0][0];
+				for (size_t i = 0; i < sizeof(gb->ppu.DotMatrix); i++)
+				{
+					Hash = (Hash ^ Frame[i]) * 1099511628211ull;	// FNV-1a
+				}
+			}
+		}
+
+		if (!Threaded)
+		{
+			Reference = Hash;
+		}
+
+		std::cout << "[renderThread] " << (Threaded ? "render thread:    " : "emulation thread: ")
+			<< nSeconds / t << "x realtime";
+
+		if (Threaded)
+		{
+			gb->ppu.renderThread.wait();
+
+			std::cout << ", " << gb->ppu.renderThread.nStretches << " stretches and " 
+				<< gb->ppu.renderThread.nWrites << " VRAM writes logged"
+				<< (Hash == Reference ? "" : ", frames DIFFER");
+		}
+
+		std::cout << std::endl;
+	}
+}
+
+void Benchmark::postProcess()
+{
+	// A few seconds in so there is something on the screen, coloured 
+	// with the default palette. Every other frame is shifted along a 
+	// pixel so ghosting has something to blend.
+	std::unique_ptr<GBInternal> gb(create());
+	gb->runUntil(2 * ClockSpeed);
+
+	const uint32_t Palette[4] = { 0xFFFFFFFF, 0xAAAAAAFF, 0x555555FF, 0x000000FF };
+	static uint32_t Frames[2][18 * 8][20 * 8];
+
+	for (int y = 0; y < 18 * 8; y++)
+	{
+		for (int x = 0; x < 20 * 8; x++)
+		{
+			Frames[0][y][x] = Palette[gb->ppu.DotMatrix[y][x]];
+			Frames[1][y][x] = Palette[gb->ppu.DotMatrix[y][(x + 1) % (20 * 8)]];
+		}
+	}
+
+	struct Setup
+	{
+		const char* Name;
+		PostProcess::Upscaler upscaler;
+		uint32_t Scale;
+		bool LCDGrid;
+		bool Ghosting;
+	};
+
+	const Setup Setups[] =
+	{
+		{ "2x          ", PostProcess::Integer, 2, false, false },
+		{ "3x          ", PostProcess::Integer, 3, false, false },
+		{ "6x          ", PostProcess::Integer, 6, false, false },
+		{ "6x+grid     ", PostProcess::Integer, 6, true, false },
+		{ "scale2x     ", PostProcess::Scale2x, 1, false, false },
+		{ "scale2x+all ", PostProcess::Scale2x, 1, true, true },
+	};
+
+	const int nRepeats = 200;
+	// At least two threads so splitting into bands is checked
+	uint32_t nThreads = std::max(2u, std::thread::hardware_concurrency());
+
+	for (const Setup& s : Setups)
+	{
+		std::vector<uint32_t> Reference;
+
+		// Plain C++ on one thread first, everything else 
+		// has to come out exactly the same.
+		for (int Run = 0; Run < 3; Run++)
+		{
+			PostProcess p;
+			p.upscaler = s.upscaler;
+			p.Scale = s.Scale;
+			p.LCDGrid = s.LCDGrid;
+			p.Ghosting = s.Ghosting;
+			p.UseSIMD = Run > 0;
+			p.start(Run == 2 ? nThreads : 1);
+
+			const uint32_t* Out = nullptr;
+			for (int i = 0; i < nRepeats; i++)
+			{
+				Out = p.process(&Frames[i % 2][0][0]);
+			}
+
+			std::vector<uint32_t> Result(Out, Out + p.width() * p.height());
+			if (Run == 0)
+			{
+				Reference = Result;
+			}
+
+			std::cout << "[postProcess] " << s.Name << (Run == 0 ? "scalar" : "SSE2  ") << ", " 
+				<< p.threads() << " thread" << (p.threads() == 1 ? ": " : "s:")
+				<< " ghosting " << p.Total.Ghosting / p.nFrames
+				<< " us, upscale " << p.Total.Upscale / p.nFrames
+				<< " us, grid " << p.Total.Grid / p.nFrames << " us a frame"
+				<< (Result == Reference ? "" : ", DIFFERENT from scalar") << std::endl;
+		}
+	}
+}
+
+void Benchmark::audio()
+{
+	// As fast as possible, hashing every sample
+	{
+		std::unique_ptr<GBInternal> gb(create());
+		uint32_t nBlocks = nSeconds * EmulationThread::SampleRate / 512;
+		std::vector<int16_t> Block(512 * 2);
+		uint64_t Hash = 14695981039346656037ull;
+
+		auto t0 = std::chrono::steady_clock::now();
+
+		for (uint32_t i = 0; i < nBlocks; i++)
+		{
+			gb->apu.produce(Block.data(), 512);
+
+			for (int16_t Sample : Block)
+			{
+				Hash = (Hash ^ (uint16_t)Sample) * 1099511628211ull;	// FNV-1a
+			}
+		}
+
+		double t = elapsed(t0);
+
+		std::cout << "[audio] produced " << nBlocks * 512 / (t * 1e6) << " million samples/s ("
+			<< (double)nBlocks * 512 / EmulationThread::SampleRate / t << "x realtime), hash "
+			<< std::hex << Hash << std::dec << std::endl;
+	}
+
+	// Taken out of the queue the way the audio device would for
+	// four seconds, with the device's clock running right on time,
+	// fast and slow. The rate control has to keep the queue near 
+	// its target without running out or overflowing.
+	for (double Drift : { 0.0, 0.003, -0.003 })
+	{
+		std::unique_ptr<GBInternal> gb(create());
+		EmulationThread emulation;
+		emulation.start(gb.get(), true);
+
+		uint32_t CallbackFrames = emulation.callbackFrames();
+		std::vector<int16_t> Block(CallbackFrames * 2);
+		auto Start = std::chrono::steady_clock::now();
+
+		double Period = (double)CallbackFrames / EmulationThread::SampleRate / (1.0 + Drift);
+		uint32_t nCallbacks = (uint32_t)(4.0 / Period);
+
+		for (uint32_t i = 0; i < nCallbacks; i++)
+		{
+			std::this_thread::sleep_until(Start + std::chrono::microseconds((uint64_t)(i * Period * 1e6)));
+
+			// Only the last two seconds count, after it has settled
+			if (i == nCallbacks / 2)
+			{
+				emulation.ring.takeLowestFill();
+			}
+
+			EmulationThread::audioCallback(&emulation, (Uint8*)Block.data(), (int)(Block.size() * sizeof(int16_t)));
+		}
+
+		emulation.stop();
+
+		std::cout << "[audio] device clock " << std::showpos << Drift * 100 << std::noshowpos << "%: " 
+			<< emulation.ring.nUnderruns << " samples missed, " << emulation.ring.nOverruns << " dropped, ratio " 
+			<< std::setprecision(4) << emulation.rateControl.Ratio << std::setprecision(2) << ", queued "
+			<< emulation.rateControl.AverageFill << " (fewest " << emulation.ring.takeLowestFill() << ") of " 
+			<< emulation.TargetFrames << ", " << emulation.rateControl.nSaturated << " updates at the limit" << std::endl;
+	}
+}
+
+void Benchmark::apu()
+{
+	for (bool Stepping : { false, true })
+	{
+		uint64_t Hash[2];
+		double t[2];
+
+		for (bool Lazy : { false, true })
+		{
+			std::unique_ptr<GBInternal> gb(create());
+			gb->Stepping = Stepping;
+			gb->apu.Lazy = Lazy;
+
+			uint32_t nBlocks = nSeconds * APU::SampleRate / 512;
+			std::vector<int16_t> Block(512 * 2);
+			Hash[Lazy] = 14695981039346656037ull;
+
+			auto t0 = std::chrono::steady_clock::now();
+
+			for (uint32_t i = 0; i < nBlocks; i++)
+			{
+				gb->apu.produce(Block.data(), 512);
+
+				for (int16_t Sample : Block)
+				{
+					Hash[Lazy] = (Hash[Lazy] ^ (uint16_t)Sample) * 1099511628211ull;	// FNV-1a
+				}
+			}
+
+			t[Lazy] = elapsed(t0);
+
+			// Emulated seconds actually run
+			double Seconds = (double)gb->nClockCycles / ClockSpeed;
+
+			std::cout << "[apu] " << (Stepping ? "stepping, " : "clocked,  ") << (Lazy ? "lazy:  " : "eager: ")
+				<< t[Lazy] / Seconds * 1000 << " ms per emulated second, channels clocked on " 
+				<< gb->apu.nCyclesClocked / Seconds << " T-cycles and moved " 
+				<< gb->apu.nStepsSkipped / Seconds << " steps at a time per second" << std::endl;
+		}
+
+		// The whole system is the same either way, so the difference
+		// is what clocking the channels on every T-cycle costs.
+		std::cout << "[apu] " << (Stepping ? "stepping" : "clocked") << ": catching up saves " 
+			<< (t[0] - t[1]) / nSeconds * 1000 << " ms per emulated second, samples "
+			<< (Hash[0] == Hash[1] ? "identical" : "DIFFERENT") << std::endl;
+	}
+}
+
+void Benchmark::mixer()
+{
+	std::unique_ptr<GBInternal> gb(create());
+	APU& apu = gb->apu;
+
+	// Channel samples anywhere in their range, mixed with
+	// every combination of panning and volume in turn.
+	std::mt19937 Random(1);
+	for (size_t c = 0; c < APU::nChannels; c++)
+	{
+		for (uint32_t i = 0; i < APU::BlockFrames; i++)
+		{
+			apu.ChannelSamples[c][i] = (int16_t)(Random() % (30 * APU::DACStep + 1)) - 15 * APU::DACStep;
+		}
+	}
+
+	const uint32_t nBlocks = 20000;
+	std::vector<int16_t> Out(APU::BlockFrames * 2);
+	uint64_t Hash[2];
+
+	for (bool SIMD : { false, true })
+	{
+		apu.UseSIMD = SIMD;
+		Hash[SIMD] = 14695981039346656037ull;
+
+		auto t0 = std::chrono::steady_clock::now();
+
+		for (uint32_t b = 0; b < nBlocks; b++)
+		{
+			apu.mixRange(Out.data(), 0, APU::BlockFrames, (uint8_t)(b * 17), (uint8_t)(b * 31));
+
+			// Only some blocks are hashed so it doesn't take longer than mixing
+			if (b % 64 == 0)
+			{
+				for (int16_t Sample : Out)
+				{
+					Hash[SIMD] = (Hash[SIMD] ^ (uint16_t)Sample) * 1099511628211ull;	// FNV-1a
+				}
+			}
+		}
+
+		double t = elapsed(t0);
+
+		std::cout << "[mixer] " << (SIMD ? "SSE2:   " : "scalar: ") << (double)nBlocks * APU::BlockFrames / (t * 1e6)
+			<< " stereo samples per microsecond" << (SIMD && Hash[0] != Hash[1] ? ", DIFFERENT from scalar" : "") << std::endl;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include "GBInternal.hpp"
+#include <string>
+#include <cstdint>
+#include <chrono>
+
+// Runs a cartridge headless (no window or audio device)
+// and reports how fast the emulator runs it. Started with
+// "gbEmu --bench <rom>".
+class Benchmark
+{
+public:
+	Benchmark(std::string gbFilename);
+
+	void run();	// Runs all benchmarks
+
+	void cpu();	// Instruction throughput of the SM83 interpreter
+	void blockCache();	// Interpreter with and without the block cache
+	void jit();	// Interpreter against translated code
+	void stepping();	// Clocking every T-cycle against stepping
+	void halt();	// Skipping over T-cycles spent halted
+	void idleLoops();	// Skipping polling loops
+	void memory();	// Read and write throughput of each memory region
+	void lazyFlags();	// Eager against lazy flags, checking both give the same state
+	void construction();	// Time and memory taken to create an emulator instance
+	void scanlines();	// Speed of the renderer built with and a hash of every frame it drew
+	void tileCache();	// Rendering with and without tiles kept expanded
+	void compositor();	// Pixels composed per nanosecond by each instruction set
+	void frameSkip();	// Throughput when drawing only some frames, checking nothing else changes
+	void objects();	// Finding each line's objects by scanning OAM against per-line lists
+	void renderThread();	// Drawing lines on the emulation thread against another thread
+	void postProcess();	// Time taken by each post-processing stage with and without SSE2 and threads
+	void audio();	// Speed samples are produced at and how the queue copes with real-time playback
+	void apu();	// Cost of the APU clocked every T-cycle against caught up lazily, checking both sound the same
+	void mixer();	// Samples mixed per microsecond with and without SSE2, checking both give the same samples
+
+	// Length of each benchmark in emulated seconds
+	uint32_t nSeconds = 10;
+
+	// The gameboy runs at 4.194304 MHz
+	const uint32_t ClockSpeed = 4194304;
+
+private:
+	std::string gbFilename;
+
+	GBInternal* create();
+
+	// Runs the whole system or only the CPU for
+	// nSeconds of emulated time. Returns the wall time.
+	double runSystem(GBInternal* gb);
+	double runCPU(GBInternal* gb);
+
+	// Millions of accesses per second to the 64 bytes at addr,
+	// with or without the page table.
+	double accessRate(GBInternal* gb, uint16_t addr, bool Write, bool UsePageTable);
+
+	// Seconds elapsed since t0
+	double elapsed(std::chrono::steady_clock::time_point t0);
+};
+
@@ -0,0 +1,134 @@
+#include "BlipBuffer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Band-limited impulse for each phase, which a step of level is
+// spread over. Each phase adds up to exactly 2^15 so the level
+// ends up the same as without band-limiting.
+struct StepKernel
+{
+	int16_t Taps[BlipBuffer::nPhases][BlipBuffer::Width];
+
+	StepKernel()
+	{
+		const double Pi = 3.14159265358979323846;
+
+		// Cut off a little below half the sample rate so
+		// the transition band is mostly above it.
+		const double Cutoff = 0.9;
+
+		for (int p = 0; p < BlipBuffer::nPhases; p++)
+		{
+			double Taken = 0;
+			double Impulse[BlipBuffer::Width];
+
+			for (int k = 0; k < BlipBuffer::Width; k++)
+			{
+				// Distance from the centre of the step,
+				// which is between taps Width / 2 - 1 and Width / 2.
+				double x = k - (BlipBuffer::Width / 2 - 1) - (double)p / BlipBuffer::nPhases;
+
+				double Sinc = x == 0 ? 1.0 : std::sin(Pi * Cutoff * x) / (Pi * Cutoff * x);
+
+				// Blackman window
+				double w = x / BlipBuffer::Width;
+				double Window = 0.42 + 0.5 * std::cos(2 * Pi * w) + 0.08 * std::cos(4 * Pi * w);
+
+				Impulse[k] = Cutoff * Sinc * Window;
+				Taken += Impulse[k];
+			}
+
+			// The rounding error goes to the largest tap
+			int Sum = 0;
+			for (int k = 0; k < BlipBuffer::Width; k++)
+			{
+				Taps[p][k] = (int16_t)std::lround(Impulse[k] / Taken * (1 << 15));
+				Sum += Taps[p][k];
+			}
+
+			int Centre = p < BlipBuffer::nPhases / 2 ? BlipBuffer::Width / 2 - 1 : BlipBuffer::Width / 2;
+			Taps[p][Centre] += (1 << 15) - Sum;
+		}
+	}
+};
+
+static const StepKernel Kernel;
+
+BlipBuffer::BlipBuffer(uint32_t ClockRate, uint32_t SampleRate, uint32_t Capacity)
+{
+	Deltas.assign(Capacity + Width, 0);
+	setRate((double)SampleRate / ClockRate, 0);
+}
+
+double BlipBuffer::rate()
+{
+	return Factor / 4294967296.0;
+}
+
+void BlipBuffer::setRate(double SamplesPerCycle, uint64_t Now)
+{
+	OriginPos = position(Now);
+	Origin = Now;
+
+	Factor = (uint64_t)(SamplesPerCycle * 4294967296.0 + 0.5);
+}
+
+uint64_t BlipBuffer::position(uint64_t Time)
+{
+	return OriginPos + (Time - Origin) * Factor;
+}
+
+void BlipBuffer::addDelta(uint64_t Time, int32_t Delta)
+{
+	uint64_t Position = position(Time);
+	uint32_t Sample = (uint32_t)(Position >> 32);
+	uint32_t Phase = (uint32_t)(Position >> (32 - PhaseBits)) & (nPhases - 1);
+
+	// Only happens if nothing has been read for too long
+	if (Sample + Width > Deltas.size())
+	{
+		return;
+	}
+
+	int32_t* Out = Deltas.data() + Sample;
+	const int16_t* Taps = Kernel.Taps[Phase];
+
+	for (int k = 0; k < Width; k++)
+	{
+		Out[k] += Delta * Taps[k];
+	}
+}
+
+uint32_t BlipBuffer::available(uint64_t Time)
+{
+	return (uint32_t)(position(Time) >> 32);
+}
+
+uint32_t BlipBuffer::capacity()
+{
+	return (uint32_t)Deltas.size() - Width;
+}
+
+void BlipBuffer::read(int16_t* Out, uint32_t nSamples, uint32_t Stride)
+{
+	for (uint32_t i = 0; i < nSamples; i++)
+	{
+		Level += Deltas[i];
+
+		int32_t Sample = Level >> 15;
+		Out[i * Stride] = (int16_t)std::max(-32768, std::min(32767, Sample));
+
+		if (BassShift != 0)
+		{
+			Level -= Level >> BassShift;
+		}
+	}
+
+	// The rest move to the front
+	uint32_t Left = (uint32_t)Deltas.size() - nSamples;
+	memmove(Deltas.data(), Deltas.data() + nSamples, Left * sizeof(int32_t));
+	memset(Deltas.data() + Left, 0, nSamples * sizeof(int32_t));
+
+	OriginPos -= (uint64_t)nSamples << 32;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Turns a signal which only ever steps between levels into samples
+/// without aliasing. Instead of taking the level once per sample,
+/// every step is recorded at the T-cycle it happens on as a change
+/// in level. Each change is spread over the samples around it with
+/// a band-limited step (BLEP), the shape a step takes once
+/// everything above half the sample rate has been filtered out. The
+/// samples themselves are the running sum of the changes, worked
+/// out for a whole block at a time when they're read. The channels
+/// therefore only have to report when their output changes.
+/// </summary>
+class BlipBuffer
+{
+public:
+	// Rate of the T-cycles changes are timed in and of the samples
+	// read out. Up to Capacity samples can be waiting to be read.
+	BlipBuffer(uint32_t ClockRate = 4194304, uint32_t SampleRate = 44100, uint32_t Capacity = 1 << 12);
+
+	// Adds Delta to the level from T-cycle Time onwards. Changes
+	// must be added in order and after the samples already read.
+	void addDelta(uint64_t Time, int32_t Delta);
+
+	// Samples which are complete once every change before
+	// T-cycle Time has been added.
+	uint32_t available(uint64_t Time);
+
+	// Removes nSamples complete samples, writing them to every
+	// Stride'th element of Out.
+	void read(int16_t* Out, uint32_t nSamples, uint32_t Stride = 1);
+
+	// Samples which can be waiting to be read
+	uint32_t capacity();
+
+	// When not 0 the level loses 1/2^BassShift of itself every 
+	// sample, a first-order high-pass which takes out any DC 
+	// offset. The cut-off is SampleRate / (2pi * 2^BassShift).
+	int BassShift = 0;
+
+	// Samples per T-cycle. Changing it only affects
+	// changes from T-cycle Now onwards.
+	double rate();
+	void setRate(double SamplesPerCycle, uint64_t Now);
+
+	// Width of a band-limited step in samples, the middle
+	// of it comes Width / 2 samples after the change.
+	static const int Width = 16;
+
+	// Steps are placed to 1/nPhases of a sample
+	static const int PhaseBits = 6;
+	static const int nPhases = 1 << PhaseBits;
+
+private:
+	// Changes in level, each scaled by 2^15
+	std::vector<int32_t> Deltas;
+
+	// Samples per T-cycle in 32.32 fixed point
+	uint64_t Factor;
+
+	// Position of T-cycle Origin in the buffer, 32.32 fixed point.
+	// Positions wrap around like the T-cycles, only the difference
+	// between them and the start of the buffer matters.
+	uint64_t Origin = 0;
+	uint64_t OriginPos = 0;
+
+	// Running sum of the changes read so far
+	int32_t Level = 0;
+
+	// Position of T-cycle Time in the buffer in 32.32 fixed point
+	uint64_t position(uint64_t Time);
+};
\ No newline at end of file
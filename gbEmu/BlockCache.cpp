@@ -0,0 +1,259 @@
+#include "BlockCache.hpp"
+#include "GBInternal.hpp"
+
+// Length in bytes of each instruction. STOP is treated as a
+// single byte instruction to match the interpreter.
+const uint8_t BlockCache::Length[256] = {
+//	x0 x1 x2 x3 x4 x5 x6 x7 x8 x9 xA xB xC xD xE xF
+	1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1,	// 0x
+	1, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,	// 1x
+	2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,	// 2x
+	2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,	// 3x
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 4x
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 5x
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 6x
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 7x
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 8x
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 9x
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// Ax
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// Bx
+	1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1,	// Cx
+	1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 1, 2, 1,	// Dx
+	2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,	// Ex
+	2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,	// Fx
+};
+
+void BlockCache::connectGB(GBInternal* gb)
+{
+	this->gb = gb;
+}
+
+bool BlockCache::endsBlock(uint8_t opcode)
+{
+	// Conditional jumps don't end a block, if the jump
+	// isn't taken execution carries on within the block.
+	switch (opcode)
+	{
+	case 0xC3:	// JP nn
+	case 0xE9:	// JP (HL)
+	case 0x18:	// JR e
+	case 0xCD:	// CALL nn
+	case 0xC9:	// RET
+	case 0xD9:	// RETI
+	case 0xC7: case 0xCF: case 0xD7: case 0xDF:	// RST t
+	case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+	case 0x76:	// HALT
+	case 0x10:	// STOP
+	case 0xD3: case 0xDB: case 0xDD: case 0xE3:	// Illegal
+	case 0xE4: case 0xEB: case 0xEC: case 0xED:
+	case 0xF4: case 0xFC: case 0xFD:
+		return true;
+	default:
+		return false;
+	}
+}
+
+uint32_t BlockCache::regionEnd(uint16_t addr)
+{
+	if (addr < 0x4000)	// ROM bank 0
+	{
+		return 0x4000;
+	}
+	else if (addr < 0x8000)	// Switchable ROM bank
+	{
+		return 0x8000;
+	}
+	else if (addr >= 0xC000 && addr < 0xE000)	// WRAM
+	{
+		return 0xE000;
+	}
+	else if (addr >= 0xFF80 && addr < 0xFFFF)	// HRAM
+	{
+		return 0xFFFF;
+	}
+
+	// VRAM, cartridge RAM, echo RAM, OAM and
+	// IO registers are never cached.
+	return 0;
+}
+
+BlockCache::MicroOp* BlockCache::fetch(uint16_t PC)
+{
+	// During a DMA transfer the CPU reads 0xFF from
+	// everything outside HRAM, let the interpreter
+	// deal with it.
+	if (!Enabled || gb->dma.DMAinProgress)
+	{
+		nUncached++;
+		return nullptr;
+	}
+
+	// Carry on within the current block
+	if (CurrentBlock != nullptr && CurrentIndex < CurrentBlock->Ops.size())
+	{
+		MicroOp& op = CurrentBlock->Ops[CurrentIndex];
+
+		if (op.PC == PC && CurrentBlock->Generation == Generation[PC >> 8])
+		{
+			CurrentIndex++;
+			nHits++;
+			return &op;
+		}
+	}
+
+	// Jumped somewhere else, find the block starting at PC
+	if (regionEnd(PC) == 0)
+	{
+		CurrentBlock = nullptr;
+		nUncached++;
+		return nullptr;
+	}
+
+	uint32_t key = PC;
+	if (PC < 0x8000)
+	{
+		key |= gb->cart->mbc->ROMBank(PC) << 16;
+	}
+
+	Block* block;
+	if (CurrentBlock != nullptr && CurrentBlock->LinkKey == key)
+	{
+		block = CurrentBlock->Link;
+	}
+	else
+	{
+		block = &Blocks[key];
+
+		if (CurrentBlock != nullptr)
+		{
+			CurrentBlock->Link = block;
+			CurrentBlock->LinkKey = key;
+		}
+	}
+
+	if (block->Ops.empty() || block->Generation != Generation[PC >> 8])
+	{
+		decode(*block, PC);
+
+		if (block->Ops.empty())
+		{
+			// First instruction is split across two pages
+			CurrentBlock = nullptr;
+			nUncached++;
+			return nullptr;
+		}
+
+		nMisses++;
+	}
+	else
+	{
+		nHits++;
+	}
+
+	CurrentBlock = block;
+	CurrentIndex = 1;
+
+	return &block->Ops[0];
+}
+
+void BlockCache::decode(Block& block, uint16_t PC)
+{
+	uint8_t Page = PC >> 8;
+	uint32_t End = regionEnd(PC);
+
+	// Blocks never leave the page they start in so a
+	// block only needs to know about a single generation.
+	if (((uint32_t)Page + 1) << 8 < End)
+	{
+		End = ((uint32_t)Page + 1) << 8;
+	}
+
+	block.Ops.clear();
+	block.Generation = Generation[Page];
+
+	uint32_t addr = PC;
+	while (addr < End)
+	{
+		MicroOp op;
+		op.PC = addr;
+		op.Opcode = gb->read(addr);
+		op.Length = Length[op.Opcode];
+
+		if (addr + op.Length > End)
+		{
+			break;
+		}
+
+		switch (op.Length)
+		{
+		case 1:
+			op.Operand = 0;
+			break;
+		case 2:
+			op.Operand = gb->read(addr + 1);
+			break;
+		case 3:
+			op.Operand = gb->read(addr + 1) | (gb->read(addr + 2) << 8);
+			break;
+		}
+
+		block.Ops.push_back(op);
+		addr += op.Length;
+
+		if (endsBlock(op.Opcode))
+		{
+			break;
+		}
+	}
+
+	if (PC >= 0xC000 && !block.Ops.empty() && !CodePage[Page])
+	{
+		CodePage[Page] = true;
+		gb->mapPage(Page);
+	}
+}
+
+uint32_t BlockCache::remaining()
+{
+	return CurrentBlock == nullptr ? 0 : CurrentBlock->Ops.size() - CurrentIndex;
+}
+
+void BlockCache::skip(uint32_t nOps)
+{
+	CurrentIndex += nOps;
+}
+
+void BlockCache::invalidate(uint16_t addr)
+{
+	// Writes to echo RAM end up in WRAM
+	if (addr >= 0xE000 && addr <= 0xFE00)
+	{
+		addr = 0xC000 + (addr % 0xE000);
+	}
+	else if (addr >= 0xFE00 && addr < 0xFF80)
+	{
+		// OAM and IO registers
+		return;
+	}
+
+	if (CodePage[addr >> 8])
+	{
+		Generation[addr >> 8]++;
+		CodePage[addr >> 8] = false;
+		gb->mapPage(addr >> 8);
+	}
+}
+
+void BlockCache::bankSwitch()
+{
+	// Blocks from other banks are still valid since
+	// ROM can't change, only the mapping has.
+	CurrentBlock = nullptr;
+}
+
+double BlockCache::hitRate()
+{
+	uint64_t nFetches = nHits + nMisses + nUncached;
+
+	return nFetches == 0 ? 0.0 : (double)nHits / nFetches;
+}
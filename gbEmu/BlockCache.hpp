@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+class GBInternal;
+struct JITRun;
+
+/// <summary>
+/// Caches decoded runs of straight-line SM83 code so the
+/// opcode and immediate bytes of an instruction don't need
+/// to be fetched through GBInternal::read every time it
+/// executes. Blocks are keyed on the ROM bank and PC of their
+/// first instruction and end at an unconditional jump or at a
+/// page (256 byte) boundary. Only code in ROM, WRAM and HRAM
+/// is cached, everything else is left to the interpreter.
+/// Writes to WRAM/HRAM pages which hold cached code invalidate
+/// every block in that page and writes to the MBC registers
+/// drop the block currently being executed since the bank it
+/// was decoded from may have been switched out.
+/// </summary>
+class BlockCache
+{
+public:
+	GBInternal* gb;
+
+	void connectGB(GBInternal* gb);
+
+	// A single pre-decoded instruction
+	struct MicroOp
+	{
+		uint16_t PC;		// Address of the opcode
+		uint16_t Operand;	// Immediate data (n, nn, e or the opcode after 0xCB)
+		uint8_t Opcode;
+		uint8_t Length;		// In bytes, including the opcode
+
+		// Translated code starting at this instruction and
+		// how often it has run, used by the JIT.
+		JITRun* Native = nullptr;
+		uint8_t Heat = 0;
+	};
+
+	// Returns the decoded instruction at PC or nullptr
+	// if the instruction must be fetched by the interpreter.
+	MicroOp* fetch(uint16_t PC);
+
+	// Number of instructions in the current block
+	// after the one which was just fetched.
+	uint32_t remaining();
+
+	// Moves past instructions which were executed
+	// without being fetched.
+	void skip(uint32_t nOps);
+
+	// Called on every write to 0xC000-0xFFFF
+	void invalidate(uint16_t addr);
+
+	// Called on every write to the MBC registers (0x0000-0x7FFF)
+	void bankSwitch();
+
+	// Whether a WRAM/HRAM page has cached code in it. 
+	// Writes to it must go through invalidate().
+	bool hasCode(uint8_t Page) { return CodePage[Page]; }
+
+	bool Enabled = true;
+
+	// Instructions fetched from an already decoded block,
+	// instructions which required decoding a block and
+	// instructions which couldn't be cached at all.
+	uint64_t nHits = 0, nMisses = 0, nUncached = 0;
+
+	double hitRate();
+
+private:
+	struct Block
+	{
+		uint32_t Generation = 0;
+		std::vector<MicroOp> Ops;
+
+		// Block which was executed after this one last
+		// time, saves a hash lookup in tight loops.
+		Block* Link = nullptr;
+		uint32_t LinkKey = 0xFFFFFFFF;
+	};
+
+	std::unordered_map<uint32_t, Block> Blocks;
+
+	// Block currently being executed and the
+	// index of the next instruction in it.
+	Block* CurrentBlock = nullptr;
+	uint32_t CurrentIndex = 0;
+
+	// Each 256 byte page has a generation which is incremented
+	// when code in it is overwritten. Blocks decoded with an
+	// older generation are stale and are decoded again.
+	uint32_t Generation[256] = { 0 };
+
+	// Whether a WRAM/HRAM page has cached code in it
+	bool CodePage[256] = { false };
+
+	void decode(Block& block, uint16_t PC);
+
+	// Returns the end (exclusive) of the cacheable memory
+	// region containing addr or 0 if it isn't cacheable.
+	uint32_t regionEnd(uint16_t addr);
+
+	static const uint8_t Length[256];
+	static bool endsBlock(uint8_t opcode);
+};
@@ -0,0 +1,213 @@
+#include "Compositor.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COMPOSITOR_X86 1
+#else
+#define COMPOSITOR_X86 0
+#endif
+
+#if COMPOSITOR_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+// GCC and Clang only allow the intrinsics in functions
+// compiled for an instruction set which includes them.
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+Compositor::Compositor()
+{
+	if (!use(AVX2))
+	{
+		use(SSE2);
+	}
+}
+
+bool Compositor::supported(Kind k)
+{
+	switch (k)
+	{
+	case Scalar:
+		return true;
+#if COMPOSITOR_X86
+#ifdef _MSC_VER
+	case SSE2:
+	{
+		int Info[4];
+		__cpuid(Info, 1);
+		return (Info[3] & (1 << 26)) != 0;
+	}
+	case AVX2:
+	{
+		int Info[4];
+		__cpuid(Info, 0);
+		if (Info[0] < 7)
+		{
+			return false;
+		}
+
+		// The OS also has to save the upper half
+		// of the YMM registers on a context switch.
+		__cpuid(Info, 1);
+		if ((Info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(Info, 7, 0);
+		return (Info[1] & (1 << 5)) != 0;
+	}
+#else
+	case SSE2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("sse2");
+	case AVX2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+#endif
+	default:
+		return false;
+	}
+}
+
+bool Compositor::use(Kind k)
+{
+	if (!supported(k))
+	{
+		return false;
+	}
+
+	Current = k;
+	return true;
+}
+
+const char* Compositor::name()
+{
+	switch (Current)
+	{
+	case SSE2:
+		return "SSE2";
+	case AVX2:
+		return "AVX2";
+	default:
+		return "Scalar";
+	}
+}
+
+static void composeScalar(const Compositor::Layers& Line, const uint8_t BGShades[4], const uint8_t ObjectShades[8],
+	int First, int Last, uint8_t* Out)
+{
+	for (int x = First; x < Last; x++)
+	{
+		// Index 0 of an object is always transparent and objects
+		// with priority are only drawn over background colour 0.
+		bool ObjectDrawn = (Line.Object[x] & 0b11) != 0 && (!Line.Priority[x] || Line.BG[x] == 0);
+		Out[x] = ObjectDrawn ? ObjectShades[Line.Object[x]] : BGShades[Line.BG[x]];
+	}
+}
+
+#if COMPOSITOR_X86
+// Each returns the first pixel it didn't draw,
+// the rest are left to composeScalar().
+
+TARGET_SSE2 static int composeSSE2(const Compositor::Layers& Line, const uint8_t BGShades[4], const uint8_t ObjectShades[8],
+	int First, int Last, uint8_t* Out)
+{
+	const __m128i Zero = _mm_setzero_si128();
+	const __m128i Three = _mm_set1_epi8(3);
+
+	int x = First;
+	for (; x + 16 <= Last; x += 16)
+	{
+		__m128i BG = _mm_loadu_si128((const __m128i*)(Line.BG + x));
+		__m128i Obj = _mm_loadu_si128((const __m128i*)(Line.Object + x));
+		__m128i Prio = _mm_loadu_si128((const __m128i*)(Line.Priority + x));
+
+		// SSE2 has no byte shuffle so the palettes are looked up
+		// by comparing against every index.
+		__m128i BGShade = _mm_set1_epi8(BGShades[0]);
+		for (int i = 1; i < 4; i++)
+		{
+			__m128i Match = _mm_cmpeq_epi8(BG, _mm_set1_epi8(i));
+			BGShade = _mm_or_si128(_mm_and_si128(Match, _mm_set1_epi8(BGShades[i])), _mm_andnot_si128(Match, BGShade));
+		}
+
+		__m128i ObjShade = _mm_set1_epi8(ObjectShades[0]);
+		for (int i = 1; i < 8; i++)
+		{
+			__m128i Match = _mm_cmpeq_epi8(Obj, _mm_set1_epi8(i));
+			ObjShade = _mm_or_si128(_mm_and_si128(Match, _mm_set1_epi8(ObjectShades[i])), _mm_andnot_si128(Match, ObjShade));
+		}
+
+		__m128i Transparent = _mm_cmpeq_epi8(_mm_and_si128(Obj, Three), Zero);
+		__m128i Behind = _mm_andnot_si128(_mm_cmpeq_epi8(BG, Zero), Prio);
+		__m128i UseBG = _mm_or_si128(Transparent, Behind);
+		__m128i Value = _mm_or_si128(_mm_and_si128(UseBG, BGShade), _mm_andnot_si128(UseBG, ObjShade));
+
+		_mm_storeu_si128((__m128i*)(Out + x), Value);
+	}
+
+	return x;
+}
+
+TARGET_AVX2 static int composeAVX2(const Compositor::Layers& Line, const uint8_t BGShades[4], const uint8_t ObjectShades[8],
+	int First, int Last, uint8_t* Out)
+{
+	// The palettes fit in a single byte shuffle
+	uint8_t BGTable[16] = { 0 }, ObjectTable[16] = { 0 };
+	memcpy(BGTable, BGShades, 4);
+	memcpy(ObjectTable, ObjectShades, 8);
+
+	const __m256i BGLUT = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)BGTable));
+	const __m256i ObjectLUT = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)ObjectTable));
+	const __m256i Zero = _mm256_setzero_si256();
+	const __m256i Three = _mm256_set1_epi8(3);
+
+	int x = First;
+	for (; x + 32 <= Last; x += 32)
+	{
+		__m256i BG = _mm256_loadu_si256((const __m256i*)(Line.BG + x));
+		__m256i Obj = _mm256_loadu_si256((const __m256i*)(Line.Object + x));
+		__m256i Prio = _mm256_loadu_si256((const __m256i*)(Line.Priority + x));
+
+		__m256i BGShade = _mm256_shuffle_epi8(BGLUT, BG);
+		__m256i ObjShade = _mm256_shuffle_epi8(ObjectLUT, Obj);
+
+		__m256i Transparent = _mm256_cmpeq_epi8(_mm256_and_si256(Obj, Three), Zero);
+		__m256i Behind = _mm256_andnot_si256(_mm256_cmpeq_epi8(BG, Zero), Prio);
+		__m256i Value = _mm256_blendv_epi8(ObjShade, BGShade, _mm256_or_si256(Transparent, Behind));
+
+		_mm256_storeu_si256((__m256i*)(Out + x), Value);
+	}
+
+	return x;
+}
+#endif
+
+void Compositor::compose(const Layers& Line, const uint8_t BGShades[4], const uint8_t ObjectShades[8],
+	int First, int Last, uint8_t* Out)
+{
+#if COMPOSITOR_X86
+	switch (Current)
+	{
+	case AVX2:
+		// AVX2 stops short of a full 32, SSE2 takes the next 16 of what's left
+		First = composeAVX2(Line, BGShades, ObjectShades, First, Last, Out);
+		// fall through
+	case SSE2:
+		First = composeSSE2(Line, BGShades, ObjectShades, First, Last, Out);
+		break;
+	default:
+		break;
+	}
+#endif
+
+	composeScalar(Line, BGShades, ObjectShades, First, Last, Out);
+}
\ No newline at end of file
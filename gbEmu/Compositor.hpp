@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+
+/// <summary>
+/// Combines the background/window and object layers of a line into
+/// the final shades. For each pixel it maps the colour indices
+/// through the palettes and decides whether the object or the
+/// background is drawn. The same thing is done with SSE2 on 16
+/// pixels or AVX2 on 32 pixels at a time, the widest one the CPU
+/// supports is picked when constructed. All of them produce
+/// exactly the same pixels.
+/// </summary>
+class Compositor
+{
+public:
+	Compositor();
+
+	enum Kind { Scalar, SSE2, AVX2 };
+
+	// What each layer has at every pixel of a line
+	struct Layers
+	{
+		uint8_t BG[20 * 8];			// Colour index (0-3) of the background or window
+		uint8_t Object[20 * 8];		// Palette * 4 + colour index of the object, 0 if none
+		uint8_t Priority[20 * 8];	// 0xFF if the object is behind background colours 1-3
+	};
+
+	// Writes the shades of pixels First up to Last (exclusive) of the
+	// line to Out. BGShades holds the shade of the 4 background colours
+	// and ObjectShades those of OBP0 followed by OBP1.
+	void compose(const Layers& Line, const uint8_t BGShades[4], const uint8_t ObjectShades[8],
+		int First, int Last, uint8_t* Out);
+
+	Kind kind() { return Current; }
+	const char* name();
+
+	// Whether this CPU can run the given kind
+	static bool supported(Kind k);
+
+	// Switches to another kind, returns false if it isn't supported
+	bool use(Kind k);
+
+private:
+	Kind Current = Scalar;
+};
\ No newline at end of file
@@ -8,39 +8,52 @@ void DMA::connectGB(GBInternal* gb)
 	DMAReg = gb->RAM + 0xFF46;
 }
 
+void DMA::start()
+{
+	DMAinProgress = true;
+	gb->mapMemory();
+
+	// The transfer begins on this T-cycle
+	gb->scheduler.schedule(Scheduler::DMATransfer, gb->nClockCycles);
+	Copied = false;
+}
+
 void DMA::clock()
 {
-	// Check if DMA is active
-	if (DMAinProgress)
-	{
-		// Check if this is the first cycle.
-		// If so then set a count down for how
-		// long the transfer should take in T-cycles.
-		if (TransferTicks == 0xFFFF)
-		{
-			TransferTicks = 640;
+	// OAM and whether the PPU can read it are about to change,
+	// the PPU has already been clocked on this T-cycle.
+	gb->ppu.lineChanged(gb->nClockCycles + 1);
 
-			// Although the transfer happens gradually,
-			// we will have it happen all at once and 
-			// nothing will be done in the remaining cycles.
-			uint16_t StartAddr = *DMAReg << 8;
+	// Check if this is the first cycle.
+	// If so then schedule the end of the 
+	// transfer.
+	if (!Copied)
+	{
+		Copied = true;
+		gb->scheduler.schedule(Scheduler::DMATransfer, gb->nClockCycles + TransferTicks);
 
-			for (uint16_t i = 0; i < 0x100; i++) 
-			{
-				gb->RAM[0xFE00 + i] = gb->RAM[StartAddr + i];
-			}
-		}
+		// Although the transfer happens gradually,
+		// we will have it happen all at once and 
+		// nothing will be done in the remaining cycles.
+		uint16_t StartAddr = *DMAReg << 8;
 
-		// End of transfer
-		if (TransferTicks == 0)
+		// Echo RAM is only kept up to date in WRAM
+		if (StartAddr >= 0xE000 && StartAddr < 0xFE00)
 		{
-			TransferTicks = 0xFFFF;
-			DMAinProgress = false;
+			StartAddr -= 0x2000;
 		}
-		else
+
+		for (uint16_t i = 0; i < 0x100; i++) 
 		{
-			TransferTicks--;
+			gb->RAM[0xFE00 + i] = gb->RAM[StartAddr + i];
 		}
-	}
 
+		gb->ppu.objectsChanged();
+	}
+	else
+	{
+		// End of transfer
+		DMAinProgress = false;
+		gb->mapMemory();
+	}
 }
\ No newline at end of file
@@ -18,13 +18,21 @@ public:
 	GBInternal* gb;
 
 	void connectGB(GBInternal* gb);
+
+	// Called when the CPU writes to the DMA register
+	void start();
+
+	// Called by the scheduler when the transfer
+	// starts and again when it ends.
 	void clock();
 
 	uint8_t* DMAReg;
 	bool DMAinProgress = false;
 
-	uint16_t TransferTicks = 0xFFFF;
+	// Length of the transfer in T-cycles
+	const static uint16_t TransferTicks = 640;
 
 private:
-
+	// Set once the data has been copied
+	bool Copied = false;
 };
\ No newline at end of file
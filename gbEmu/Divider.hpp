@@ -27,6 +27,26 @@ public:
 
 		return false;
 	}
+
+	// Number of ticks up to and including the next overflow
+	uint32_t untilOverflow()
+	{
+		// The counter wraps around if it was reloaded above MaxValue
+		return (T)(MaxValue - Counter) + 1;
+	}
+
+	// Same as calling clock() nTicks times
+	void advance(uint64_t nTicks)
+	{
+		while (nTicks >= untilOverflow())
+		{
+			nTicks -= untilOverflow();
+			Counter = *ResetValue;
+			nOverflows++;
+		}
+
+		Counter += (T)nTicks;
+	}
 	
 	// Keeps track of number of overflows
 	uint64_t nOverflows;
@@ -0,0 +1,148 @@
+#include "EmulationThread.hpp"
+#include "GBInternal.hpp"
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+EmulationThread::~EmulationThread()
+{
+	stop();
+}
+
+void EmulationThread::start(GBInternal* gb, bool AudioDevice)
+{
+	stop();
+
+	this->gb = gb;
+	this->AudioDevice = AudioDevice;
+	rateControl.reset(TargetFrames);
+
+	// The queue is filled up to the target before the audio 
+	// device can ask for anything, then kept there by the thread.
+	if (AudioDevice)
+	{
+		std::vector<int16_t> Block(TargetFrames * 2);
+		gb->apu.produce(Block.data(), TargetFrames);
+		ring.push(Block.data(), TargetFrames);
+	}
+
+	Running = true;
+	Worker = std::thread(&EmulationThread::run, this);
+}
+
+void EmulationThread::stop()
+{
+	if (!Worker.joinable())
+	{
+		return;
+	}
+
+	Running = false;
+	Worker.join();
+}
+
+void EmulationThread::setLatency(uint32_t Milliseconds)
+{
+	uint64_t Frames = (uint64_t)Milliseconds * SampleRate / 1000;
+	uint32_t Fewest = MinCallbackFrames * 2;
+	uint32_t Most = ring.capacity() / 2;
+
+	TargetFrames = Frames < Fewest ? Fewest : Frames > Most ? Most : (uint32_t)Frames;
+}
+
+uint16_t EmulationThread::callbackFrames()
+{
+	uint16_t Frames = MinCallbackFrames;
+	while (Frames * 4 <= TargetFrames && Frames < 4096)
+	{
+		Frames *= 2;
+	}
+
+	return Frames;
+}
+
+void EmulationThread::run()
+{
+	// Enough for a slice run at the fastest rate
+	std::vector<int16_t> Block(1024 * 2);
+
+	// Emulated time since Start keeps up with the clock since t0
+	auto t0 = std::chrono::steady_clock::now();
+	uint64_t Start = gb->nClockCycles;
+
+	auto LastUpdate = t0;
+	auto LastLog = t0;
+
+	while (Running)
+	{
+		auto Now = std::chrono::steady_clock::now();
+		std::chrono::duration<double> t = Now - t0;
+		uint64_t Target = Start + (uint64_t)(t.count() * APU::ClockSpeed);
+
+		if (gb->nClockCycles >= Target)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		// Carries on from here after a hold-up instead of racing to
+		// catch up, which would overfill the queue, only running 
+		// ahead by what's needed to fill it back up to the target.
+		if (Target - gb->nClockCycles > MaxBehind)
+		{
+			uint32_t Missing = AudioDevice ? TargetFrames - std::min(ring.size(), TargetFrames) : 0;
+
+			t0 = Now;
+			Start = gb->nClockCycles + (uint64_t)Missing * APU::ClockSpeed / SampleRate;
+			Target = Start;
+		}
+
+		gb->runUntil(std::min<uint64_t>(Target, gb->nClockCycles + SliceCycles));
+
+		uint32_t n = gb->apu.take(Block.data(), (uint32_t)Block.size() / 2);
+
+		if (!AudioDevice)
+		{
+			continue;
+		}
+
+		ring.push(Block.data(), n);
+
+		std::chrono::duration<double> Elapsed = Now - LastUpdate;
+		LastUpdate = Now;
+		gb->apu.setRatio(rateControl.update(ring.size(), Elapsed.count()));
+
+		if (Log && Now - LastLog >= std::chrono::seconds(1))
+		{
+			LastLog = Now;
+
+			std::cout << "[audio] ratio " << rateControl.Ratio << ", queued " << rateControl.AverageFill 
+				<< " of " << rateControl.Target << ", " << ring.nUnderruns << " samples missed, " 
+				<< ring.nOverruns << " dropped" << std::endl;
+		}
+	}
+}
+
+void EmulationThread::audioCallback(void* userdata, Uint8* stream, int len)
+{
+	EmulationThread* emulation = static_cast<EmulationThread*>(userdata);
+
+	int16_t* Frames = reinterpret_cast<int16_t*>(stream);
+	uint32_t nFrames = len / (2 * sizeof(int16_t));
+
+	uint32_t n = emulation->ring.pop(Frames, nFrames);
+
+	if (n > 0)
+	{
+		emulation->Last[0] = Frames[n * 2 - 2];
+		emulation->Last[1] = Frames[n * 2 - 1];
+	}
+
+	for (uint32_t i = n; i < nFrames; i++)
+	{
+		Frames[i * 2] = emulation->Last[0];
+		Frames[i * 2 + 1] = emulation->Last[1];
+	}
+}
\ No newline at end of file
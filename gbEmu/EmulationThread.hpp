@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include "SDL.h"
+#include "AudioRing.hpp"
+#include "RateControl.hpp"
+#include "APU.hpp"
+
+class GBInternal;
+
+/// <summary>
+/// Runs the emulator on its own thread, a millisecond at a time.
+/// Samples are queued in an AudioRing which the SDL audio callback
+/// only copies out of, so it no longer has to run the whole system
+/// within its deadline and a slow frame only eats into what's 
+/// queued. The emulator keeps to real time by the system clock, the
+/// same one the frames are shown by, running TargetFrames samples 
+/// ahead of it so that many are queued. The audio device plays them
+/// by its own clock, RateControl makes up the difference by changing
+/// how many samples are made per T-cycle.
+/// </summary>
+class EmulationThread
+{
+public:
+	~EmulationThread();
+
+	// Starts running gb, queuing samples if there's an audio device
+	void start(GBInternal* gb, bool AudioDevice);
+
+	// Waits for the slice being run to finish. The GBInternal
+	// can be changed or deleted after this returns.
+	void stop();
+
+	AudioRing ring;
+	RateControl rateControl;
+
+	// Stereo samples kept queued (20ms), set by setLatency()
+	uint32_t TargetFrames = 882;
+
+	// Sets TargetFrames from a latency in milliseconds, call before
+	// start(). It's kept to at least two of the smallest callbacks
+	// and at most half the ring, so there's room left to fill it up.
+	void setLatency(uint32_t Milliseconds);
+
+	// Stereo samples for the audio device to ask for at a time, at
+	// most half of TargetFrames so it never empties the queue.
+	uint16_t callbackFrames();
+	static const uint16_t MinCallbackFrames = 64;
+
+	// T-cycles run at a time (1ms)
+	uint32_t SliceCycles = APU::ClockSpeed / 1000;
+
+	// Time lost to a hold-up longer than this (in T-cycles, 100ms)
+	// isn't made up for, the emulator carries on from where it was.
+	uint32_t MaxBehind = APU::ClockSpeed / 10;
+
+	// Prints the rate control's state every second
+	bool Log = false;
+
+	// Output rate of the APU
+	static const uint32_t SampleRate = APU::SampleRate;
+
+	// SDL audio callback, userdata is the EmulationThread. Missing
+	// samples are filled in with the last one so they don't click.
+	static void audioCallback(void* userdata, Uint8* stream, int len);
+
+private:
+	GBInternal* gb = nullptr;
+	bool AudioDevice = true;
+
+	std::thread Worker;
+	std::atomic<bool> Running{ false };
+
+	// Last sample given to the audio device
+	int16_t Last[2] = { 0, 0 };
+
+	void run();
+};
\ No newline at end of file
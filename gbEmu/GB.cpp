@@ -1,6 +1,5 @@
 #include "GB.hpp"
-#include <chrono>
-#include <thread>
+#include <algorithm>
 
 GB::GB(std::string gbFilename) : gbInternal(nullptr)
 {
@@ -20,9 +19,54 @@ GB::GB() : gbInternal(nullptr)
 	gameLoop();
 }
 
+GB::GB(Settings settings) : gbInternal(nullptr), settings(settings)
+{
+	createWindow();
+
+	// ============== Start Game Loop ==============
+	gameLoop();
+}
+
+void GB::applySettings()
+{
+	gbInternal->jit.Enabled = settings.UseJIT;
+	gbInternal->Stepping = settings.UseStepping || settings.UseIdleLoops;
+	gbInternal->idleLoop.Enabled = settings.UseIdleLoops;
+	gbInternal->idleLoop.Log = settings.UseIdleLoops;
+
+	if (settings.DrawShownOnly)
+	{
+		gbInternal->ppu.FrameSkip = PPU::RenderRequested;
+	}
+	else if (settings.FrameSkip > 1)
+	{
+		gbInternal->ppu.FrameSkip = PPU::RenderOneInN;
+		gbInternal->ppu.FrameSkipN = settings.FrameSkip;
+	}
+
+	if (settings.RenderThread)
+	{
+		gbInternal->ppu.renderOnThread();
+	}
+
+	emulation.setLatency(settings.AudioLatency);
+	emulation.Log = settings.AudioStats;
+}
+
 void GB::createWindow()
 {
-	int ScreenWidth = 300;
+	postProcess.upscaler = settings.Scale2x ? PostProcess::Scale2x : PostProcess::Integer;
+	postProcess.Scale = settings.Scale;
+	postProcess.LCDGrid = settings.LCDGrid;
+	postProcess.Ghosting = settings.Ghosting;
+
+	if (postProcess.enabled())
+	{
+		postProcess.start(settings.PostThreads);
+	}
+
+	// Large enough to show upscaled frames without shrinking them
+	int ScreenWidth = std::max(300, (int)postProcess.width());
 	int ScreenHeight = GB_SCREEN_RATIO * ScreenWidth;
 
 	if (SDL_Init(SDL_INIT_EVERYTHING) == 0)
@@ -39,7 +83,7 @@ void GB::createWindow()
 			return;
 		}
 
-		texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, GridWidth, GridHeight);
+		texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, postProcess.width(), postProcess.height());
 
 		// Setup controllers if any
 		int nControllers = SDL_NumJoysticks();
@@ -58,6 +102,9 @@ void GB::createWindow()
 
 GB::~GB()
 {
+	// The thread has to be done with it first
+	emulation.stop();
+
 	if (gbInternal != nullptr)
 	{
 		delete gbInternal;
@@ -71,6 +118,7 @@ void GB::startGame(std::string gbFilename)
 	if (gbInternal == nullptr)
 	{
 		gbInternal = new GBInternal(gbFilename);
+		applySettings();
 
 		// Setup audio
 		SDL_zero(spec);
@@ -80,33 +128,33 @@ void GB::startGame(std::string gbFilename)
 		// sound card probabally cannot keep up so we will go
 		// with the nominal 44.1kHz which is above nyquist for 
 		// all sounds.
-		spec.freq = 44100;
+		spec.freq = EmulationThread::SampleRate;
 		spec.format = AUDIO_S16SYS;
 		spec.channels = 2;
-		spec.samples = 512;
-		spec.callback = &APU::AudioSample; // We will push our own data
-		spec.userdata = &(gbInternal->apu);
+		spec.samples = emulation.callbackFrames();
+		spec.callback = &EmulationThread::audioCallback; // Only takes samples from the ring
+		spec.userdata = &emulation;
 		device = SDL_OpenAudioDevice(NULL, 0, &spec, NULL, 0);
 
-		if (device == 0) {
-			// Audio device not turned on
-			return;
-		}
+		// Without an audio device the game still runs
+		emulation.start(gbInternal, device != 0);
 
-		SDL_PauseAudioDevice(device, 0); // Start playing audio
+		if (device != 0)
+		{
+			SDL_PauseAudioDevice(device, 0); // Start playing audio
+		}
 	}
 	else
 	{
-		SDL_PauseAudioDevice(device, 1); // Stop playing audio
-		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		// The audio callback never touches the emulator, so
+		// only the emulation thread has to be stopped first.
+		emulation.stop();
 
 		delete gbInternal;
 		gbInternal = new GBInternal(gbFilename);
-		spec.userdata = &(gbInternal->apu);
-
-		std::this_thread::sleep_for(std::chrono::milliseconds(50));
-		SDL_PauseAudioDevice(device, 0); // Start playing audio
+		applySettings();
 
+		emulation.start(gbInternal, device != 0);
 	}
 }
 
@@ -123,8 +171,12 @@ void GB::gameLoop()
 			if (delta > 1000 / 60.0)
 			{
 				handleEvents();
-				update();
-				render();
+
+				// Nothing is presented if the screen hasn't changed
+				if (update())
+				{
+					render();
+				}
 
 				b = a;
 			}
@@ -295,14 +347,73 @@ void GB::handleEvents()
 	}
 }
 
-void GB::update()
+bool GB::update()
 {
 	if (gbInternal == nullptr)
 	{
-		return;
+		return false;
+	}
+
+	bool Dirty[18 * 8];
+	bool Changed = gbInternal->ppu.takeDirtyLines(Dirty);
+
+	if (Redraw)
+	{
+		std::fill(Dirty, Dirty + GridHeight, true);
+		Changed = true;
+		Redraw = false;
+	}
+
+	// Only runs of lines which changed are converted and uploaded
+	for (int y = 0; y < GridHeight;)
+	{
+		if (!Dirty[y])
+		{
+			y++;
+			continue;
+		}
+
+		int First = y;
+		for (; y < GridHeight && Dirty[y]; y++)
+		{
+			for (int x = 0; x < GridWidth; x++)
+			{
+				Frame[y][x] = Palette[gbInternal->ppu.DotMatrix[y][x]];
+			}
+		}
+
+		if (!postProcess.enabled())
+		{
+			SDL_Rect Rows = { 0, First, GridWidth, y - First };
+			SDL_UpdateTexture(texture, &Rows, Frame[First], GridWidth * sizeof(uint32_t));
+		}
 	}
 
-	SDL_UpdateTexture(texture, NULL, gbInternal->ppu.DotMatrix, GridWidth * sizeof(uint32_t));
+	// Processed frames are uploaded whole, and keep changing 
+	// after the screen does until ghosting has faded.
+	if (postProcess.enabled())
+	{
+		if (Changed)
+		{
+			GhostingFrames = postProcess.Ghosting ? PostProcess::nGhostingFrames : 0;
+		}
+		else if (GhostingFrames > 0)
+		{
+			GhostingFrames--;
+			Changed = true;
+		}
+
+		if (Changed)
+		{
+			const uint32_t* Processed = postProcess.process(&Frame[0][0]);
+			SDL_UpdateTexture(texture, NULL, Processed, postProcess.width() * sizeof(uint32_t));
+		}
+	}
+
+	// What's shown next time is the frame after this one
+	gbInternal->ppu.requestFrame();
+
+	return Changed;
 }
 
 void GB::render()
@@ -314,6 +425,8 @@ void GB::render()
 
 void GB::clean()
 {
+	emulation.stop();
+
 	SDL_DestroyWindow(window);
 	SDL_DestroyRenderer(renderer);
 	SDL_CloseAudioDevice(device);
@@ -1,22 +1,52 @@
 #pragma once
 #include "SDL.h"
 #include "GBInternal.hpp"
+#include "PostProcess.hpp"
+#include "EmulationThread.hpp"
 #include <string>
 
+// Options set from the command line
+struct Settings
+{
+	bool UseJIT = false;		// Translate ROM code to native code
+	bool UseStepping = false;	// Run an instruction at a time
+	bool UseIdleLoops = false;	// Skip polling loops, implies UseStepping
+	uint32_t FrameSkip = 1;		// Draw one in every FrameSkip frames
+	bool DrawShownOnly = false;	// Only draw frames which are going to be shown
+	bool RenderThread = false;	// Draw lines on another thread
+	uint32_t Scale = 1;			// Upscale each pixel Scale times before showing it
+	bool Scale2x = false;		// Upscale with Scale2x instead
+	bool LCDGrid = false;		// Darken the edges of upscaled pixels
+	bool Ghosting = false;		// Blend each frame with the ones before it
+	uint32_t PostThreads = 0;	// Threads upscaling, 0 for one for each core
+	uint32_t AudioLatency = 20;	// Milliseconds of samples kept queued for the audio device
+	bool AudioStats = false;	// Print the audio rate control's state every second
+};
+
 class GB
 {
 public:
 	GB();
 	GB(std::string gbFilename);
+	GB(Settings settings);
 	~GB();
 
 	GBInternal *gbInternal;
+	Settings settings;
+
+	// Runs gbInternal and queues its samples for the audio device
+	EmulationThread emulation;
+
+	// Applies the settings to a newly started game
+	void applySettings();
 
 	void startGame(std::string gbFilename);
 	void createWindow();
 	void gameLoop();
 	void handleEvents();
-	void update();
+	// Uploads the lines which changed since last time, 
+	// returns false if nothing did.
+	bool update();
 	void render();
 	void clean();
 
@@ -30,5 +60,24 @@ public:
 
 	const int GridWidth = 20 * 8;
 	const int GridHeight = 18 * 8;
+
+	// Colour each of the 4 shades is shown in, as RGBA8888. 
+	// Can be changed to tint the screen or correct its colours.
+	uint32_t Palette[4] = { 0xFFFFFFFF, 0xAAAAAAFF, 0x555555FF, 0x000000FF };
+
+	// The PPU's shades turned into colours, 
+	// uploaded to the texture once a frame.
+	uint32_t Frame[18 * 8][20 * 8];
+
+	// Set to upload the whole frame next update, 
+	// for example after changing the palette.
+	bool Redraw = true;
+
+	// Upscales Frame and adds LCD effects when enabled, the 
+	// texture is then the size of the processed frame.
+	PostProcess postProcess;
+
+	// Frames left until ghosting fades after the screen last changed
+	uint32_t GhostingFrames = 0;
 };
 
@@ -2,10 +2,15 @@
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 
 GBInternal::GBInternal(std::string gbFilename)
 {
 	nClockCycles = 0;
+	SyncedTo = 0;
+
+	// Components schedule their first events when connected
+	scheduler.connectGB(this);
 
 	// Connect SM83 to remainder of system
 	cpu.connectGB(this);
@@ -25,6 +30,18 @@ GBInternal::GBInternal(std::string gbFilename)
 	// Connect APU
 	apu.connectGB(this);
 
+	// Connect instruction cache
+	blockCache.connectGB(this);
+	jit.connectGB(this);
+
+	// Connect idle loop detection
+	idleLoop.connectGB(this);
+
+	// Connect expanded tile data used by the PPU
+	tileCache.connectGB(this);
+
+	mapMemory();
+
 	// ============== Initilizes Registers ==============
 	// CPU Internal Registers
 	cpu.AF = 0x01B0;
@@ -49,6 +66,7 @@ GBInternal::GBInternal(std::string gbFilename)
 	*timer.TIMA = 0x00;
 	*timer.TMA = 0x00;
 	*timer.TAC = 0xF8;
+	timer.schedule();
 
 	// TODO: Finish remaining initialization
 
@@ -57,16 +75,333 @@ GBInternal::GBInternal(std::string gbFilename)
 void GBInternal::clock()
 {
 	cpu.clock();
-	ppu.clock();
-	timer.clock();
-	dma.clock();
-	apu.clock();
+
+	// The PPU, Timer, DMA and the APU frame sequencer are 
+	// only clocked when they have something to do.
+	if (nClockCycles >= scheduler.Next)
+	{
+		scheduler.dispatch();
+	}
+
+	// The channels catch up by themselves otherwise
+	if (!apu.Lazy)
+	{
+		apu.catchUp(nClockCycles + 1);
+	}
 
 	nClockCycles++;
+	SyncedTo = nClockCycles;
+}
+
+void GBInternal::step(uint64_t Until)
+{
+	if (cpu.Halted)
+	{
+		// A loop with HALT in it doesn't take the same 
+		// number of T-cycles every time around.
+		idleLoop.Watching = false;
+
+		sync();
+
+		if (!skipHalt(Until))
+		{
+			clock();
+		}
+
+		return;
+	}
+
+	// Once woken up the CPU waits for the start of the next 
+	// machine cycle, so everything is clocked together until then.
+	if (nClockCycles % 4 != 0)
+	{
+		sync();
+		clock();
+		return;
+	}
+
+	// Polling loops are skipped until what they read changes
+	if (idleLoop.Enabled && cpu.cycle == 0 && cpu.Run == nullptr && idleLoop.check(Until))
+	{
+		return;
+	}
+
+	// IF only needs to be up to date if an interrupt can be 
+	// serviced or a translated run may need to be rolled back.
+	if (cpu.IME || cpu.Run != nullptr)
+	{
+		sync();
+	}
+
+	cpu.clock();
+
+	if (cpu.Halted)
+	{
+		nClockCycles++;
+	}
+	else if (cpu.Run != nullptr)
+	{
+		// Checked again at the next machine cycle
+		nClockCycles += 4;
+	}
+	else
+	{
+		// The CPU does nothing but count down the remaining
+		// machine cycles of the instruction, skip past them.
+		cpu.nMachineCycles += cpu.cycle;
+		nClockCycles += 4 * (cpu.cycle + 1);
+		cpu.cycle = 0;
+	}
+}
+
+void GBInternal::catchUp()
+{
+	uint64_t Now = nClockCycles;
+
+	// Each component expects nClockCycles to be the 
+	// T-cycle it's being clocked for.
+	if (apu.Lazy)
+	{
+		// Nothing happens in between events, so 
+		// it goes straight from one to the next.
+		while (SyncedTo < Now && scheduler.Next < Now)
+		{
+			SyncedTo = std::max(SyncedTo, scheduler.Next);
+			nClockCycles = SyncedTo;
+
+			scheduler.dispatch();
+			SyncedTo++;
+		}
+
+		SyncedTo = Now;
+	}
+	else
+	{
+		for (; SyncedTo != Now; SyncedTo++)
+		{
+			nClockCycles = SyncedTo;
+
+			if (SyncedTo >= scheduler.Next)
+			{
+				scheduler.dispatch();
+			}
+
+			apu.catchUp(SyncedTo + 1);
+		}
+	}
+
+	nClockCycles = Now;
+}
+
+void GBInternal::runUntil(uint64_t Target)
+{
+	if (Stepping)
+	{
+		// An instruction can take the CPU past Target
+		while (nClockCycles < Target)
+		{
+			step(Target);
+		}
+
+		sync();
+	}
+	else
+	{
+		while (nClockCycles < Target)
+		{
+			if (cpu.Halted && skipHalt(Target))
+			{
+				// Everything but the CPU is still clocked
+				sync();
+			}
+			else
+			{
+				clock();
+			}
+		}
+	}
+}
+
+bool GBInternal::skipHalt(uint64_t Until)
+{
+	if (!SkipHalt || (IE->reg & IF->reg & 0x1F) != 0)
+	{
+		return false;
+	}
+
+	// IF can only change when the PPU or Timer are next clocked, 
+	// which happens after the CPU has checked IF on that T-cycle.
+	uint64_t Wake = scheduler.nextInterrupt();
+	if (Wake < Until)
+	{
+		Until = Wake + 1;
+	}
+
+	if (Until <= nClockCycles)
+	{
+		return false;
+	}
+
+	nHaltSkipped += Until - nClockCycles;
+	nClockCycles = Until;
+
+	return true;
+}
+
+void GBInternal::endFrame()
+{
+	nFrames++;
+
+	nHaltSkippedLastFrame = nHaltSkipped - HaltSkippedAtFrameStart;
+	HaltSkippedAtFrameStart = nHaltSkipped;
+}
+
+void GBInternal::mapMemory()
+{
+	for (uint16_t Page = 0; Page < 0x100; Page++)
+	{
+		mapPage(Page);
+	}
+}
+
+void GBInternal::mapCartridge()
+{
+	// Each ROM bank is contiguous, only the first 
+	// page of each needs to be looked up.
+	for (uint16_t Bank = 0x00; Bank < 0x80; Bank += 0x40)
+	{
+		mapPage(Bank);
+
+		for (uint16_t Page = Bank + 1; Page < Bank + 0x40; Page++)
+		{
+			ReadPage[Page] = ReadPage[Bank] == nullptr ? nullptr : ReadPage[Bank] + ((Page - Bank) << 8);
+		}
+	}
+
+	for (uint16_t Page = 0xA0; Page < 0xC0; Page++)
+	{
+		mapPage(Page);
+	}
+}
+
+void GBInternal::mapPage(uint8_t Page)
+{
+	uint16_t addr = Page << 8;
+	MBC* mbc = cart->mbc;
+
+	ReadPage[Page] = nullptr;
+	WritePage[Page] = nullptr;
+
+	// During a DMA transfer the CPU can only access HRAM
+	if (!UsePageTable || dma.DMAinProgress)
+	{
+		return;
+	}
+
+	if (addr < 0x8000)		// Cartridge ROM
+	{
+		uint32_t Offset = mbc->ROMBank(addr) * 0x4000 + (addr % 0x4000);
+		if (Offset < (uint32_t)mbc->ROMSizeBytes)
+		{
+			ReadPage[Page] = mbc->ROM + Offset;
+		}
+	}
+	else if (addr < 0xA000)	// VRAM
+	{
+		ReadPage[Page] = RAM + addr;
+
+		// Tile data has to be written through write() to keep the
+		// tile cache up to date, so does VRAM while a line is batched
+		// and while lines are drawn on another thread.
+		if (!ppu.LineBatched && !ppu.Threaded && (addr >= 0x9800 || !tileCache.Enabled))
+		{
+			WritePage[Page] = RAM + addr;
+		}
+	}
+	else if (addr < 0xC000)	// Cartridge RAM
+	{
+		ReadPage[Page] = mbc->RAMPage(addr, false);
+		WritePage[Page] = mbc->RAMPage(addr, true);
+	}
+	else if (addr < 0xE000)	// WRAM
+	{
+		ReadPage[Page] = RAM + addr;
+
+		// Echo RAM is read from here so it doesn't need to be written 
+		// twice. 0xDE00 is written twice because it's mirrored into OAM.
+		if (addr < 0xDE00 && !blockCache.hasCode(Page))
+		{
+			WritePage[Page] = RAM + addr;
+		}
+	}
+	else if (addr < 0xFE00)	// Echo RAM
+	{
+		ReadPage[Page] = RAM + addr - 0x2000;
+	}
+	else if (addr < 0xFF00)	// OAM
+	{
+		ReadPage[Page] = RAM + addr;
+	}
+}
+
+void GBInternal::mapVRAM()
+{
+	// Happens twice every line so the pages are set directly
+	uint8_t* Read = UsePageTable && !dma.DMAinProgress ? RAM + 0x8000 : nullptr;
+	uint8_t* Write = ppu.LineBatched || ppu.Threaded ? nullptr : Read;
+
+	for (uint16_t Page = 0; Page < 0x20; Page++)
+	{
+		ReadPage[0x80 + Page] = Read == nullptr ? nullptr : Read + (Page << 8);
+		WritePage[0x80 + Page] = Write == nullptr ? nullptr : Write + (Page << 8);
+	}
+
+	// Tile data
+	if (tileCache.Enabled)
+	{
+		for (uint16_t Page = 0; Page < 0x18; Page++)
+		{
+			WritePage[0x80 + Page] = nullptr;
+		}
+	}
+}
+
+bool GBInternal::needsSync(uint16_t addr, bool Write)
+{
+	// The end of a DMA transfer changes what the CPU can access
+	if (dma.DMAinProgress)
+	{
+		return true;
+	}
+
+	// The PPU renders from VRAM but never changes it
+	if (addr >= 0x8000 && addr < 0xA000)
+	{
+		return Write;
+	}
+
+	// OAM and IO registers
+	return addr >= 0xFE00 && addr < 0xFF80;
 }
 
 uint8_t GBInternal::read(uint16_t addr)
 {
+	if (idleLoop.Watching)
+	{
+		idleLoop.access(addr, false);
+	}
+
+	if (SyncedTo != nClockCycles && needsSync(addr, false))
+	{
+		catchUp();
+	}
+
+	uint8_t* Page = ReadPage[addr >> 8];
+	if (Page != nullptr)
+	{
+		return Page[addr & 0xFF];
+	}
+
 	// During a dma transfer the CPU can only read
 	// HRAM which is located from 0xFF00-0xFFFE.
 	if (dma.DMAinProgress)
@@ -87,6 +422,11 @@ uint8_t GBInternal::read(uint16_t addr)
 	{
 		return cart->read(addr);
 	}
+	else if (addr >= 0xFF04 && addr <= 0xFF07)	// Timer
+	{
+		// The Timer is only clocked when TIMA overflows
+		timer.catchUp(nClockCycles);
+	}
 	else if (addr >= 0xFF10 && addr <= 0xFF3F)	// Intended for APU
 	{
 		return apu.read(addr);
@@ -97,6 +437,31 @@ uint8_t GBInternal::read(uint16_t addr)
 
 void GBInternal::write(uint16_t addr, uint8_t data)
 {
+	if (idleLoop.Watching)
+	{
+		idleLoop.access(addr, true);
+	}
+
+	if (SyncedTo != nClockCycles && needsSync(addr, true))
+	{
+		catchUp();
+	}
+
+	uint8_t* Page = WritePage[addr >> 8];
+	if (Page != nullptr)
+	{
+		Page[addr & 0xFF] = data;
+		return;
+	}
+
+	// A line being drawn at the end of mode 3 has to be drawn
+	// with what the PPU sees before anything it reads changes.
+	if (ppu.LineBatched && ((addr >= 0x8000 && addr < 0xA000) || 
+		(addr >= 0xFE00 && addr < 0xFEA0) || (addr >= 0xFF40 && addr <= 0xFF4B)))
+	{
+		ppu.lineChanged(nClockCycles);
+	}
+
 	// During a dma transfer the CPU can only access
 	// HRAM which is located from 0xFF00-0xFFFE.
 	if (dma.DMAinProgress)
@@ -109,9 +474,49 @@ void GBInternal::write(uint16_t addr, uint8_t data)
 		}
 	}
 
+	// The render thread has its own copy of VRAM
+	if (ppu.Threaded && addr >= 0x8000 && addr < 0xA000)
+	{
+		ppu.renderThread.vramWritten(addr, data);
+	}
+
+	// Keep decoded instructions up to date with bank switches
+	// and self-modifying code, and expanded tiles with VRAM.
+	if (addr < 0x8000)
+	{
+		blockCache.bankSwitch();
+	}
+	else if (addr >= 0xC000)
+	{
+		blockCache.invalidate(addr);
+	}
+	else if (addr < 0x9800)
+	{
+		// Tile data
+		tileCache.invalidate(addr);
+	}
+
+	// 0xDE00 is mirrored into the first byte of OAM
+	if ((addr >= 0xFE00 && addr < 0xFEA0) || addr == 0xDE00)
+	{
+		ppu.objectsChanged();
+	}
+
+	// The Timer is only clocked when TIMA overflows, bring it
+	// up to date before its registers are changed and work out
+	// when it will next overflow afterwards.
+	bool TimerWrite = addr >= 0xFF04 && addr <= 0xFF07;
+	if (TimerWrite)
+	{
+		timer.catchUp(nClockCycles);
+	}
+
 	if (addr < 0x8000)		// Cartridge
 	{
 		cart->write(addr, data);
+
+		// Banks or cartridge RAM may have been switched
+		mapCartridge();
 	}
 	//else if (addr == 0xFF12)	// Debugging
 	//{
@@ -246,13 +651,21 @@ void GBInternal::write(uint16_t addr, uint8_t data)
 
 		// Writing to this register resets the match flag
 		//ppu.STAT->MatchFlag = 0;
+
+		// LY == LYC interrupts may have been enabled
+		ppu.wake();
+	}
+	else if (addr == 0xFF45)	// LYC Register
+	{
+		*ppu.LYC = data;
+		ppu.wake();
 	}
 	else if (addr == 0xFF46)	// OAM DMA Transfer Register
 	{
 		// Transfers 100 bytes of data starting from 
 		// the high nibble of the register.
 		*dma.DMAReg = data;
-		dma.DMAinProgress = true;
+		dma.start();
 	}
 	else if (addr == 0xFFFF)	// IE
 	{
@@ -267,6 +680,11 @@ void GBInternal::write(uint16_t addr, uint8_t data)
 	{
 		RAM[addr] = data;
 	}
+
+	if (TimerWrite)
+	{
+		timer.schedule();
+	}
 }
 
 GBInternal::~GBInternal()
@@ -7,6 +7,11 @@
 #include "DMA.hpp"
 #include <string>
 #include "APU.hpp"
+#include "BlockCache.hpp"
+#include "JIT.hpp"
+#include "Scheduler.hpp"
+#include "IdleLoop.hpp"
+#include "TileCache.hpp"
 
 class GBInternal
 {
@@ -20,13 +25,81 @@ public:
 	Timer timer;
 	DMA dma;
 	APU apu;
+	BlockCache blockCache;
+	JIT jit;
+	Scheduler scheduler;
+	IdleLoop idleLoop;
+	TileCache tileCache;
 
-	uint32_t nClockCycles;
+	uint64_t nClockCycles;
+
+	// The PPU, Timer, DMA and APU have been clocked for every
+	// T-cycle before this one. When stepping they lag behind
+	// the CPU, otherwise this is the same as nClockCycles.
+	uint64_t SyncedTo;
+
+	// Run the CPU an instruction at a time instead of clocking
+	// every component on every T-cycle.
+	bool Stepping = false;
 
 	uint8_t read(uint16_t addr);
 	void write(uint16_t addr, uint8_t data);
 	void clock();
 
+	// Runs the CPU until the next machine cycle where it has
+	// something to do, usually the fetch of the next instruction.
+	// The rest of the system is left behind and only clocked up to
+	// the CPU when it accesses their registers or looks at IF.
+	// It won't skip past Until while halted or in an idle loop.
+	void step(uint64_t Until = Scheduler::Never);
+
+	// Clocks the PPU, Timer, DMA and the APU frame sequencer up to
+	// nClockCycles. The APU channels catch up when they're needed.
+	void sync()
+	{
+		if (SyncedTo != nClockCycles)
+		{
+			catchUp();
+		}
+	}
+
+	// Runs the system until nClockCycles reaches Target
+	void runUntil(uint64_t Target);
+
+	// While the CPU is halted nothing happens until an interrupt is
+	// requested, so the T-cycles up to the next event which could
+	// request one are skipped over instead of checking IF on each.
+	bool SkipHalt = true;
+
+	uint64_t nHaltSkipped = 0;			// T-cycles skipped while halted
+	uint32_t nHaltSkippedLastFrame = 0;	// ... during the last frame
+	uint64_t nFrames = 0;
+
+	// Called by the PPU at the start of vertical blanking
+	void endFrame();
+
+	// Where each 256 byte page of the address space is stored for
+	// reads and writes which do nothing but access memory, so they
+	// are a single lookup. Pages holding IO registers, MBC registers
+	// or cached code are nullptr and handled by read() and write().
+	uint8_t* ReadPage[256];
+	uint8_t* WritePage[256];
+
+	// Can be turned off to compare against the slow path
+	bool UsePageTable = true;
+
+	// Rebuilds the whole table, when a DMA transfer starts or ends
+	void mapMemory();
+
+	// Rebuilds the ROM and cartridge RAM pages after an MBC write
+	void mapCartridge();
+
+	// Rebuilds a single page
+	void mapPage(uint8_t Page);
+
+	// Rebuilds the VRAM pages, when the PPU starts or stops batching a line
+	void mapVRAM();
+
 	// RAM for Memory Mapping
 	uint8_t RAM[0xFFFF + 1];
 
@@ -129,5 +202,18 @@ public:
 
 	} *IE = reinterpret_cast<decltype(IE)>(RAM + 0xFFFF);
 
+private:
+	void catchUp();
+
+	// Moves nClockCycles forward to when a halted CPU could next 
+	// be woken up, but not past Until. Returns false if it can't 
+	// skip anything. The rest of the system must be synced first.
+	bool skipHalt(uint64_t Until);
+
+	uint64_t HaltSkippedAtFrameStart = 0;
+
+	// Whether the CPU accessing addr at the current T-cycle
+	// could see or change the state of another component.
+	bool needsSync(uint16_t addr, bool Write);
 
 };
\ No newline at end of file
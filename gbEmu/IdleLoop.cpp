@@ -0,0 +1,220 @@
+#include "IdleLoop.hpp"
+#include "GBInternal.hpp"
+#include <iomanip>
+
+void IdleLoop::connectGB(GBInternal* gb)
+{
+	this->gb = gb;
+}
+
+void IdleLoop::watch()
+{
+	SM83& cpu = gb->cpu;
+
+	Head = cpu.PC;
+	AF = cpu.AF;
+	BC = cpu.BC;
+	DE = cpu.DE;
+	HL = cpu.HL;
+	SP = cpu.SP;
+	IME = cpu.IME;
+	Start = gb->nClockCycles;
+	StartInstructions = cpu.nInstructions;
+
+	Clean = true;
+	ReadsDIV = false;
+	ReadsTIMA = false;
+	Polled = 0;
+	Watching = true;
+}
+
+void IdleLoop::access(uint16_t addr, bool Write)
+{
+	if (Write)
+	{
+		Clean = false;
+		return;
+	}
+
+	if (addr == 0xFF04)
+	{
+		ReadsDIV = true;
+	}
+	else if (addr == 0xFF05)
+	{
+		ReadsTIMA = true;
+	}
+	else if ((addr >= 0xA000 && addr < 0xC000) ||	// Cartridge RAM (or an RTC)
+		(addr >= 0xFE00 && addr <= 0xFF00) ||		// OAM and the joypad
+		(addr >= 0xFF10 && addr <= 0xFF3F))			// APU
+	{
+		Clean = false;
+	}
+
+	// ROM never changes so it can't be what the loop waits on
+	if (addr >= 0x8000 && (addr < Head || addr >= Head + MaxLength))
+	{
+		Polled = addr;
+	}
+}
+
+bool IdleLoop::check(uint64_t Until)
+{
+	SM83& cpu = gb->cpu;
+
+	// Already checked at this fetch
+	if (Watching && gb->nClockCycles == Start)
+	{
+		return false;
+	}
+
+	bool Backward = cpu.PC <= LastPC && LastPC - cpu.PC <= MaxLength;
+	LastPC = cpu.PC;
+
+	if (Watching && cpu.nInstructions - StartInstructions > MaxInstructions)
+	{
+		// Too long to be a polling loop
+		Watching = false;
+	}
+
+	if (!Backward)
+	{
+		return false;
+	}
+
+	cpu.materializeFlags();
+
+	bool Same = Watching && Clean && cpu.PC == Head &&
+		cpu.AF == AF && cpu.BC == BC && cpu.DE == DE && cpu.HL == HL && cpu.SP == SP &&
+		cpu.IME == IME && cpu.IMEDelaySet == 0xFF && !cpu.Stopped;
+
+	if (!Same)
+	{
+		watch();
+		return false;
+	}
+
+	// The last iteration started and ended in the same state without
+	// changing anything, so the next one will do exactly the same unless
+	// what it reads has changed by then.
+	uint64_t Now = gb->nClockCycles;
+	uint32_t Cycles = (uint32_t)(Now - Start);
+	uint32_t nInstructions = (uint32_t)(cpu.nInstructions - StartInstructions);
+
+	gb->sync();
+
+	// LY, STAT and IF only change when the PPU or Timer are clocked
+	// for an event, after the CPU has run on that T-cycle. If that
+	// happened during the last iteration it may not have seen it.
+	bool Changed = gb->scheduler.LastInterrupt >= Start;
+	uint64_t Change = gb->scheduler.nextInterrupt();
+
+	for (uint16_t addr : { 0xFF04, 0xFF05 })
+	{
+		if (addr == 0xFF04 ? !ReadsDIV : !ReadsTIMA)
+		{
+			continue;
+		}
+
+		gb->timer.catchUp(Now);
+
+		Changed |= gb->timer.changedWithin(addr, Cycles);
+
+		uint64_t Tick = gb->timer.nextChange(addr);
+		if (Tick < Change)
+		{
+			Change = Tick;
+		}
+	}
+
+	// Iterations which are over by the end of the T-cycle Change
+	// can be skipped. An interrupt which is already pending or the 
+	// end of a DMA transfer would make the next one different.
+	uint64_t nIterations = (Until - Now) / Cycles;
+
+	if (Change != Scheduler::Never && (Change + 1 - Now) / Cycles < nIterations)
+	{
+		nIterations = (Change + 1 - Now) / Cycles;
+	}
+
+	if (Changed || gb->dma.DMAinProgress || (cpu.IME && (gb->IE->reg & gb->IF->reg & 0x1F) != 0))
+	{
+		nIterations = 0;
+	}
+
+	if (nIterations == 0)
+	{
+		watch();
+		return false;
+	}
+
+	gb->nClockCycles += nIterations * Cycles;
+	cpu.nInstructions += nIterations * nInstructions;
+	cpu.nMachineCycles += nIterations * Cycles / 4;
+
+	nSkips++;
+	nSkipped += nIterations * Cycles;
+
+	uint32_t Key = Head;
+	if (Head < 0x8000)
+	{
+		Key |= gb->cart->mbc->ROMBank(Head) << 16;
+	}
+
+	auto Found = Loops.find(Key);
+	if (Found == Loops.end())
+	{
+		Found = Loops.emplace(Key, Entry()).first;
+		Found->second.Polled = Polled;
+		Found->second.Cycles = Cycles;
+		Found->second.nInstructions = nInstructions;
+
+		if (Log)
+		{
+			std::cout << "[idle] ";
+			printEntry(std::cout, Key, Found->second);
+			std::cout << std::endl;
+		}
+	}
+
+	Found->second.nSkips++;
+	Found->second.nSkipped += nIterations * Cycles;
+
+	// Carry on watching from the same point
+	watch();
+
+	return true;
+}
+
+void IdleLoop::printEntry(std::ostream& os, uint32_t Key, const Entry& entry)
+{
+	std::ios_base::fmtflags Flags = os.flags();
+
+	os << std::hex << std::uppercase << std::setfill('0')
+		<< std::setw(2) << (Key >> 16) << ':' << std::setw(4) << (Key & 0xFFFF) << std::dec;
+
+	if (entry.Polled == 0)
+	{
+		os << " waiting for an interrupt";
+	}
+	else
+	{
+		os << " polling " << std::hex << std::setw(4) << entry.Polled << std::dec;
+	}
+
+	os << ", " << entry.nInstructions << " instructions and "
+		<< entry.Cycles << " T-cycles per iteration";
+
+	os.flags(Flags);
+	os << std::setfill(' ');
+}
+
+void IdleLoop::printLog(std::ostream& os)
+{
+	for (auto& Loop : Loops)
+	{
+		os << "[idle] ";
+		printEntry(os, Loop.first, Loop.second);
+		os << ", skipped " << Loop.second.nSkips << " times, " << Loop.second.nSkipped << " T-cycles" << std::endl;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <iostream>
+
+class GBInternal;
+
+/// <summary>
+/// Finds short loops which do nothing but wait for a register
+/// to change, such as LDH A,(44h) / CP n / JR NZ spinning on LY
+/// or a loop polling STAT or a flag set by an interrupt handler,
+/// and skips the iterations which can't see anything different.
+/// A loop is recognised when the CPU jumps back to the same
+/// address with the same registers as last time without having
+/// written to memory or read anything which changes on its own
+/// (the joypad, APU, cartridge RAM or OAM). Each iteration after
+/// that reads the same values and ends up in the same state, at
+/// least until the next PPU or Timer event changes LY, STAT or
+/// IF, or the next time DIV or TIMA ticks if the loop reads
+/// them. The iterations finishing before then are skipped over
+/// all at once, so the result is the same as stepping through
+/// them. Only used when stepping.
+/// </summary>
+class IdleLoop
+{
+public:
+	GBInternal* gb;
+
+	void connectGB(GBInternal* gb);
+
+	bool Enabled = false;
+
+	// Print each loop the first time it's skipped
+	bool Log = false;
+
+	// Called before the CPU fetches an instruction. Returns
+	// true if it skipped ahead instead, but not past Until.
+	bool check(uint64_t Until);
+
+	// Called for every memory access while a loop is being watched
+	bool Watching = false;
+	void access(uint16_t addr, bool Write);
+
+	uint64_t nSkips = 0;	// Times iterations were skipped
+	uint64_t nSkipped = 0;	// T-cycles skipped
+
+	// Loops found so far and how much was skipped in each
+	void printLog(std::ostream& os);
+
+private:
+	// Longest loop in bytes and instructions
+	static const uint16_t MaxLength = 32;
+	static const uint32_t MaxInstructions = 16;
+
+	// Address of the previous instruction fetched
+	uint16_t LastPC = 0;
+
+	// First instruction of the loop being watched and the
+	// state of the CPU when it was last about to execute it.
+	uint16_t Head;
+	uint16_t AF, BC, DE, HL, SP;
+	bool IME;
+	uint64_t Start;
+	uint64_t StartInstructions;
+
+	// Nothing has been done since Start which could make
+	// the next iteration behave differently.
+	bool Clean;
+
+	// DIV or TIMA were read since Start
+	bool ReadsDIV, ReadsTIMA;
+
+	// Last address read outside the loop, shown in the log
+	uint16_t Polled;
+
+	void watch();
+
+	struct Entry
+	{
+		uint16_t Polled;
+		uint32_t Cycles;	// T-cycles per iteration
+		uint32_t nInstructions;
+		uint64_t nSkips = 0;
+		uint64_t nSkipped = 0;
+	};
+
+	// Keyed on the ROM bank and address of the first instruction
+	std::map<uint32_t, Entry> Loops;
+
+	void printEntry(std::ostream& os, uint32_t Key, const Entry& entry);
+};
\ No newline at end of file
@@ -0,0 +1,719 @@
+#include "JIT.hpp"
+#include "GBInternal.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JIT_X64 1
+#else
+#define JIT_X64 0
+#endif
+
+#if JIT_X64
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+// Offsets of the registers in JITRegisters, indexed
+// the same way as SM83::GPR() and SM83::ss()
+static const uint8_t F = 0, A = 1;
+static const uint8_t GPROffset[8] = { 3, 2, 5, 4, 7, 6, 0xFF, 1 };	// B C D E H L - A
+static const uint8_t ssOffset[4] = { 2, 4, 6, 8 };	// BC DE HL SP
+
+JIT::JIT()
+{
+	// LAHF loads SF:ZF:0:AF:0:PF:1:CF into AH. The zero,
+	// auxiliary (half) carry and carry flags line up with
+	// the SM83's Z, H and CY flags.
+	for (int ah = 0; ah < 256; ah++)
+	{
+		FlagTable[ah] = (((ah >> 6) & 1) << 7)
+			| (((ah >> 4) & 1) << 5)
+			| ((ah & 1) << 4);
+	}
+}
+
+JIT::~JIT()
+{
+#if JIT_X64
+	if (Memory != nullptr)
+	{
+#ifdef _WIN32
+		VirtualFree(Memory, 0, MEM_RELEASE);
+#else
+		munmap(Memory, MemorySize);
+#endif
+	}
+#endif
+}
+
+void JIT::connectGB(GBInternal* gb)
+{
+	this->gb = gb;
+}
+
+const JITRun* JIT::lookup(BlockCache::MicroOp* op, uint32_t nFollowing)
+{
+	if (op->Native != nullptr)
+	{
+		return op->Native;
+	}
+
+	// Each instruction only gets one attempt at being
+	// translated once it has been run enough times.
+	if (op->Heat < Threshold)
+	{
+		op->Heat++;
+	}
+	else if (op->Heat == Threshold)
+	{
+		op->Heat++;
+		op->Native = translate(op, nFollowing + 1);
+	}
+
+	return op->Native;
+}
+
+void JIT::emit(std::initializer_list<uint8_t> bytes)
+{
+	for (uint8_t b : bytes)
+	{
+		Buffer[nBuffer++] = b;
+	}
+}
+
+void JIT::emit16(uint16_t data)
+{
+	emit({ (uint8_t)data, (uint8_t)(data >> 8) });
+}
+
+void JIT::emit32(uint32_t data)
+{
+	emit16(data);
+	emit16(data >> 16);
+}
+
+void JIT::emit64(uint64_t data)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		Buffer[nBuffer++] = data >> (8 * i);
+	}
+}
+
+JITRun* JIT::translate(const BlockCache::MicroOp* op, uint32_t nOps)
+{
+#if JIT_X64
+	if (Memory == nullptr)
+	{
+		// Made executable a page at a time as code is copied in
+#ifdef _WIN32
+		Memory = (uint8_t*)VirtualAlloc(nullptr, MemorySize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+		void* p = mmap(nullptr, MemorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		Memory = p == MAP_FAILED ? nullptr : (uint8_t*)p;
+#endif
+		if (Memory == nullptr)
+		{
+			// No executable memory, stick to the interpreter
+			Enabled = false;
+			return nullptr;
+		}
+	}
+
+	JITRun run;
+	run.nInstructions = 0;
+	run.Length = 0;
+	run.Cycles = 0;
+	run.nWrites = 0;
+	run.Memory = false;
+
+	nBuffer = 0;
+	Exits.clear();
+
+	// Registers are accessed through rcx, which holds the first
+	// argument on Windows. r8 points to the flag table, r9 and r10
+	// to the page table and r11 to the write log.
+#ifndef _WIN32
+	emit({ 0x48, 0x89, 0xF9 });	// mov rcx, rdi
+#endif
+	emit({ 0x49, 0xB8 });	// mov r8, FlagTable
+	emit64((uint64_t)FlagTable);
+	emit({ 0x49, 0xB9 });	// mov r9, ReadPage
+	emit64((uint64_t)gb->ReadPage);
+	emit({ 0x49, 0xBA });	// mov r10, WritePage
+	emit64((uint64_t)gb->WritePage);
+	emit({ 0x49, 0xBB });	// mov r11, WriteLog
+	emit64((uint64_t)WriteLog);
+
+	if (nOps > sizeof(run.Remaining))
+	{
+		nOps = sizeof(run.Remaining);
+	}
+
+	uint8_t Cumulative[sizeof(run.Remaining)];
+
+	for (uint32_t i = 0; i < nOps; i++)
+	{
+		run.Writes[i] = run.nWrites;
+
+		if (!emitInstruction(op[i], run))
+		{
+			break;
+		}
+
+		uint8_t cycles = SM83::InstructionSet[op[i].Opcode].cycles;
+		if (op[i].Opcode == 0xCB)
+		{
+			cycles += SM83::InstructionSet16Bit[op[i].Operand].cycles;
+		}
+
+		Cumulative[i] = run.Cycles;
+		run.Cycles += cycles;
+		run.Length += op[i].Length;
+		run.nInstructions++;
+	}
+
+	// A single instruction isn't worth the overhead
+	if (run.nInstructions < 2)
+	{
+		return nullptr;
+	}
+
+	for (uint8_t i = 0; i < run.nInstructions; i++)
+	{
+		run.Remaining[i] = run.Cycles - Cumulative[i];
+	}
+
+	emit({ 0xB8 });	// mov eax, nInstructions
+	emit32(run.nInstructions);
+	emit({ 0xC3 });	// ret
+
+	// Each exit returns the number of instructions before the one
+	// which left, nothing has been changed by that one yet.
+	size_t Stub = 0;
+	for (size_t i = 0; i < Exits.size(); i++)
+	{
+		if (i == 0 || Exits[i].Instruction != Exits[i - 1].Instruction)
+		{
+			Stub = nBuffer;
+			emit({ 0xB8 });	// mov eax, Instruction
+			emit32(Exits[i].Instruction);
+			emit({ 0xC3 });	// ret
+		}
+
+		uint32_t rel = (uint32_t)(Stub - (Exits[i].At + 4));
+		memcpy(Buffer + Exits[i].At, &rel, 4);
+	}
+
+	if (Used + nBuffer > MemorySize)
+	{
+		return nullptr;
+	}
+
+	if (!protect(Used, nBuffer, true))
+	{
+		Enabled = false;
+		return nullptr;
+	}
+
+	memcpy(Memory + Used, Buffer, nBuffer);
+
+	if (!protect(Used, nBuffer, false))
+	{
+		Enabled = false;
+		return nullptr;
+	}
+
+	run.Code = reinterpret_cast<uint8_t (*)(JITRegisters*)>(Memory + Used);
+	Used += (nBuffer + 15) & ~(size_t)15;
+
+	nTranslated++;
+	Runs.push_back(run);
+
+	return &Runs.back();
+#else
+	return nullptr;
+#endif
+}
+
+bool JIT::protect(size_t Start, size_t Size, bool Writable)
+{
+#if JIT_X64
+	// Whole 4KB pages, code from earlier runs may share the first
+	size_t First = Start & ~(size_t)0xFFF;
+	size_t Length = Start + Size - First;
+
+#ifdef _WIN32
+	DWORD Old;
+	if (!VirtualProtect(Memory + First, Length, Writable ? PAGE_READWRITE : PAGE_EXECUTE_READ, &Old))
+	{
+		return false;
+	}
+
+	if (!Writable)
+	{
+		FlushInstructionCache(GetCurrentProcess(), Memory + First, Length);
+	}
+	return true;
+#else
+	return mprotect(Memory + First, Length, Writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC) == 0;
+#endif
+#else
+	return false;
+#endif
+}
+
+void JIT::undo(const JITRun* run, uint8_t First, uint8_t Done)
+{
+	uint8_t Last = Done < run->nInstructions ? run->Writes[Done] : run->nWrites;
+
+	// Latest first in case an address was written twice
+	for (uint8_t i = Last; i > run->Writes[First]; i--)
+	{
+		*WriteLog[i - 1].Where = WriteLog[i - 1].Old;
+	}
+}
+
+void JIT::emitExit(uint8_t Condition, uint8_t Instruction)
+{
+	emit({ 0x0F, Condition });	// jcc rel32
+	Exits.push_back({ nBuffer, Instruction });
+	emit32(0);
+}
+
+void JIT::emitRead(uint8_t Instruction)
+{
+	// OAM and IO registers have to be synced with the PPU
+	emit({ 0x3D });							// cmp eax, 0xFE00
+	emit32(0xFE00);
+	emitExit(0x83, Instruction);			// jae exit
+
+	emit({ 0x89, 0xC2 });					// mov edx, eax
+	emit({ 0xC1, 0xEA, 0x08 });				// shr edx, 8
+	emit({ 0x49, 0x8B, 0x14, 0xD1 });		// mov rdx, [r9 + rdx * 8]
+	emit({ 0x48, 0x85, 0xD2 });				// test rdx, rdx
+	emitExit(0x84, Instruction);			// jz exit
+
+	emit({ 0x0F, 0xB6, 0xC0 });				// movzx eax, al
+	emit({ 0x8A, 0x14, 0x02 });				// mov dl, [rdx + rax]
+}
+
+void JIT::emitWrite(JITRun& run)
+{
+	// As with reads, and VRAM too as the PPU
+	// could still have to draw with what's there.
+	emit({ 0x3D });							// cmp eax, 0xFE00
+	emit32(0xFE00);
+	emitExit(0x83, run.nInstructions);		// jae exit
+
+	emit({ 0x89, 0xC2 });					// mov edx, eax
+	emit({ 0xC1, 0xEA, 0x0D });				// shr edx, 13
+	emit({ 0x83, 0xFA, 0x04 });				// cmp edx, 4 (0x8000-0x9FFF)
+	emitExit(0x84, run.nInstructions);		// je exit
+
+	emit({ 0x89, 0xC2 });					// mov edx, eax
+	emit({ 0xC1, 0xEA, 0x08 });				// shr edx, 8
+	emit({ 0x49, 0x8B, 0x14, 0xD2 });		// mov rdx, [r10 + rdx * 8]
+	emit({ 0x48, 0x85, 0xD2 });				// test rdx, rdx
+	emitExit(0x84, run.nInstructions);		// jz exit
+
+	uint32_t Entry = run.nWrites * sizeof(JITWrite);
+
+	emit({ 0x0F, 0xB6, 0xC0 });				// movzx eax, al
+	emit({ 0x48, 0x01, 0xC2 });				// add rdx, rax
+	emit({ 0x49, 0x89, 0x93 });				// mov [r11 + Entry], rdx
+	emit32(Entry + offsetof(JITWrite, Where));
+	emit({ 0x8A, 0x02 });					// mov al, [rdx]
+	emit({ 0x41, 0x88, 0x83 });				// mov [r11 + Entry], al
+	emit32(Entry + offsetof(JITWrite, Old));
+
+	run.nWrites++;
+}
+
+void JIT::emitFlagsFromLAHF(uint8_t Keep, uint8_t Set)
+{
+	// The result has already been stored, the x86 flags
+	// are converted and merged with the SM83 flags kept
+	// from before the instruction.
+	emit({ 0x9F });							// lahf
+	emit({ 0x0F, 0xB6, 0xD4 });				// movzx edx, ah
+	emit({ 0x41, 0x8A, 0x14, 0x10 });		// mov dl, [r8 + rdx]
+
+	if (Keep != 0)
+	{
+		emit({ 0x80, 0xE2, (uint8_t)(0xB0 & ~Keep) });	// and dl, ~Keep
+		emit({ 0x8A, 0x41, F });			// mov al, [F]
+		emit({ 0x24, Keep });				// and al, Keep
+		emit({ 0x08, 0xC2 });				// or dl, al
+	}
+
+	if (Set != 0)
+	{
+		emit({ 0x80, 0xCA, Set });			// or dl, Set
+	}
+
+	emit({ 0x88, 0x51, F });				// mov [F], dl
+}
+
+void JIT::emitShiftFlags()
+{
+	// The result is in al and the bit shifted out is in
+	// the x86 carry flag. Z and CY are set, N and H cleared.
+	emit({ 0x0F, 0x92, 0xC2 });		// setc dl
+	emit({ 0x84, 0xC0 });			// test al, al
+	emit({ 0x0F, 0x94, 0xC0 });		// setz al
+	emit({ 0xC0, 0xE2, 0x04 });		// shl dl, 4
+	emit({ 0xC0, 0xE0, 0x07 });		// shl al, 7
+	emit({ 0x08, 0xC2 });			// or dl, al
+	emit({ 0x88, 0x51, F });		// mov [F], dl
+}
+
+bool JIT::emitInstruction(const BlockCache::MicroOp& op, JITRun& run)
+{
+	uint8_t o = op.Opcode;
+
+	// Address registers of LD (BC), A / LD A, (BC) and so on
+	static const uint8_t Indirect[4] = { 2, 4, 6, 6 };	// BC DE HL+ HL-
+
+	// ALU opcodes in the order add, adc, sub, sbc, and, xor, or, cp
+	static const uint8_t ALUrm[8] = { 0x02, 0x12, 0x2A, 0x1A, 0x22, 0x32, 0x0A, 0x3A };	// op al, r/m8
+	static const uint8_t ALUimm[8] = { 0x04, 0x14, 0x2C, 0x1C, 0x24, 0x34, 0x0C, 0x3C };	// op al, imm8
+
+	if (o == 0x00)	// NOP
+	{
+		return true;
+	}
+	else if (o >= 0x40 && o < 0x80)	// LD r, r'
+	{
+		uint8_t dst = GPROffset[(o >> 3) & 0b111];
+		uint8_t src = GPROffset[o & 0b111];
+
+		if (dst == 0xFF && src == 0xFF)
+		{
+			return false;	// HALT
+		}
+
+		if (src == 0xFF)	// LD r, (HL)
+		{
+			run.Memory = true;
+			emit({ 0x0F, 0xB7, 0x41, 6 });		// movzx eax, word [HL]
+			emitRead(run.nInstructions);
+			emit({ 0x88, 0x51, dst });			// mov [dst], dl
+		}
+		else if (dst == 0xFF)	// LD (HL), r
+		{
+			run.Memory = true;
+			emit({ 0x0F, 0xB7, 0x41, 6 });		// movzx eax, word [HL]
+			emitWrite(run);
+			emit({ 0x8A, 0x41, src });			// mov al, [src]
+			emit({ 0x88, 0x02 });				// mov [rdx], al
+		}
+		else
+		{
+			emit({ 0x8A, 0x41, src });			// mov al, [src]
+			emit({ 0x88, 0x41, dst });			// mov [dst], al
+		}
+		return true;
+	}
+	else if ((o & 0b11'000'111) == 0b00'000'110)	// LD r, n
+	{
+		uint8_t dst = GPROffset[(o >> 3) & 0b111];
+
+		if (dst == 0xFF)	// LD (HL), n
+		{
+			run.Memory = true;
+			emit({ 0x0F, 0xB7, 0x41, 6 });		// movzx eax, word [HL]
+			emitWrite(run);
+			emit({ 0xC6, 0x02, (uint8_t)op.Operand });	// mov byte [rdx], n
+			return true;
+		}
+
+		emit({ 0xC6, 0x41, dst, (uint8_t)op.Operand });	// mov byte [dst], n
+		return true;
+	}
+	else if ((o & 0b11'001'111) == 0b00'000'001)	// LD dd, nn
+	{
+		emit({ 0x66, 0xC7, 0x41, ssOffset[(o >> 4) & 0b11] });	// mov word [dd], nn
+		emit16(op.Operand);
+		return true;
+	}
+	else if (o == 0b11'111'001)	// LD SP, HL
+	{
+		emit({ 0x66, 0x8B, 0x41, 6 });		// mov ax, [HL]
+		emit({ 0x66, 0x89, 0x41, 8 });		// mov [SP], ax
+		return true;
+	}
+	else if ((o & 0b11'000'110) == 0b00'000'100)	// INC r / DEC r
+	{
+		uint8_t r = GPROffset[(o >> 3) & 0b111];
+
+		if (r == 0xFF)
+		{
+			return false;
+		}
+
+		if ((o & 1) == 0)
+		{
+			emit({ 0xFE, 0x41, r });		// inc byte [r]
+			emitFlagsFromLAHF(0x10, 0x00);
+		}
+		else
+		{
+			emit({ 0xFE, 0x49, r });		// dec byte [r]
+			emitFlagsFromLAHF(0x10, 0x40);
+		}
+		return true;
+	}
+	else if ((o & 0b11'001'111) == 0b00'000'011)	// INC ss
+	{
+		emit({ 0x66, 0xFF, 0x41, ssOffset[(o >> 4) & 0b11] });	// inc word [ss]
+		return true;
+	}
+	else if ((o & 0b11'001'111) == 0b00'001'011)	// DEC ss
+	{
+		emit({ 0x66, 0xFF, 0x49, ssOffset[(o >> 4) & 0b11] });	// dec word [ss]
+		return true;
+	}
+	else if ((o & 0b11'001'111) == 0b00'001'001)	// ADD HL, ss
+	{
+		uint8_t ss = ssOffset[(o >> 4) & 0b11];
+
+		// H and CY are bits 12 and 16 of HL ^ ss ^ (HL + ss)
+		emit({ 0x0F, 0xB7, 0x41, 6 });		// movzx eax, word [HL]
+		emit({ 0x0F, 0xB7, 0x51, ss });		// movzx edx, word [ss]
+		emit({ 0x01, 0xC2 });				// add edx, eax
+		emit({ 0x66, 0x33, 0x41, ss });		// xor ax, [ss]
+		emit({ 0x31, 0xD0 });				// xor eax, edx
+		emit({ 0x66, 0x89, 0x51, 6 });		// mov [HL], dx
+		emit({ 0xC1, 0xE8, 0x07 });			// shr eax, 7
+		emit({ 0x89, 0xC2 });				// mov edx, eax
+		emit({ 0x24, 0x20 });				// and al, 0x20
+		emit({ 0xC1, 0xEA, 0x05 });			// shr edx, 5
+		emit({ 0x80, 0xE2, 0x10 });			// and dl, 0x10
+		emit({ 0x08, 0xC2 });				// or dl, al
+		emit({ 0x8A, 0x41, F });			// mov al, [F]
+		emit({ 0x24, 0x80 });				// and al, 0x80
+		emit({ 0x08, 0xC2 });				// or dl, al
+		emit({ 0x88, 0x51, F });			// mov [F], dl
+		return true;
+	}
+	else if ((o >= 0x80 && o < 0xC0) || (o & 0b11'000'111) == 0b11'000'110)	// ALU A, r / ALU A, n
+	{
+		uint8_t alu = (o >> 3) & 0b111;
+		bool Immediate = o >= 0xC0;
+		uint8_t src = GPROffset[o & 0b111];
+
+		if (!Immediate && src == 0xFF)	// ALU A, (HL)
+		{
+			run.Memory = true;
+			emit({ 0x0F, 0xB7, 0x41, 6 });		// movzx eax, word [HL]
+			emitRead(run.nInstructions);
+		}
+
+		emit({ 0x8A, 0x41, A });			// mov al, [A]
+
+		if (alu == 1 || alu == 3)
+		{
+			emit({ 0x0F, 0xBA, 0x61, F, 4 });	// bt dword [F], 4 (CF <- CY)
+		}
+
+		if (Immediate)
+		{
+			emit({ ALUimm[alu], (uint8_t)op.Operand });	// op al, n
+		}
+		else if (src == 0xFF)
+		{
+			emit({ ALUrm[alu], 0xC2 });		// op al, dl
+		}
+		else
+		{
+			emit({ ALUrm[alu], 0x41, src });	// op al, [r]
+		}
+
+		switch (alu)
+		{
+		case 0:	// ADD
+		case 1:	// ADC
+			emit({ 0x88, 0x41, A });		// mov [A], al
+			emitFlagsFromLAHF(0x00, 0x00);
+			break;
+		case 2:	// SUB
+		case 3:	// SBC
+			emit({ 0x88, 0x41, A });		// mov [A], al
+			emitFlagsFromLAHF(0x00, 0x40);
+			break;
+		case 7:	// CP
+			emitFlagsFromLAHF(0x00, 0x40);
+			break;
+		default:	// AND, XOR, OR
+			emit({ 0x88, 0x41, A });		// mov [A], al
+			emit({ 0x0F, 0x94, 0xC2 });		// setz dl
+			emit({ 0xC0, 0xE2, 0x07 });		// shl dl, 7
+			if (alu == 4)
+			{
+				emit({ 0x80, 0xCA, 0x20 });	// or dl, 0x20 (H)
+			}
+			emit({ 0x88, 0x51, F });		// mov [F], dl
+			break;
+		}
+		return true;
+	}
+
+	switch (o)
+	{
+	case 0b00'000'010:	// LD (BC), A
+	case 0b00'010'010:	// LD (DE), A
+	case 0b00'100'010:	// LD (HL+), A
+	case 0b00'110'010:	// LD (HL-), A
+		run.Memory = true;
+		emit({ 0x0F, 0xB7, 0x41, Indirect[o >> 4] });	// movzx eax, word [rr]
+		emitWrite(run);
+		emit({ 0x8A, 0x41, A });			// mov al, [A]
+		emit({ 0x88, 0x02 });				// mov [rdx], al
+		if (o == 0b00'100'010)
+		{
+			emit({ 0x66, 0xFF, 0x41, 6 });	// inc word [HL]
+		}
+		else if (o == 0b00'110'010)
+		{
+			emit({ 0x66, 0xFF, 0x49, 6 });	// dec word [HL]
+		}
+		return true;
+	case 0b00'001'010:	// LD A, (BC)
+	case 0b00'011'010:	// LD A, (DE)
+	case 0b00'101'010:	// LD A, (HL+)
+	case 0b00'111'010:	// LD A, (HL-)
+		run.Memory = true;
+		emit({ 0x0F, 0xB7, 0x41, Indirect[o >> 4] });	// movzx eax, word [rr]
+		emitRead(run.nInstructions);
+		emit({ 0x88, 0x51, A });			// mov [A], dl
+		if (o == 0b00'101'010)
+		{
+			emit({ 0x66, 0xFF, 0x41, 6 });	// inc word [HL]
+		}
+		else if (o == 0b00'111'010)
+		{
+			emit({ 0x66, 0xFF, 0x49, 6 });	// dec word [HL]
+		}
+		return true;
+	case 0b11'101'010:	// LD (nn), A
+	case 0b11'111'010:	// LD A, (nn)
+		// IO registers and HRAM would never get through
+		if (op.Operand >= 0xFE00)
+		{
+			return false;
+		}
+
+		run.Memory = true;
+		emit({ 0xB8 });						// mov eax, nn
+		emit32(op.Operand);
+		if (o == 0b11'101'010)
+		{
+			emitWrite(run);
+			emit({ 0x8A, 0x41, A });		// mov al, [A]
+			emit({ 0x88, 0x02 });			// mov [rdx], al
+		}
+		else
+		{
+			emitRead(run.nInstructions);
+			emit({ 0x88, 0x51, A });		// mov [A], dl
+		}
+		return true;
+	case 0b00'000'111:	// RLCA
+	case 0b00'001'111:	// RRCA
+	case 0b00'010'111:	// RLA
+	case 0b00'011'111:	// RRA
+	{
+		static const uint8_t Rotate[4] = { 0xC0, 0xC8, 0xD0, 0xD8 };	// rol, ror, rcl, rcr
+
+		emit({ 0x8A, 0x41, A });			// mov al, [A]
+		if (o >= 0b00'010'111)
+		{
+			emit({ 0x0F, 0xBA, 0x61, F, 4 });	// bt dword [F], 4
+		}
+		emit({ 0xD0, Rotate[o >> 3] });	// rotate al, 1
+		emit({ 0x88, 0x41, A });			// mov [A], al
+		emit({ 0x0F, 0x92, 0xC2 });			// setc dl
+		emit({ 0xC0, 0xE2, 0x04 });			// shl dl, 4
+		emit({ 0x88, 0x51, F });			// mov [F], dl
+		return true;
+	}
+	case 0b00'101'111:	// CPL
+		emit({ 0xF6, 0x51, A });			// not byte [A]
+		emit({ 0x80, 0x49, F, 0x60 });		// or byte [F], 0x60
+		return true;
+	case 0b00'110'111:	// SCF
+		emit({ 0x80, 0x61, F, 0x80 });		// and byte [F], 0x80
+		emit({ 0x80, 0x49, F, 0x10 });		// or byte [F], 0x10
+		return true;
+	case 0b00'111'111:	// CCF
+		emit({ 0x80, 0x61, F, 0x90 });		// and byte [F], 0x90
+		emit({ 0x80, 0x71, F, 0x10 });		// xor byte [F], 0x10
+		return true;
+	case 0b11'001'011:	// 0xCB prefix
+	{
+		uint8_t cb = op.Operand;
+		uint8_t r = GPROffset[cb & 0b111];
+		uint8_t b = (cb >> 3) & 0b111;
+
+		if (r == 0xFF)
+		{
+			return false;	// (HL)
+		}
+
+		switch (cb >> 6)
+		{
+		case 0b00:	// Shift Instructions
+		{
+			// rol, ror, rcl, rcr, shl, sar, (swap), shr
+			static const uint8_t Shift[8] = { 0xC0, 0xC8, 0xD0, 0xD8, 0xE0, 0xF8, 0x00, 0xE8 };
+
+			emit({ 0x8A, 0x41, r });		// mov al, [r]
+
+			if (b == 0b110)	// SWAP
+			{
+				emit({ 0xC0, 0xC0, 0x04 });	// rol al, 4
+				emit({ 0x88, 0x41, r });	// mov [r], al
+				emit({ 0x84, 0xC0 });		// test al, al
+				emit({ 0x0F, 0x94, 0xC2 });	// setz dl
+				emit({ 0xC0, 0xE2, 0x07 });	// shl dl, 7
+				emit({ 0x88, 0x51, F });	// mov [F], dl
+				return true;
+			}
+
+			if (b == 0b010 || b == 0b011)
+			{
+				emit({ 0x0F, 0xBA, 0x61, F, 4 });	// bt dword [F], 4
+			}
+			emit({ 0xD0, Shift[b] });		// shift al, 1
+			emit({ 0x88, 0x41, r });		// mov [r], al
+			emitShiftFlags();
+			return true;
+		}
+		case 0b01:	// BIT b, r
+			emit({ 0x8A, 0x41, F });		// mov al, [F]
+			emit({ 0x24, 0x10 });			// and al, 0x10
+			emit({ 0x0C, 0x20 });			// or al, 0x20
+			emit({ 0xF6, 0x41, r, (uint8_t)(1 << b) });	// test byte [r], 1 << b
+			emit({ 0x0F, 0x94, 0xC2 });		// setz dl
+			emit({ 0xC0, 0xE2, 0x07 });		// shl dl, 7
+			emit({ 0x08, 0xC2 });			// or dl, al
+			emit({ 0x88, 0x51, F });		// mov [F], dl
+			return true;
+		case 0b10:	// RES b, r
+			emit({ 0x80, 0x61, r, (uint8_t)~(1 << b) });	// and byte [r], ~(1 << b)
+			return true;
+		case 0b11:	// SET b, r
+			emit({ 0x80, 0x49, r, (uint8_t)(1 << b) });	// or byte [r], 1 << b
+			return true;
+		}
+		return false;
+	}
+	default:
+		// Jumps, the stack, IO, DAA, interrupt control etc.
+		return false;
+	}
+}
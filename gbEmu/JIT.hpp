@@ -0,0 +1,148 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include "BlockCache.hpp"
+
+class GBInternal;
+
+// Register file handed to translated code, laid out
+// the same way as the registers in SM83.
+struct JITRegisters
+{
+	uint16_t AF, BC, DE, HL, SP;
+};
+
+// A byte written by translated code and what it held before
+struct JITWrite
+{
+	uint8_t* Where;
+	uint8_t Old;
+};
+
+// A run of translated instructions
+struct JITRun
+{
+	// Returns the number of instructions run. It stops before
+	// any which accesses memory the page table doesn't cover.
+	uint8_t (*Code)(JITRegisters* r);
+
+	uint8_t nInstructions;
+	uint8_t Length;		// Bytes of SM83 code covered
+	uint8_t Cycles;		// Machine cycles taken by the whole run
+	uint8_t nWrites;	// Bytes written by the whole run
+	bool Memory;		// Whether any instruction accesses memory
+
+	// Machine cycles left in the run when the interpreter
+	// would fetch each instruction. Used to find out which
+	// instruction an interrupt would have arrived at.
+	uint8_t Remaining[32];
+
+	// Bytes written by the instructions before each one
+	uint8_t Writes[32];
+};
+
+/// <summary>
+/// Translates runs of SM83 instructions in cartridge ROM into
+/// x86-64 machine code. Only instructions which touch nothing but
+/// the CPU registers (loads between registers, 8 and 16-bit
+/// arithmetic, rotates and bit operations) or plain memory are
+/// translated so a run can execute all at once at the first 
+/// instruction's fetch without anything else in the system 
+/// noticing. Loads and stores go through GBInternal's page table
+/// and the run stops short at any access to a page which isn't
+/// mapped, to OAM and IO or a write to VRAM, as those have to be 
+/// synced with the PPU. The cycles are then counted down as usual
+/// so the PPU, Timer and APU see the same timing as with the 
+/// interpreter. If an interrupt becomes pending part way through
+/// a run the CPU rolls back, undoing all the run's writes, and lets
+/// the interpreter redo the instructions which would have executed
+/// before the interrupt was taken. Code in RAM, jumps and the
+/// stack are left to the interpreter. On other architectures 
+/// nothing is ever translated.
+/// </summary>
+class JIT
+{
+public:
+	JIT();
+	~JIT();
+
+	GBInternal* gb;
+
+	void connectGB(GBInternal* gb);
+
+	bool Enabled = false;
+
+	// Number of times an instruction is fetched
+	// from the block cache before it's translated
+	uint8_t Threshold = 16;
+
+	// Returns the translated run starting at op or nullptr if
+	// it should be interpreted. nFollowing is the number of
+	// instructions after op in the same block.
+	const JITRun* lookup(BlockCache::MicroOp* op, uint32_t nFollowing);
+
+	uint64_t nTranslated = 0;	// Runs translated
+	uint64_t nRuns = 0;			// Runs executed
+	uint64_t nInstructions = 0;	// Instructions executed by translated code
+	uint64_t nRollbacks = 0;	// Runs interrupted part way through
+	uint64_t nExits = 0;		// Runs stopped by a memory access
+
+	// Where the last run wrote, in order
+	JITWrite WriteLog[32];
+
+	// Puts back what instructions First up to Done of run overwrote,
+	// latest first. A rollback undoes the whole run from 0.
+	void undo(const JITRun* run, uint8_t First, uint8_t Done);
+
+private:
+	uint8_t* Memory = nullptr;
+	size_t MemorySize = 16 * 1024 * 1024;
+	size_t Used = 0;
+
+	std::deque<JITRun> Runs;
+
+	// Converts the flags stored by LAHF into the SM83 F register
+	uint8_t FlagTable[256];
+
+	JITRun* translate(const BlockCache::MicroOp* op, uint32_t nOps);
+
+	// Switches the arena pages between writable and executable,
+	// they're never both. Returns false if that isn't allowed.
+	bool protect(size_t Start, size_t Size, bool Writable);
+
+	// Returns false if the instruction can't be translated.
+	// It's emitted as instruction number nInstructions of run.
+	bool emitInstruction(const BlockCache::MicroOp& op, JITRun& run);
+
+	// Machine code is assembled here before being copied
+	// into executable memory.
+	uint8_t Buffer[4096];
+	size_t nBuffer;
+
+	void emit(std::initializer_list<uint8_t> bytes);
+	void emit16(uint16_t data);
+	void emit32(uint32_t data);
+	void emit64(uint64_t data);
+
+	// Jumps leaving a run, the rel32 at At is patched to point at
+	// code returning the number of instructions before Instruction.
+	struct Exit
+	{
+		size_t At;
+		uint8_t Instruction;
+	};
+	std::vector<Exit> Exits;
+
+	void emitExit(uint8_t Condition, uint8_t Instruction);
+
+	// Common instruction sequences
+	void emitFlagsFromLAHF(uint8_t Keep, uint8_t Set);
+	void emitShiftFlags();
+
+	// The address is in eax. Reads leave the byte in dl, writes leave
+	// a pointer to it in rdx after logging what it held.
+	void emitRead(uint8_t Instruction);
+	void emitWrite(JITRun& run);
+};
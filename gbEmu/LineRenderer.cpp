@@ -0,0 +1,216 @@
+#include "LineRenderer.hpp"
+#include "TileCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+bool LineRenderer::draw(Snapshot& s, uint8_t* Line)
+{
+	// Nothing the PPU reads changes for the rest of the stretch, so
+	// the registers, palettes and tile rows are looked up once instead
+	// of for every dot. The dots are only sorted into layers here, the
+	// compositor then works out the colour of the whole stretch at once.
+	uint8_t BGShades[4], ObjectShades[8];	// BGP and OBP0 followed by OBP1
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		BGShades[i] = (s.BGP >> (i * 2)) & 0b11;
+		ObjectShades[i] = (s.OBP0 >> (i * 2)) & 0b11;
+		ObjectShades[4 + i] = (s.OBP1 >> (i * 2)) & 0b11;
+	}
+
+	bool bBG = s.LCDC & 0x01;
+	bool bOBJ = s.LCDC & 0x02;
+	bool OBJ8x16 = s.LCDC & 0x04;
+	bool BGCodeArea = s.LCDC & 0x08;
+	bool BGCharData = s.LCDC & 0x10;
+	bool bWindowing = s.LCDC & 0x20;
+	bool WindowCodeArea = s.LCDC & 0x40;
+
+	// With the background off every background pixel is white
+	// and objects with priority are hidden behind it.
+	uint8_t BGIndex = 0;
+	if (!bBG)
+	{
+		memset(BGShades, 0, sizeof(BGShades));
+		BGIndex = 1;
+	}
+
+	bool bObjects = bOBJ && !s.DMAinProgress;
+	bool bWindow = bBG && bWindowing && s.LY >= s.WY;
+	int WindowStart = s.WX - 7;
+
+	uint16_t BGBaseAddr = BGCharData ? 0x8000 : 0x9000;
+	uint16_t BGCodesBaseAddr = BGCodeArea ? 0x9C00 : 0x9800;
+	uint16_t WindowCodesBaseAddr = WindowCodeArea ? 0x9C00 : 0x9800;
+	uint8_t BGLineY = (s.LY + s.SCY) % 256;
+
+	// First object covering each pixel, the objects are sorted
+	// by x-coordinate so earlier ones take priority.
+	int8_t ObjectAt[20 * 8];
+	memset(ObjectAt, -1, sizeof(ObjectAt));
+
+	if (bObjects)
+	{
+		for (uint8_t i = 0; i < s.nObjects; i++)
+		{
+			int Left = std::max(s.Objects[i][1] - 8, 0);
+			int Right = std::min((int)s.Objects[i][1], 20 * 8);
+
+			for (int x = Left; x < Right; x++)
+			{
+				if (ObjectAt[x] < 0)
+				{
+					ObjectAt[x] = i;
+				}
+			}
+		}
+	}
+
+	// Tile rows are fetched when an object is first drawn and
+	// when the background or window moves on to the next tile.
+	uint8_t ObjectRow[10][8];
+	bool ObjectFetched[10] = { false };
+
+	int BGTile = -1, WindowTile = -1;
+	const uint8_t* BGRow = nullptr;
+	const uint8_t* WindowRow = nullptr;
+
+	Compositor::Layers Layers;
+	int First = s.LX;
+	int LX = s.LX;
+
+	for (uint32_t nDots = s.nDots; nDots > 0; nDots--)
+	{
+		if (s.Delay > 0)
+		{
+			s.Delay -= 1;
+			continue;
+		}
+
+		bool FoundObject = false;
+		bool ObjectPriorityConflict = false;
+
+		Layers.Object[LX] = 0;
+		Layers.Priority[LX] = 0;
+		Layers.BG[LX] = BGIndex;
+
+		// ============ Sprite Display ============
+		int8_t i = ObjectAt[LX];
+		if (i >= 0)
+		{
+			uint8_t* Obj = s.Objects[i];
+			uint8_t YPos = Obj[0], XPos = Obj[1];
+			bool Palette = Obj[3] & 0x10;
+			bool XFlip = Obj[3] & 0x20;
+			bool YFlip = Obj[3] & 0x40;
+			bool Priority = Obj[3] & 0x80;
+
+			if (!ObjectFetched[i])
+			{
+				int TileRow;
+				uint8_t TileHeight = OBJ8x16 ? 16 : 8;
+				if (YFlip)
+				{
+					TileRow = (TileHeight - 1) - (s.LY - (YPos - 16));
+				}
+				else
+				{
+					TileRow = s.LY - (YPos - 16);
+				}
+
+				if (OBJ8x16)
+				{
+					Obj[2] &= 0xFE;
+				}
+
+				const uint8_t* Row = tileCache->row(0x8000 + Obj[2] * 0x10 + TileRow * 2, XFlip);
+				memcpy(ObjectRow[i], Row, 8);
+				ObjectFetched[i] = true;
+			}
+
+			uint8_t PixelPalette = ObjectRow[i][LX - (XPos - 8)];
+
+			// Index 0 is always transparent
+			if (PixelPalette != 0)
+			{
+				FoundObject = true;
+				ObjectPriorityConflict = Priority;
+				Layers.Object[LX] = Palette * 4 + PixelPalette;
+				Layers.Priority[LX] = Priority ? 0xFF : 0;
+			}
+		}
+
+		if (!FoundObject || ObjectPriorityConflict)
+		{
+			if (bWindow && LX >= WindowStart)
+			{
+				// ============ Window Display ============
+				uint8_t LineX = LX - WindowStart;
+
+				// First pixel of the window
+				if (LineX == 0)
+				{
+					s.Delay = 6;
+				}
+
+				if (LineX / 8 != WindowTile)
+				{
+					WindowTile = LineX / 8;
+
+					uint8_t CHRCode = RAM[WindowCodesBaseAddr + (int)(s.WLY / 8) * 32 + WindowTile];
+					int16_t CHRCodeOffset = BGCharData ? (uint8_t)CHRCode : (int8_t)CHRCode;
+
+					WindowRow = tileCache->row(BGBaseAddr + CHRCodeOffset * 0x10 + (s.WLY % 8) * 2, false);
+				}
+
+				Layers.BG[LX] = WindowRow[LineX % 8];
+			}
+			else if (bBG)
+			{
+				// ============ Background Display ============
+				uint8_t LineX = (LX + s.SCX) % 256;
+
+				if (LineX / 8 != BGTile)
+				{
+					BGTile = LineX / 8;
+
+					uint8_t CHRCode = RAM[BGCodesBaseAddr + (int)(BGLineY / 8) * 32 + BGTile];
+					int16_t CHRCodeOffset = BGCharData ? (uint8_t)CHRCode : (int8_t)CHRCode;
+
+					BGRow = tileCache->row(BGBaseAddr + CHRCodeOffset * 0x10 + (BGLineY % 8) * 2, false);
+				}
+
+				Layers.BG[LX] = BGRow[LineX % 8];
+			}
+		}
+
+		LX += 1;
+	}
+
+	s.LX = LX;
+
+	// Composed separately so the line is only marked
+	// as changed when it's different to last frame.
+	uint8_t Pixels[20 * 8];
+	compositor.compose(Layers, BGShades, ObjectShades, First, LX, Pixels);
+
+	if (memcmp(Line + First, Pixels + First, LX - First) == 0)
+	{
+		return false;
+	}
+
+	memcpy(Line + First, Pixels + First, LX - First);
+	return true;
+}
+
+void LineRenderer::markDirty(std::atomic<uint64_t>* DirtyLines, uint8_t Line)
+{
+	uint64_t Bit = 1ull << (Line % 64);
+
+	// Lines are usually already marked,
+	// skip the locked instruction if so.
+	if ((DirtyLines[Line / 64].load(std::memory_order_relaxed) & Bit) == 0)
+	{
+		DirtyLines[Line / 64].fetch_or(Bit, std::memory_order_relaxed);
+	}
+}
\ No newline at end of file
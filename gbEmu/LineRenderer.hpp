@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include "Compositor.hpp"
+
+class TileCache;
+
+/// <summary>
+/// Draws a stretch of a line during which nothing the PPU reads
+/// changes. Everything drawing depends on apart from VRAM is taken
+/// from a snapshot of the PPU made when the stretch ends, so the
+/// same stretch can be drawn by the PPU straight away or later on
+/// by a RenderThread with its own copy of VRAM. Either way every
+/// pixel ends up the same as drawing a dot at a time.
+/// </summary>
+class LineRenderer
+{
+public:
+	struct Snapshot
+	{
+		uint8_t LY, WLY;
+		uint8_t LCDC, SCX, SCY, WX, WY, BGP, OBP0, OBP1;
+		bool DMAinProgress;
+
+		int LX;				// Pixel the stretch starts at
+		uint32_t Delay;		// Dots before drawing carries on
+		uint32_t nDots;		// Length of the stretch
+
+		// OAM entries of the objects on the line, in
+		// the order they were sorted into for drawing.
+		uint8_t nObjects;
+		uint8_t Objects[10][4];
+	};
+
+	// VRAM and tiles are read from here
+	const uint8_t* RAM = nullptr;
+	TileCache* tileCache = nullptr;
+
+	Compositor compositor;
+
+	// Draws the stretch into Line (a line of DotMatrix) and leaves LX,
+	// Delay and the tile index of 8x16 objects in the snapshot as the
+	// PPU is left after drawing it. Returns false if no pixel changed.
+	bool draw(Snapshot& s, uint8_t* Line);
+
+	// Marks a line of DotMatrix as changed in a set of three
+	// 64-bit masks, safe to call from any thread.
+	static void markDirty(std::atomic<uint64_t>* DirtyLines, uint8_t Line);
+};
\ No newline at end of file
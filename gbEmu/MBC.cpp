@@ -106,4 +106,14 @@ MBC::~MBC()
 {
 	delete[] ROM;
 	delete[] RAM;
+}
+
+uint8_t* MBC::RAMPage(uint16_t /*addr*/, bool /*Write*/)
+{
+	return nullptr;
+}
+
+uint8_t* MBC::RAMAt(uint32_t Offset)
+{
+	return Offset + 0x100 <= (uint32_t)RAMSizeBytes ? RAM + Offset : nullptr;
 }
\ No newline at end of file
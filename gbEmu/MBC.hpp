@@ -19,4 +19,16 @@ public:
 
 	virtual void write(uint16_t addr, uint8_t data) = 0;
 	virtual uint8_t read(uint16_t addr) = 0;
+
+	// Returns the ROM bank currently mapped to addr (0x0000-0x7FFF)
+	virtual uint32_t ROMBank(uint16_t addr) = 0;
+
+	// Returns where the 256 byte page of cartridge RAM at addr
+	// (0xA000-0xBFFF) is stored, or nullptr if reading or writing
+	// it does more than access RAM (disabled, RTC registers, ...).
+	virtual uint8_t* RAMPage(uint16_t addr, bool Write);
+
+protected:
+	// RAM + Offset or nullptr if the page doesn't fit in RAM
+	uint8_t* RAMAt(uint32_t Offset);
 };
\ No newline at end of file
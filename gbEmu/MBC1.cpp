@@ -106,3 +106,28 @@ uint8_t MBC1::read(uint16_t addr)
 
 	return 0x00;
 }
+
+uint32_t MBC1::ROMBank(uint16_t addr)
+{
+	if (addr < 0x4000)
+	{
+		return bBankingMode == 0 ? 0 : (UpperROMBankCode << 5) & ROMMask;
+	}
+
+	return ((UpperROMBankCode << 5) | ROMBankCode) & ROMMask;
+}
+
+uint8_t* MBC1::RAMPage(uint16_t addr, bool /*Write*/)
+{
+	if (!RAMEnable || nRAMBanks == 0)
+	{
+		return nullptr;
+	}
+
+	if (bBankingMode == 0)
+	{
+		return RAMAt(addr % 0xA000);
+	}
+
+	return RAMAt(((UpperROMBankCode & RAMMask) * 0x2000) + (addr % 0xA000));
+}
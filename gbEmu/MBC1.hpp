@@ -10,6 +10,8 @@ public:
 
 	virtual void write(uint16_t addr, uint8_t data) override;
 	virtual uint8_t read(uint16_t addr) override;
+	virtual uint32_t ROMBank(uint16_t addr) override;
+	virtual uint8_t* RAMPage(uint16_t addr, bool Write) override;
 
 	// Registers
 	uint8_t ROMBankCode, UpperROMBankCode, bBankingMode;
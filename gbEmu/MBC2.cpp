@@ -67,4 +67,20 @@ uint8_t MBC2::read(uint16_t addr)
 	}
 
 	return 0x00;
+}
+
+uint32_t MBC2::ROMBank(uint16_t addr)
+{
+	return addr < 0x4000 ? 0 : ROMBankCode;
+}
+
+uint8_t* MBC2::RAMPage(uint16_t addr, bool /*Write*/)
+{
+	if (!RAMEnable || nRAMBanks == 0)
+	{
+		return nullptr;
+	}
+
+	// 0xA200-0xBFFF echo 0xA000-0xA1FF
+	return RAMAt(addr % 0x0200);
 }
\ No newline at end of file
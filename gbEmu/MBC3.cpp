@@ -187,4 +187,20 @@ uint8_t MBC3::read(uint16_t addr)
 
 
 	return 0x00;
+}
+
+uint32_t MBC3::ROMBank(uint16_t addr)
+{
+	return addr < 0x4000 ? 0 : ROMBankCode;
+}
+
+uint8_t* MBC3::RAMPage(uint16_t addr, bool Write)
+{
+	// RAM can be written while it's disabled
+	if (!MappingRAM || (!Write && (!RAMEnable || nRAMBanks == 0)))
+	{
+		return nullptr;
+	}
+
+	return RAMAt((RAMBankCode * 0x2000) + (addr % 0xA000));
 }
\ No newline at end of file
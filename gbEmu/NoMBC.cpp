@@ -21,3 +21,9 @@ uint8_t NoMBC::read(uint16_t addr)
 
 	return 0x00;
 }
+
+
+uint32_t NoMBC::ROMBank(uint16_t addr)
+{
+	return addr >> 14;
+}
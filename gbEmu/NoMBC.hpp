@@ -11,4 +11,5 @@ public:
 
 	virtual void write(uint16_t addr, uint8_t data) override;
 	virtual uint8_t read(uint16_t addr) override;
+	virtual uint32_t ROMBank(uint16_t addr) override;
 };
\ No newline at end of file
@@ -6,8 +6,34 @@ Noise::Noise(uint8_t ChannelNum) : SoundChannel(ChannelNum)
 	LFSR = 0xFFFF;
 }
 
-void Noise::clock()
+bool Noise::clock(uint64_t Cycle)
 {
+	bool Stepped = false;
+
+	// Increments divider which controls 
+	// period duration of wave.
+	if (Cycle % modOp() == 0)
+	{
+		// Shift LFSR
+		if ((++ClockEntrances % clockDiv()) == 0)
+		{
+			ClockEntrances = 0;
+			shift();
+			Stepped = true;
+		}
+	}
+
+	// The rest only depends on the registers and the frame
+	// sequencer so it's only re-evaluated after a register was 
+	// written or the frame sequencer clocked a unit, in which
+	// case it's evaluated again on the next T-cycle as well.
+	if (!Dirty && gb->apu.Steps == 0)
+	{
+		return Stepped;
+	}
+
+	Dirty = gb->apu.Steps != 0;
+
 	// Check if DAC is off, according to 
 	// PanDocs it is on if and only if
 	// NRx2 & 0xF8 != 0. 
@@ -22,39 +48,6 @@ void Noise::clock()
 		Mute = false;
 	}
 
-	// Increments divider which controls 
-	// period duration of wave.
-
-	// If divider = 0 then it is treated as 0.5
-	uint8_t ModOp = 4 + NR43->ClockShift;
-	if (NR43->ClockDiv == 0)
-	{
-		ModOp -= 1;
-	}
-
-	if (gb->nClockCycles % ModOp == 0)
-	{
-		// Shift LFSR
-		if ((++ClockEntrances % (NR43->ClockDiv == 0 ? 1 : NR43->ClockDiv)) == 0)
-		{
-			ClockEntrances = 0;
-
-			// XOR 2 least significant and place.
-			bool XORRes = LFSR.Bit0 ^ LFSR.Bit1;
-
-			// Place result in appropriate slots
-			if (NR43->LFSRWidth) // Short mode
-			{
-				LFSR.Bit7 = XORRes;
-			}
-
-			LFSR.Bit15 = XORRes;
-
-			// Shift the entire shift register to the right
-			LFSR.reg >>= 1;
-		}
-	}
-
 	// ================= Length Counter ================= 
 	if (!LenCounterOn && NR44->LenEnable)
 	{
@@ -67,7 +60,7 @@ void Noise::clock()
 		LenCounterOn = false;
 	}
 
-	if (gb->nClockCycles % (1 << 14) == 0 && NR44->LenEnable)	// Called at 256Hz
+	if ((gb->apu.Steps & APU::LengthStep) && NR44->LenEnable)	// Called at 256Hz
 	{
 		if (LenCount++ == 64)
 		{
@@ -100,7 +93,7 @@ void Noise::clock()
 	}
 
 	// TODO: Fix EnvelopeEntrances stuff
-	if (EnvelopeOn && gb->nClockCycles % (1 << 16) == 0 && (++EnvelopeEntrances % NR42->SweepPace == 0))	// Called at 64Hz
+	if (EnvelopeOn && (gb->apu.Steps & APU::EnvelopeStep) && (++EnvelopeEntrances % NR42->SweepPace == 0))	// Called at 64Hz
 	{
 		// Based on the pace we increment the volume
 		if (NR42->EnvDir == 0)	// Decrease volume
@@ -120,6 +113,66 @@ void Noise::clock()
 			}
 		}
 	}
+
+	return true;
+}
+
+uint8_t Noise::modOp()
+{
+	// If divider = 0 then it is treated as 0.5
+	uint8_t ModOp = 4 + NR43->ClockShift;
+	if (NR43->ClockDiv == 0)
+	{
+		ModOp -= 1;
+	}
+
+	return ModOp;
+}
+
+uint8_t Noise::clockDiv()
+{
+	return NR43->ClockDiv == 0 ? 1 : NR43->ClockDiv;
+}
+
+void Noise::shift()
+{
+	// XOR 2 least significant and place.
+	bool XORRes = LFSR.Bit0 ^ LFSR.Bit1;
+
+	// Place result in appropriate slots
+	if (NR43->LFSRWidth) // Short mode
+	{
+		LFSR.Bit7 = XORRes;
+	}
+
+	LFSR.Bit15 = XORRes;
+
+	// Shift the entire shift register to the right
+	LFSR.reg >>= 1;
+}
+
+uint64_t Noise::nextStep(uint64_t From)
+{
+	// The LFSR shifts on every ClockDiv'th T-cycle which 
+	// is a multiple of ModOp.
+	return nthTick(From, modOp(), clockDiv() - ClockEntrances % clockDiv());
+}
+
+void Noise::skip(uint64_t From, uint64_t To)
+{
+	uint64_t nTicks = ticks(From, To, modOp());
+	uint64_t nUntilShift = clockDiv() - ClockEntrances % clockDiv();
+
+	while (nTicks >= nUntilShift)
+	{
+		nTicks -= nUntilShift;
+		nUntilShift = clockDiv();
+
+		ClockEntrances = 0;
+		shift();
+	}
+
+	ClockEntrances += (uint8_t)nTicks;
 }
 
 uint8_t Noise::GetSample()
@@ -10,7 +10,9 @@ public:
 	~Noise();
 
 	virtual uint8_t GetSample() override;
-	void clock();
+	bool clock(uint64_t Cycle) override;
+	uint64_t nextStep(uint64_t From) override;
+	void skip(uint64_t From, uint64_t To) override;
 	void trigger() override;
 
 	// Registers
@@ -105,5 +107,14 @@ public:
 	} LFSR;
 
 	uint8_t ClockEntrances = 0;
+
+private:
+	// The LFSR is clocked on every clockDiv()'th 
+	// T-cycle which is a multiple of modOp().
+	uint8_t modOp();
+	uint8_t clockDiv();
+
+	// Shifts the LFSR once
+	void shift();
 };
 
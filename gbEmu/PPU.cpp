@@ -2,8 +2,10 @@
 #include "GBInternal.hpp"
 
 #include <algorithm>
+#include <cstring>
 
-void PPU::connectGB(GBInternal* gb)
+template <class Renderer>
+void BasicPPU<Renderer>::connectGB(GBInternal* gb)
 {
 	this->gb = gb;
 
@@ -23,13 +25,25 @@ void PPU::connectGB(GBInternal* gb)
 	WY = gb->RAM + 0xFF4A;
 	WX = gb->RAM + 0xFF4B;
 
+	lineRenderer.RAM = gb->RAM;
+	lineRenderer.tileCache = &gb->tileCache;
+
 	// Set-up pixel rendering
 	Mode = VerticalBlank;
 	DotsRemaining = 0;
 	DotsTotal = 0;
+
+	wake();
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::wake()
+{
+	gb->scheduler.schedule(Scheduler::PPUDot, gb->nClockCycles);
 }
 
-void PPU::setLY(uint8_t v)
+template <class Renderer>
+void BasicPPU<Renderer>::setLY(uint8_t v)
 {
 	*LY = v % 154;
 
@@ -37,16 +51,21 @@ void PPU::setLY(uint8_t v)
 	if (*LY == 0)
 	{
 		gb->IF->VerticalBlanking = 0;
+
+		startFrame();
 	}
 	else if (*LY == 144)
 	{
 		// Alert CPU that PPU is in vertical blanking period
 		gb->IF->VerticalBlanking = 1;
 		gb->IF->LCDC = 1;
+
+		gb->endFrame();
 	}
 }
 
-void PPU::clock()
+template <class Renderer>
+void BasicPPU<Renderer>::clock()
 {
 	// Checks if ppu is off
 	/*if (LCDC->bLCDC == 0)
@@ -54,6 +73,13 @@ void PPU::clock()
 		return;
 	}*/
 
+	// Nothing but the dot counts changed during the dots
+	// which were skipped since the PPU was last clocked.
+	int DotsSkipped = gb->nClockCycles - NextDot;
+	DotsTotal += DotsSkipped;
+	DotsRemaining -= DotsSkipped;
+	NextDot = gb->nClockCycles + 1;
+
 	// LY == LYC is checked contiuously during OAMScan
 	// Checks if scan line has reached value
 	// stored in LYC. This can happen any time 
@@ -87,7 +113,8 @@ void PPU::clock()
 	// if DotsRemaining == 0 then we are at the 
 	// end of the current mode and we should
 	// proceed to the next.
-	if (DotsRemaining == 0)
+	bool ModeChanged = DotsRemaining == 0;
+	if (ModeChanged)
 	{	
 		// Determine next mode
 		switch (Mode)
@@ -96,6 +123,28 @@ void PPU::clock()
 			Mode = DrawingPixels;
 			break;
 		case DrawingPixels:
+			// The whole line is drawn at once when
+			// nothing it depends on changed during it.
+			if (LineBatched)
+			{
+				if (Threaded)
+				{
+					logLine(gb->nClockCycles - LineStart);
+					renderThread.submit();
+				}
+				else if (Rendering)
+				{
+					drawLine(gb->nClockCycles - LineStart);
+				}
+				else
+				{
+					skipLine(gb->nClockCycles - LineStart);
+				}
+
+				batchLine(false);
+				nLinesBatched++;
+			}
+
 			Mode = HorizontalBlank;
 			break;
 		case HorizontalBlank:
@@ -139,57 +188,22 @@ void PPU::clock()
 			// transfer is in progress.
 			if (DotsTotal == 0 && !gb->dma.DMAinProgress)
 			{
-				nScanLineObjects = 0;
-				// Find objects which cover current pixel to be drawn
-				// TODO: Overlap priorities
-				for (uint8_t i = 0; i < 40; i++)
-				{
-					Object* Obj = reinterpret_cast<Object*>(&gb->RAM[0xFE00 + i * 4]);
-
-					// Check if sprite overlaps in y-direction
-					if (LCDC->OBJ8x16)	// Sprites 2 tiles tall
-					{
-						if (Obj->YPos > *LY && Obj->YPos - 16 <= *LY)
-						{
-							FoundObject = true;
-						}
-					}
-					else
-					{
-						if (Obj->YPos - 8 > *LY && Obj->YPos - 16 <= *LY)
-						{
-							FoundObject = true;
-						}
-					}
-
-					if (FoundObject)
-					{
-						FoundObject = false;
-						ScanLineObjects[nScanLineObjects] = Obj;
-
-						// Maximum number of objects per scanline is 10
-						if (++nScanLineObjects == 10)
-						{
-							break;
-						}
-					}
-
-				}
-
-				// To more easily determine priorities we order the objects
-				// based on x-ccordinate while keeping sprites with the same
-				// x-ccordinate in the same order relative to how they were in
-				// the OAM.
-				std::stable_sort(
-					ScanLineObjects,
-					ScanLineObjects + nScanLineObjects,
-					[](Object* e1, Object* e2) { return e1->XPos < e2->XPos; }
-				);
+				findObjects();
 			}
 
 			break;
 
 		case DrawingPixels:
+			if (Renderer::Fifo)
+			{
+				// Ends once the FIFO has shifted out the whole line
+				DotsRemaining = 456;
+				STAT->ModeFlag = 0b11;
+				LX = 0;
+				startFifo();
+				break;
+			}
+
 			DotsRemaining = 160;
 
 			// At the start there are delays in mode 3 due to:
@@ -203,6 +217,14 @@ void PPU::clock()
 			bLineRendered = false;
 			LX = 0;
 
+			// Drawing starts on this dot. Lines which aren't drawn 
+			// here are always batched, there's little to do for them.
+			if (Renderer::Batched || !Rendering || Threaded)
+			{
+				LineStart = gb->nClockCycles;
+				batchLine(true);
+			}
+
 			break;
 
 		case VerticalBlank:
@@ -229,7 +251,8 @@ void PPU::clock()
 			gb->IF->LCDC = STAT->Mode00Selection;
 
 			// If window was visible on the current scanline, then increment WLY;
-			if (LCDC->bBG && LCDC->bWindowing && LX >= *WX - 7 && *LY >= *WY)
+			bool WindowVisible = LCDC->bBG && LCDC->bWindowing && LX >= *WX - 7 && *LY >= *WY;
+			if (Renderer::Fifo ? WindowDrawn : WindowVisible)
 			{
 				WLY++;
 			}
@@ -247,223 +270,880 @@ void PPU::clock()
 	case OAMScan:
 		break;
 	case DrawingPixels:
+		// Batched lines are drawn when mode 3 ends
+		if (Renderer::Fifo)
+		{
+			if (fifoDot())
+			{
+				DotsRemaining = 0;
+			}
+		}
+		else if (!LineBatched)
+		{
+			if (Rendering)
+			{
+				drawDot();
+			}
+			else
+			{
+				skipLine(1);
+			}
+		}
+
+		break;
+	}
+
+	// Pixels are drawn every dot unless the line is batched. Otherwise 
+	// the PPU only needs to be clocked again at the next mode change, 
+	// except straight after one since LY may have changed and has to 
+	// be compared with LYC.
+	uint64_t Next = NextDot;
+	if ((Mode != DrawingPixels || LineBatched) && !ModeChanged && DotsRemaining >= 0)
+	{
+		Next += DotsRemaining;
+	}
+
+	gb->scheduler.schedule(Scheduler::PPUDot, Next);
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::findObjects()
+{
+	if (!ObjectIndex)
+	{
+		scanObjects();
+		return;
+	}
+
+	if (!ObjectIndexValid || ObjectIndex8x16 != LCDC->OBJ8x16)
+	{
+		buildObjectIndex();
+	}
+
+	nScanLineObjects = nLineObjects[*LY];
+	for (uint8_t i = 0; i < nScanLineObjects; i++)
+	{
+		ScanLineObjects[i] = reinterpret_cast<Object*>(&gb->RAM[0xFE00 + LineObjects[*LY][i] * 4]);
+	}
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::scanObjects()
+{
+	nScanLineObjects = 0;
+	// Find objects which cover current pixel to be drawn
+	// TODO: Overlap priorities
+	for (uint8_t i = 0; i < 40; i++)
 	{
+		Object* Obj = reinterpret_cast<Object*>(&gb->RAM[0xFE00 + i * 4]);
 
-		if (Delay > 0)
+		// Check if sprite overlaps in y-direction
+		if (LCDC->OBJ8x16)	// Sprites 2 tiles tall
 		{
-			Delay -= 1;
-			break;
+			if (Obj->YPos > *LY && Obj->YPos - 16 <= *LY)
+			{
+				FoundObject = true;
+			}
+		}
+		else
+		{
+			if (Obj->YPos - 8 > *LY && Obj->YPos - 16 <= *LY)
+			{
+				FoundObject = true;
+			}
 		}
 
-		// =========== Draw Pixels ===========
-		// Check if window is enabled and current pixel in
-		// window's coverage. If not then try drawing a 
-		// background pixel, otherwise just display a 
-		// white pixel on the monochrome gameboy.
-		uint8_t Value;
+		if (FoundObject)
+		{
+			FoundObject = false;
+			ScanLineObjects[nScanLineObjects] = Obj;
+
+			// Maximum number of objects per scanline is 10
+			if (++nScanLineObjects == 10)
+			{
+				break;
+			}
+		}
+
+	}
+
+	// To more easily determine priorities we order the objects
+	// based on x-ccordinate while keeping sprites with the same
+	// x-ccordinate in the same order relative to how they were in
+	// the OAM.
+	std::stable_sort(
+		ScanLineObjects,
+		ScanLineObjects + nScanLineObjects,
+		[](Object* e1, Object* e2) { return e1->XPos < e2->XPos; }
+	);
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::buildObjectIndex()
+{
+	memset(nLineObjects, 0, sizeof(nLineObjects));
+	int Height = LCDC->OBJ8x16 ? 16 : 8;
+
+	for (uint8_t i = 0; i < 40; i++)
+	{
+		Object* Obj = reinterpret_cast<Object*>(&gb->RAM[0xFE00 + i * 4]);
 
-		// ============ Sprite Display ============ 
-		// TODO: object delay
+		// Objects cover the lines from YPos - 16 downwards
+		int Top = std::max(Obj->YPos - 16, 0);
+		int Bottom = std::min(Obj->YPos - 16 + Height, 18 * 8);
 
-		// PPU cannot access DMA, this isn't true behaviour
-		// but this should never happen anyway.
-		if (LCDC->bOBJ && !gb->dma.DMAinProgress)
+		for (int Line = Top; Line < Bottom; Line++)
 		{
-			// Find objects which cover current pixel to be drawn
-			for (uint8_t i = 0; i < nScanLineObjects; i++)
+			// Only the first 10 objects in OAM on a line are drawn
+			if (nLineObjects[Line] < 10)
 			{
-				Object* Obj = ScanLineObjects[i];
+				LineObjects[Line][nLineObjects[Line]++] = i;
+			}
+		}
+	}
 
-				// Check if sprite overlaps in x-direction
-				if (Obj->XPos > LX && Obj->XPos - 8 <= LX)
-				{
-					// Get tile row from memory
-					// Check if sprite is flipped in y-direction
-					int TileRow;
-					uint8_t TileHeight = LCDC->OBJ8x16 ? 16 : 8;
-					if (Obj->YFlip)
-					{
-						TileRow = (TileHeight - 1) - (*LY - (Obj->YPos - 16));
-					}
-					else
-					{
-						TileRow = *LY - (Obj->YPos - 16);
-					}
-
-					// Enforced in hardware is the igorance of the LSB of the tile index
-					// when the ppu is in 8x16 mode.
-					if (LCDC->OBJ8x16)
-					{
-						Obj->TileIndex &= 0xFE;
-					}
-
-					uint8_t TileLO = gb->RAM[0x8000 + Obj->TileIndex * 0x10 + TileRow * 2 + 0];
-					uint8_t TileHI = gb->RAM[0x8000 + Obj->TileIndex * 0x10 + TileRow * 2 + 1];
-
-					// Get pixel color or in the case of DMG, the
-					// shade of pixel from OBP0 or OBP1 registers.
-					uint8_t ObP = Obj->Pallette ? *OBP1 : *OBP0;
-
-					// Check if bit is flipped in x-directions
-					uint8_t p;
-					if (Obj->XFlip)
-					{
-						p = (LX - (Obj->XPos - 8)) % 8;
-					}
-					else
-					{
-						p = 7 - (LX - (Obj->XPos - 8));
-					}
-
-					uint8_t PixelPalette = (((TileHI >> p) & 0x01) << 1) | ((TileLO >> p) & 0x01);
-
-					// Index 0 is always transparent
-					if (PixelPalette == 0)
-					{
-						FoundObject = false;
-						ObjectPriorityConflict = false;
-					}
-					else
-					{
-						FoundObject = true;
-						ObjectPriorityConflict = Obj->Priority;
-
-						Value = (3 - ((ObP >> (PixelPalette * 2)) & 0b11)) * 255 / 3;
-					}
-
-					break;
+	// Ordered by x-coordinate, objects with the same x-coordinate
+	// stay in OAM order like with the stable sort in scanObjects().
+	for (int Line = 0; Line < 18 * 8; Line++)
+	{
+		uint8_t* Objects = LineObjects[Line];
 
-				}
+		for (uint8_t j = 1; j < nLineObjects[Line]; j++)
+		{
+			uint8_t Index = Objects[j];
+			uint8_t XPos = gb->RAM[0xFE00 + Index * 4 + 1];
+
+			uint8_t k = j;
+			for (; k > 0 && gb->RAM[0xFE00 + Objects[k - 1] * 4 + 1] > XPos; k--)
+			{
+				Objects[k] = Objects[k - 1];
+			}
+
+			Objects[k] = Index;
+		}
+	}
+
+	ObjectIndexValid = true;
+	ObjectIndex8x16 = LCDC->OBJ8x16;
+	nObjectIndexBuilds++;
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::objectsChanged()
+{
+	ObjectIndexValid = false;
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::lineChanged(uint64_t Dot)
+{
+	if (!LineBatched)
+	{
+		return;
+	}
+
+	// The thread draws the dots so far with what the PPU
+	// saw then and the rest of the line stays batched.
+	if (Threaded)
+	{
+		logLine(Dot - LineStart);
+		LineStart = Dot;
+		return;
+	}
+
+	// The dots so far are drawn with what the PPU saw 
+	// then, the rest of the line is drawn a dot at a time.
+	if (Rendering)
+	{
+		drawLine(Dot - LineStart);
+	}
+	else
+	{
+		skipLine(Dot - LineStart);
+	}
+
+	batchLine(false);
+	nLinesDotted++;
+
+	gb->scheduler.schedule(Scheduler::PPUDot, Dot);
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::batchLine(bool Batched)
+{
+	LineBatched = Batched;
+
+	// VRAM writes go through GBInternal::write while a 
+	// line is batched so they can be caught.
+	gb->mapVRAM();
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::drawLine(uint64_t nDots)
+{
+	// Nothing the PPU reads changes for the rest of the line, 
+	// so all of it is drawn in one go. Each dot ends up the 
+	// same as with drawDot().
+	LineRenderer::Snapshot s = snapshot(nDots);
+
+	if (lineRenderer.draw(s, DotMatrix[*LY]))
+	{
+		LineRenderer::markDirty(DirtyLines, *LY);
+	}
+
+	LX = s.LX;
+	Delay = s.Delay;
+
+	for (uint8_t i = 0; i < nScanLineObjects; i++)
+	{
+		ScanLineObjects[i]->TileIndex = s.Objects[i][2];
+	}
+}
+
+template <class Renderer>
+LineRenderer::Snapshot BasicPPU<Renderer>::snapshot(uint64_t nDots)
+{
+	LineRenderer::Snapshot s;
+
+	s.LY = *LY;
+	s.WLY = WLY;
+	s.LCDC = LCDC->reg;
+	s.SCX = *SCX;
+	s.SCY = *SCY;
+	s.WX = *WX;
+	s.WY = *WY;
+	s.BGP = *BGP;
+	s.OBP0 = *OBP0;
+	s.OBP1 = *OBP1;
+	s.DMAinProgress = gb->dma.DMAinProgress;
+
+	s.LX = LX;
+	s.Delay = Delay;
+	s.nDots = (uint32_t)nDots;
+
+	// OAM can change before the thread gets to the 
+	// line so the objects on it are copied.
+	s.nObjects = nScanLineObjects;
+	for (uint8_t i = 0; i < nScanLineObjects; i++)
+	{
+		memcpy(s.Objects[i], ScanLineObjects[i], sizeof(s.Objects[i]));
+	}
+
+	return s;
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::logLine(uint64_t nDots)
+{
+	if (Rendering)
+	{
+		renderThread.draw(snapshot(nDots));
+	}
+
+	// The thread works out the same LX, Delay 
+	// and tile indices from the snapshot.
+	skipLine(nDots);
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::renderOnThread()
+{
+	if (Threaded || Renderer::Fifo)
+	{
+		return;
+	}
+
+	renderThread.start(gb->RAM, DotMatrix, DirtyLines);
+	Threaded = true;
+
+	// VRAM writes have to go through GBInternal::write to be logged
+	gb->mapMemory();
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::skipLine(uint64_t nDots)
+{
+	// Only what the rest of the line and the next lines depend on 
+	// is kept up to date: how far along the line drawing got, the
+	// delay after the first window pixel and the tile index of the 
+	// 8x16 objects which were reached.
+	int First = LX;
+
+	uint64_t Stalled = std::min<uint64_t>(Delay, nDots);
+	Delay -= Stalled;
+	nDots -= Stalled;
+
+	bool bWindow = LCDC->bBG && LCDC->bWindowing && *LY >= *WY;
+	int WindowStart = *WX - 7;
+
+	if (bWindow && WindowStart >= LX && WindowStart < LX + (int64_t)nDots)
+	{
+		// The window only starts if an object isn't drawn over 
+		// its first pixel, which means looking up that one row.
+		Object* Obj = objectAt(WindowStart);
+		bool ObjectDrawn = false;
+
+		if (Obj != nullptr && !Obj->Priority)
+		{
+			int TileRow;
+			uint8_t TileHeight = LCDC->OBJ8x16 ? 16 : 8;
+			if (Obj->YFlip)
+			{
+				TileRow = (TileHeight - 1) - (*LY - (Obj->YPos - 16));
+			}
+			else
+			{
+				TileRow = *LY - (Obj->YPos - 16);
+			}
+
+			if (LCDC->OBJ8x16)
+			{
+				Obj->TileIndex &= 0xFE;
 			}
 
+			const uint8_t* Row = gb->tileCache.row(0x8000 + Obj->TileIndex * 0x10 + TileRow * 2, Obj->XFlip);
+			ObjectDrawn = Row[WindowStart - (Obj->XPos - 8)] != 0;
 		}
 
-		// Either no object was found or an object was found but the 
-		// priority may result in the object pixel not being rendered.
-		if (!FoundObject || (FoundObject && ObjectPriorityConflict))
+		if (!ObjectDrawn)
 		{
-			// TODO: WX < 7 behaviour
-			if (LCDC->bBG && LCDC->bWindowing && LX >= *WX - 7 && *LY >= *WY)
+			nDots -= WindowStart + 1 - LX;
+			LX = WindowStart + 1;
+			Delay = 6;
+
+			Stalled = std::min<uint64_t>(Delay, nDots);
+			Delay -= Stalled;
+			nDots -= Stalled;
+		}
+	}
+
+	LX += (int)nDots;
+
+	// Drawing clears the lowest bit of the tile 
+	// index of each 8x16 object it comes across.
+	if (LCDC->OBJ8x16)
+	{
+		for (int x = First; x < LX; x++)
+		{
+			Object* Obj = objectAt(x);
+			if (Obj != nullptr)
 			{
-				// ============ Window Display ============ 
+				Obj->TileIndex &= 0xFE;
+			}
+		}
+	}
+}
+
+template <class Renderer>
+typename BasicPPU<Renderer>::Object* BasicPPU<Renderer>::objectAt(int x)
+{
+	if (!LCDC->bOBJ || gb->dma.DMAinProgress)
+	{
+		return nullptr;
+	}
+
+	for (uint8_t i = 0; i < nScanLineObjects; i++)
+	{
+		if (ScanLineObjects[i]->XPos > x && ScanLineObjects[i]->XPos - 8 <= x)
+		{
+			return ScanLineObjects[i];
+		}
+	}
+
+	return nullptr;
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::startFrame()
+{
+	switch (FrameSkip)
+	{
+	case RenderAll:
+		Rendering = true;
+		break;
+	case RenderNone:
+		Rendering = false;
+		break;
+	case RenderOneInN:
+		Rendering = FrameSkipN <= 1 || gb->nFrames % FrameSkipN == 0;
+		break;
+	case RenderRequested:
+		Rendering = FrameRequested.exchange(false);
+		break;
+	}
+
+	if (Rendering)
+	{
+		nFramesRendered++;
+	}
+	else
+	{
+		nFramesSkipped++;
+	}
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::requestFrame()
+{
+	FrameRequested = true;
+}
+
+template <class Renderer>
+bool BasicPPU<Renderer>::takeDirtyLines(bool Dirty[18 * 8])
+{
+	bool Any = false;
+
+	for (int i = 0; i < 3; i++)
+	{
+		uint64_t Lines = DirtyLines[i].exchange(0, std::memory_order_relaxed);
+
+		for (int Line = i * 64; Line < std::min(i * 64 + 64, 18 * 8); Line++)
+		{
+			Dirty[Line] = (Lines >> (Line % 64)) & 1;
+			Any |= Dirty[Line];
+		}
+	}
+
+	return Any;
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::drawDot()
+{
+	if (Delay > 0)
+	{
+		Delay -= 1;
+		return;
+	}
 
-				// Get addressing mode for accessing
-				// VRAM which is the range 0x8000-0x97FF
-				uint16_t BGBaseAddr = LCDC->BGCharData ? 0x8000 : 0x9000;
+	// =========== Draw Pixels ===========
+	// Check if window is enabled and current pixel in
+	// window's coverage. If not then try drawing a 
+	// background pixel, otherwise just display a 
+	// white pixel on the monochrome gameboy.
+	uint8_t Value;
 
-				// Get base address for character codes for tiles
-				// 0: 0x9800 - 0x9BFF
-				// 1: 0x9C00 - 0x9FFF
-				uint16_t CHRCodesBaseAddr = LCDC->WindowCodeArea ? 0x9C00 : 0x9800;
+	// ============ Sprite Display ============ 
+	// TODO: object delay
 
-				// TODO: Midframe behaviour
-				uint8_t LineY = WLY;
-				uint8_t LineX = LX - (*WX - 7);
+	// PPU cannot access DMA, this isn't true behaviour
+	// but this should never happen anyway.
+	if (LCDC->bOBJ && !gb->dma.DMAinProgress)
+	{
+		// Find objects which cover current pixel to be drawn
+		for (uint8_t i = 0; i < nScanLineObjects; i++)
+		{
+			Object* Obj = ScanLineObjects[i];
 
-				// If this is the first pixel of the window then a 
-				// delay penalty is incurred.
-				if (LineX == 0)
+			// Check if sprite overlaps in x-direction
+			if (Obj->XPos > LX && Obj->XPos - 8 <= LX)
+			{
+				// Get tile row from memory
+				// Check if sprite is flipped in y-direction
+				int TileRow;
+				uint8_t TileHeight = LCDC->OBJ8x16 ? 16 : 8;
+				if (Obj->YFlip)
 				{
-					Delay = 6;
+					TileRow = (TileHeight - 1) - (*LY - (Obj->YPos - 16));
+				}
+				else
+				{
+					TileRow = *LY - (Obj->YPos - 16);
 				}
 
-				// Read character code of tile i on line (*LY) / 8
-				uint8_t CHRCode = gb->RAM[CHRCodesBaseAddr + (int)(LineY / 8) * 32 + (int)(LineX / 8)];
-
-				// Determine mode by which tile data is located
-				// based on unsigned or signed offset from 
-				// base address.
-				int16_t CHRCodeOffset = LCDC->BGCharData ? (uint8_t)CHRCode : (int8_t)CHRCode;
+				// Enforced in hardware is the igorance of the LSB of the tile index
+				// when the ppu is in 8x16 mode.
+				if (LCDC->OBJ8x16)
+				{
+					Obj->TileIndex &= 0xFE;
+				}
 
-				// Get tile data, offset from base address and 
-				// by the row being rendered of a given tile which 
-				// is 8x8. Each row of tile is two bytes.
-				int TileRow = LineY % 8;
-				uint8_t TileLO = gb->RAM[BGBaseAddr + CHRCodeOffset * 0x10 + TileRow * 2 + 0];
-				uint8_t TileHI = gb->RAM[BGBaseAddr + CHRCodeOffset * 0x10 + TileRow * 2 + 1];
+				// Rows of objects flipped in the x-direction
+				// are looked up already mirrored.
+				const uint8_t* Row = gb->tileCache.row(0x8000 + Obj->TileIndex * 0x10 + TileRow * 2, Obj->XFlip);
 
 				// Get pixel color or in the case of DMG, the
-				// shade of pixel from BGP register.
-				uint8_t p = 7 - LineX % 8;
+				// shade of pixel from OBP0 or OBP1 registers.
+				uint8_t ObP = Obj->Pallette ? *OBP1 : *OBP0;
 
-				uint8_t PixelPalette = (((TileHI >> p) & 0x01) << 1) | ((TileLO >> p) & 0x01);
+				uint8_t PixelPalette = Row[LX - (Obj->XPos - 8)];
 
-				if (PixelPalette != 0 || !ObjectPriorityConflict)
+				// Index 0 is always transparent
+				if (PixelPalette == 0)
+				{
+					FoundObject = false;
+					ObjectPriorityConflict = false;
+				}
+				else
 				{
-					Value = (3 - (((*BGP) >> (PixelPalette * 2)) & 0b11)) * 255 / 3;
+					FoundObject = true;
+					ObjectPriorityConflict = Obj->Priority;
+
+					Value = (ObP >> (PixelPalette * 2)) & 0b11;
 				}
+
+				break;
+
 			}
-			else if (LCDC->bBG)
+		}
+
+	}
+
+	// Either no object was found or an object was found but the 
+	// priority may result in the object pixel not being rendered.
+	if (!FoundObject || (FoundObject && ObjectPriorityConflict))
+	{
+		// TODO: WX < 7 behaviour
+		if (LCDC->bBG && LCDC->bWindowing && LX >= *WX - 7 && *LY >= *WY)
+		{
+			// ============ Window Display ============ 
+
+			// Get addressing mode for accessing
+			// VRAM which is the range 0x8000-0x97FF
+			uint16_t BGBaseAddr = LCDC->BGCharData ? 0x8000 : 0x9000;
+
+			// Get base address for character codes for tiles
+			// 0: 0x9800 - 0x9BFF
+			// 1: 0x9C00 - 0x9FFF
+			uint16_t CHRCodesBaseAddr = LCDC->WindowCodeArea ? 0x9C00 : 0x9800;
+
+			// TODO: Midframe behaviour
+			uint8_t LineY = WLY;
+			uint8_t LineX = LX - (*WX - 7);
+
+			// If this is the first pixel of the window then a 
+			// delay penalty is incurred.
+			if (LineX == 0)
 			{
-				// ============ Background Display ============ 
+				Delay = 6;
+			}
 
-				// Get addressing mode for accessing
-				// VRAM which is the range 0x8000-0x97FF
-				uint16_t BGBaseAddr = LCDC->BGCharData ? 0x8000 : 0x9000;
+			// Read character code of tile i on line (*LY) / 8
+			uint8_t CHRCode = gb->RAM[CHRCodesBaseAddr + (int)(LineY / 8) * 32 + (int)(LineX / 8)];
 
-				// Get base address for character codes for tiles
-				// 0: 0x9800 - 0x9BFF
-				// 1: 0x9C00 - 0x9FFF
-				uint16_t CHRCodesBaseAddr = LCDC->BGCodeArea ? 0x9C00 : 0x9800;
+			// Determine mode by which tile data is located
+			// based on unsigned or signed offset from 
+			// base address.
+			int16_t CHRCodeOffset = LCDC->BGCharData ? (uint8_t)CHRCode : (int8_t)CHRCode;
 
-				// The GB has the capability of scrolling the screen, the offset
-				// from the top left corner is specified through SCX and SCY.
-				// TODO: Midframe behaviour
-				uint8_t LineY = (*LY + *SCY) % 256;
+			// Get tile data, offset from base address and 
+			// by the row being rendered of a given tile which 
+			// is 8x8. Each row of tile is two bytes.
+			int TileRow = LineY % 8;
+			const uint8_t* Row = gb->tileCache.row(BGBaseAddr + CHRCodeOffset * 0x10 + TileRow * 2, false);
 
-				// Read character code of tile i on line (*LY) / 8
-				uint8_t CHRCode = gb->RAM[CHRCodesBaseAddr + (int)(LineY / 8) * 32 + (int)(((LX + *SCX) % 256) / 8)];
+			// Get pixel color or in the case of DMG, the
+			// shade of pixel from BGP register.
+			uint8_t PixelPalette = Row[LineX % 8];
 
-				// Determine mode by which tile data is located
-				// based on unsigned or signed offset from 
-				// base address.
-				int16_t CHRCodeOffset = LCDC->BGCharData ? (uint8_t)CHRCode : (int8_t)CHRCode;
+			if (PixelPalette != 0 || !ObjectPriorityConflict)
+			{
+				Value = ((*BGP) >> (PixelPalette * 2)) & 0b11;
+			}
+		}
+		else if (LCDC->bBG)
+		{
+			// ============ Background Display ============ 
 
-				// Get tile data, offset from base address and 
-				// by the row being rendered of a given tile which 
-				// is 8x8. Each row of tile is two bytes.
-				int TileRow = LineY % 8;
-				uint8_t TileLO = gb->RAM[BGBaseAddr + CHRCodeOffset * 0x10 + TileRow * 2 + 0];
-				uint8_t TileHI = gb->RAM[BGBaseAddr + CHRCodeOffset * 0x10 + TileRow * 2 + 1];
+			// Get addressing mode for accessing
+			// VRAM which is the range 0x8000-0x97FF
+			uint16_t BGBaseAddr = LCDC->BGCharData ? 0x8000 : 0x9000;
 
-				// Get pixel color or in the case of DMG, the
-				// shade of pixel from BGP register.
-				uint8_t p = 7 - (LX + *SCX) % 8;
+			// Get base address for character codes for tiles
+			// 0: 0x9800 - 0x9BFF
+			// 1: 0x9C00 - 0x9FFF
+			uint16_t CHRCodesBaseAddr = LCDC->BGCodeArea ? 0x9C00 : 0x9800;
 
-				uint8_t PixelPalette = (((TileHI >> p) & 0x01) << 1) | ((TileLO >> p) & 0x01);
+			// The GB has the capability of scrolling the screen, the offset
+			// from the top left corner is specified through SCX and SCY.
+			// TODO: Midframe behaviour
+			uint8_t LineY = (*LY + *SCY) % 256;
 
-				if (PixelPalette != 0 || !ObjectPriorityConflict)
-				{
-					Value = (3 - (((*BGP) >> (PixelPalette * 2)) & 0b11)) * 255 / 3;
-				}
+			// Read character code of tile i on line (*LY) / 8
+			uint8_t CHRCode = gb->RAM[CHRCodesBaseAddr + (int)(LineY / 8) * 32 + (int)(((LX + *SCX) % 256) / 8)];
+
+			// Determine mode by which tile data is located
+			// based on unsigned or signed offset from 
+			// base address.
+			int16_t CHRCodeOffset = LCDC->BGCharData ? (uint8_t)CHRCode : (int8_t)CHRCode;
+
+			// Get tile data, offset from base address and 
+			// by the row being rendered of a given tile which 
+			// is 8x8. Each row of tile is two bytes.
+			int TileRow = LineY % 8;
+			const uint8_t* Row = gb->tileCache.row(BGBaseAddr + CHRCodeOffset * 0x10 + TileRow * 2, false);
+
+			// Get pixel color or in the case of DMG, the
+			// shade of pixel from BGP register.
+			uint8_t PixelPalette = Row[(LX + *SCX) % 8];
+
+			if (PixelPalette != 0 || !ObjectPriorityConflict)
+			{
+				Value = ((*BGP) >> (PixelPalette * 2)) & 0b11;
 			}
-			else
+		}
+		else
+		{
+			// If LCD is turned on but there is no sprite or 
+			// background or window then just return a white pixel;
+			Value = 0;
+		}
+	}
+
+
+	// Place pixel value into dot matrix
+	if (DotMatrix[*LY][LX] != Value)
+	{
+		DotMatrix[*LY][LX] = Value;
+		LineRenderer::markDirty(DirtyLines, *LY);
+	}
+
+	LX += 1;
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::startFifo()
+{
+	nBGFifo = 0;
+	BGFifoFirst = 0;
+	memset(ObjectFifo, 0, sizeof(ObjectFifo));
+
+	Step = FetchTile;
+	StepDots = 0;
+	FetchX = 0;
+	FetchingWindow = false;
+
+	// The first tile is fetched twice, the first time takes 6 dots
+	// and is thrown away. Then the SCX % 8 pixels scrolled off the
+	// left are shifted out without being shown.
+	StartupDots = 6;
+	Discard = *SCX % 8;
+
+	ObjectFetching = 0xFF;
+	ObjectsFetched = 0;
+	WindowDrawn = false;
+}
+
+template <class Renderer>
+bool BasicPPU<Renderer>::fifoDot()
+{
+	if (StartupDots > 0)
+	{
+		StartupDots--;
+		return false;
+	}
+
+	// The window takes over once the pixel before WX - 7 is out. 
+	// What the background fetcher had is dropped and it starts 
+	// again on the window's first tile, which costs 6 dots.
+	if (!FetchingWindow && Discard == 0 && LCDC->bBG && LCDC->bWindowing && *LY >= *WY && LX + 7 >= *WX)
+	{
+		FetchingWindow = true;
+		WindowDrawn = true;
+		nBGFifo = 0;
+		Step = FetchTile;
+		StepDots = 0;
+		FetchX = 0;
+
+		// Less than 7 cuts off the left of the window instead
+		Discard = *WX < 7 ? 7 - *WX : 0;
+	}
+
+	fetchBackground();
+
+	// An object whose left edge is at the next pixel is fetched
+	// before the pixel is shifted out. Objects further left than
+	// the screen are fetched at the first pixel.
+	if (ObjectFetching == 0xFF && nBGFifo != 0 && Discard == 0 && LCDC->bOBJ && !gb->dma.DMAinProgress)
+	{
+		for (uint8_t i = 0; i < nScanLineObjects; i++)
+		{
+			if (!((ObjectsFetched >> i) & 1) && ScanLineObjects[i]->XPos <= LX + 8)
 			{
-				// If LCD is turned on but there is no sprite or 
-				// background or window then just return a white pixel;
-				Value = 255;
+				ObjectsFetched |= 1 << i;
+				ObjectFetching = i;
+				ObjectDots = 0;
+				break;
 			}
 		}
+	}
+
+	// The object fetch waits for the background fetcher to have a 
+	// tile ready then takes 6 dots, so 6 to 11 dots an object.
+	// Nothing is shifted out meanwhile.
+	if (ObjectFetching != 0xFF)
+	{
+		if (Step == FetchPush && ++ObjectDots == 6)
+		{
+			mergeObject();
+			ObjectFetching = 0xFF;
+		}
+
+		return false;
+	}
+
+	if (nBGFifo == 0)
+	{
+		return false;
+	}
+
+	uint8_t BGColour = BGFifo[BGFifoFirst++];
+	nBGFifo--;
+
+	if (Discard > 0)
+	{
+		Discard--;
+		return false;
+	}
+
+	ObjectPixel Obj = ObjectFifo[0];
+	memmove(ObjectFifo, ObjectFifo + 1, sizeof(ObjectFifo) - sizeof(ObjectPixel));
+	ObjectFifo[7].Colour = 0;
+
+	if (Rendering)
+	{
+		// The palettes are applied as each pixel comes out. With the
+		// background off it's white and objects are always on top.
+		uint8_t Value = 0;
+		if (LCDC->bBG)
+		{
+			Value = ((*BGP) >> (BGColour * 2)) & 0b11;
+		}
+		else
+		{
+			BGColour = 0;
+		}
+
+		if (Obj.Colour != 0 && LCDC->bOBJ && (!Obj.Priority || BGColour == 0))
+		{
+			uint8_t ObP = Obj.Palette ? *OBP1 : *OBP0;
+			Value = (ObP >> (Obj.Colour * 2)) & 0b11;
+		}
+
+		if (DotMatrix[*LY][LX] != Value)
+		{
+			DotMatrix[*LY][LX] = Value;
+			LineRenderer::markDirty(DirtyLines, *LY);
+		}
+	}
+
+	LX += 1;
+	return LX == 160;
+}
+
+template <class Renderer>
+void BasicPPU<Renderer>::fetchBackground()
+{
+	// The tile index and each byte of its row take 2 dots
+	if (Step != FetchPush && ++StepDots < 2)
+	{
+		return;
+	}
+
+	StepDots = 0;
+
+	// SCY is read again for each part of the fetch
+	uint8_t LineY = FetchingWindow ? WLY : (uint8_t)(*LY + *SCY);
+
+	switch (Step)
+	{
+	case FetchTile:
+	{
+		uint16_t CHRCodesBaseAddr;
+		uint8_t TileX;
+
+		if (FetchingWindow)
+		{
+			CHRCodesBaseAddr = LCDC->WindowCodeArea ? 0x9C00 : 0x9800;
+			TileX = FetchX;
+		}
+		else
+		{
+			CHRCodesBaseAddr = LCDC->BGCodeArea ? 0x9C00 : 0x9800;
+			TileX = (*SCX / 8 + FetchX) % 32;
+		}
 
+		FetchTileIndex = gb->RAM[CHRCodesBaseAddr + (LineY / 8) * 32 + TileX];
+		Step = FetchLow;
+		break;
+	}
+	case FetchLow:
+	case FetchHigh:
+	{
+		// Tile data is either at 0x8000 + index or 0x9000 + signed index
+		uint16_t Tile = LCDC->BGCharData ? 0x8000 + FetchTileIndex * 0x10 : 0x9000 + (int8_t)FetchTileIndex * 0x10;
+		uint16_t addr = Tile + (LineY % 8) * 2;
 
-		// Place pixel value into dot matrix
-		DotMatrix[*LY][LX][0] = 255;
-		DotMatrix[*LY][LX][1] = Value;
-		DotMatrix[*LY][LX][2] = Value;
-		DotMatrix[*LY][LX][3] = Value;
+		if (Step == FetchLow)
+		{
+			FetchLowByte = gb->RAM[addr];
+			Step = FetchHigh;
+		}
+		else
+		{
+			FetchHighByte = gb->RAM[addr + 1];
+			Step = FetchPush;
+		}
+		break;
+	}
+	case FetchPush:
+		// Only once the last pixels have been shifted out
+		if (nBGFifo != 0)
+		{
+			return;
+		}
 
-		LX += 1;
+		for (int i = 0; i < 8; i++)
+		{
+			BGFifo[i] = (((FetchHighByte >> (7 - i)) & 1) << 1) | ((FetchLowByte >> (7 - i)) & 1);
+		}
 
+		nBGFifo = 8;
+		BGFifoFirst = 0;
+		FetchX++;
+		Step = FetchTile;
 		break;
 	}
+}
 
+template <class Renderer>
+void BasicPPU<Renderer>::mergeObject()
+{
+	Object* Obj = ScanLineObjects[ObjectFetching];
 
+	// OAM is read now so changes during the line show up. The 
+	// lowest bit of the tile index is ignored for 8x16 objects.
+	int TileHeight = LCDC->OBJ8x16 ? 16 : 8;
+	int TileRow = (*LY - (Obj->YPos - 16)) & (TileHeight - 1);
+	if (Obj->YFlip)
+	{
+		TileRow = (TileHeight - 1) - TileRow;
 	}
 
-	
+	uint8_t TileIndex = LCDC->OBJ8x16 ? Obj->TileIndex & 0xFE : Obj->TileIndex;
+	uint16_t addr = 0x8000 + TileIndex * 0x10 + TileRow * 2;
+	uint8_t Low = gb->RAM[addr];
+	uint8_t High = gb->RAM[addr + 1];
+
+	// Objects earlier in the line or in OAM keep their pixels,
+	// only transparent ones are filled in.
+	for (int Column = 0; Column < 8; Column++)
+	{
+		int i = Obj->XPos - 8 + Column - LX;
+		if (i < 0 || i >= 8 || ObjectFifo[i].Colour != 0)
+		{
+			continue;
+		}
+
+		int Bit = Obj->XFlip ? Column : 7 - Column;
+		ObjectFifo[i].Colour = (((High >> Bit) & 1) << 1) | ((Low >> Bit) & 1);
+		ObjectFifo[i].Palette = Obj->Pallette;
+		ObjectFifo[i].Priority = Obj->Priority;
+	}
 }
 
-void PPU::reset()
+template <class Renderer>
+void BasicPPU<Renderer>::reset()
 {
 	*SCX = 0x00;
 	*SCY = 0x00;
@@ -475,4 +1155,10 @@ void PPU::reset()
 	STAT->ModeFlag = 0b00;
 	
 	//LCDC->bBG = 0;
-}
\ No newline at end of file
+}
+
+// The member functions are only defined here. Every renderer
+// is built so the ones not in use keep compiling too.
+template class BasicPPU<DotRenderer>;
+template class BasicPPU<ScanlineRenderer>;
+template class BasicPPU<FifoRenderer>;
\ No newline at end of file
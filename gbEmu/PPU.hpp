@@ -1,17 +1,134 @@
 #pragma once
 #include <cstdint>
+#include <atomic>
+#include "LineRenderer.hpp"
+#include "RenderThread.hpp"
 
 class GBInternal;
 
-class PPU
+// How the PPU draws, picked when building by defining PPU_DOT_RENDERER,
+// PPU_FIFO_RENDERER or neither. The dot and scanline renderers draw 
+// exactly the same frames, with mode 3 always lasting 172 dots plus 
+// SCX % 8. The FIFO renderer works mode 3 out as the hardware does,
+// so it runs for different lengths and picks up changes part way 
+// through a line the same way. Ordinary games look the same.
+
+// Draws each dot as the PPU reaches it with the VRAM, OAM 
+// and registers of that dot. Slow but the simplest to follow.
+struct DotRenderer
+{
+	static const bool Batched = false;
+	static const bool Fifo = false;
+	static const char* name() { return "dot"; }
+};
+
+// Draws each line in one go at the end of mode 3. Lines during 
+// which something the PPU reads is changed fall back to drawing
+// a dot at a time.
+struct ScanlineRenderer
+{
+	static const bool Batched = true;
+	static const bool Fifo = false;
+	static const char* name() { return "scanline"; }
+};
+
+// Shifts pixels out of a background and an object FIFO, filled by 
+// a fetcher reading the tile map and tile data two dots a step. 
+// Mode 3 ends once 160 pixels are out, taking longer for SCX % 8,
+// the window and each object fetched. Registers, OAM and VRAM are
+// read on the dot the hardware reads them. Every dot is run, even
+// on frames which aren't drawn, and there's no render thread.
+struct FifoRenderer
+{
+	static const bool Batched = false;
+	static const bool Fifo = true;
+	static const char* name() { return "fifo"; }
+};
+
+template <class Renderer>
+class BasicPPU
 {
 public:
+	typedef Renderer Policy;
+
 	GBInternal* gb;
 
 	void connectGB(GBInternal* gb);
 	void clock();
 	void reset();
 
+	// The PPU is only clocked while drawing pixels, when changing
+	// modes or after a register it checks every dot was written.
+	// The dots in between are counted the next time it's clocked.
+	// wake() has it clocked on the current T-cycle.
+	void wake();
+
+	// Dots before this T-cycle have been accounted for
+	uint64_t NextDot = 0;
+
+	// Whether the current line is going to be drawn at the end of mode 3
+	bool LineBatched = false;
+
+	// Called before VRAM, OAM or an LCD register is written and when
+	// OAM DMA copies or ends. If the current line is batched the dots 
+	// before Dot are drawn and the rest of the line is drawn per dot.
+	void lineChanged(uint64_t Dot);
+
+	uint64_t nLinesBatched = 0;	// Lines drawn in one go
+	uint64_t nLinesDotted = 0;	// Batched lines which fell back to per dot
+
+	// Draws batched lines
+	LineRenderer lineRenderer;
+
+	// Whether lines are drawn by renderThread. The PPU then only 
+	// keeps track of timing, every line is batched and each change 
+	// during one ends a stretch which is logged for the thread 
+	// instead of falling back to drawing per dot.
+	bool Threaded = false;
+	RenderThread renderThread;
+
+	// Starts drawing on renderThread from the next line. The FIFO 
+	// renderer decides how long mode 3 is so it stays on this one.
+	void renderOnThread();
+
+	// Which frames are drawn. Frames which aren't still go through
+	// every mode with the same timing, STAT changes, interrupts and
+	// OAM scans, only their pixels aren't worked out and DotMatrix 
+	// keeps the last frame which was drawn.
+	enum FrameSkipPolicy
+	{
+		RenderAll,
+		RenderNone,
+		RenderOneInN,		// Frames 0, N, 2N, ...
+		RenderRequested,	// Only the frame after each requestFrame()
+	} FrameSkip = RenderAll;
+
+	uint32_t FrameSkipN = 2;
+
+	// Has the next frame drawn with RenderRequested, called by 
+	// the frontend whenever it shows a frame. Safe to call from
+	// another thread.
+	void requestFrame();
+
+	// Whether the current frame is being drawn
+	bool Rendering = true;
+
+	uint64_t nFramesRendered = 0;
+	uint64_t nFramesSkipped = 0;
+
+	// Looks up the objects on each line from lists built for every
+	// line at once instead of going through all of OAM each line. 
+	// The lists are only built again after OAM has changed.
+	bool ObjectIndex = true;
+
+	// Called when OAM is written to or copied to by DMA
+	void objectsChanged();
+
+	// Finds the objects on the current line at the start of OAM scan
+	void findObjects();
+
+	uint64_t nObjectIndexBuilds = 0;
+
 	int DotsRemaining;
 	int DotsTotal;
 
@@ -24,7 +141,14 @@ public:
 	} Mode;
 
 	// ================== LCD PPU Registers ==================
-	uint8_t DotMatrix[18 * 8][20 * 8][4];		// ABGR
+	// Shade of every pixel from 0 (white) to 3 (black), turned 
+	// into colours only when a frame is shown.
+	uint8_t DotMatrix[18 * 8][20 * 8];
+
+	// Sets Dirty for the lines of DotMatrix which changed since 
+	// the last call, returns false if none did. Every line starts 
+	// out changed. Safe to call from another thread.
+	bool takeDirtyLines(bool Dirty[18 * 8]);
 
 	// Line of data being copied to LCD Driver
 	uint8_t* LY;
@@ -113,12 +237,101 @@ public:
 private:
 	int LX;
 
+	// First dot of mode 3 on a batched line
+	uint64_t LineStart = 0;
+
+	void batchLine(bool Batched);
+
+	// Draws the pixel on the current dot, reading 
+	// registers, OAM and VRAM as they are now.
+	void drawDot();
+
+	// Draws the next nDots dots of mode 3 all at once
+	void drawLine(uint64_t nDots);
+
+	// What drawLine(nDots) needs to draw the next nDots dots
+	LineRenderer::Snapshot snapshot(uint64_t nDots);
+
+	// Logs the next nDots dots for renderThread and moves on past them
+	void logLine(uint64_t nDots);
+
+	// Goes through the next nDots dots of mode 3 without drawing
+	// anything, leaving the PPU as if they had been drawn.
+	void skipLine(uint64_t nDots);
+
+	// Decides whether the frame starting now is drawn
+	void startFrame();
+
+	std::atomic<bool> FrameRequested{ false };
+
+	// One bit for each line of DotMatrix
+	std::atomic<uint64_t> DirtyLines[3] = { { ~0ull }, { ~0ull }, { ~0ull } };
+
 	// Keeps track of delays during mode 3
 	uint32_t Delay = 0;
 
 	// Keeps track of window scanline to be rendered
 	uint8_t WLY = 0;
 
+	// ============ Pixel FIFO (FifoRenderer) ============
+	enum FetchStep
+	{
+		FetchTile,
+		FetchLow,
+		FetchHigh,
+		FetchPush,
+	};
+
+	struct ObjectPixel
+	{
+		uint8_t Colour;		// 0 is transparent
+		uint8_t Palette;
+		uint8_t Priority;
+	};
+
+	// Background or window colours, shifted out from the front.
+	// It's only refilled once empty so never holds more than 8.
+	uint8_t BGFifo[8];
+	uint8_t nBGFifo = 0;
+	uint8_t BGFifoFirst = 0;
+
+	// Object pixels for the next 8 dots, lined up with the 
+	// background ones. Objects only fill transparent pixels.
+	ObjectPixel ObjectFifo[8];
+
+	FetchStep Step = FetchTile;
+	uint8_t StepDots = 0;		// Dots spent on Step so far
+	uint8_t FetchX = 0;			// Tile column being fetched
+	uint8_t FetchTileIndex = 0;
+	uint8_t FetchLowByte = 0;
+	uint8_t FetchHighByte = 0;
+	bool FetchingWindow = false;
+
+	uint8_t StartupDots = 0;	// Before the fetcher gets going
+	uint8_t Discard = 0;		// Pixels thrown away for SCX or WX < 7
+
+	// Object being fetched, or 0xFF. Background pixels stop
+	// being shifted out until it's merged into ObjectFifo.
+	uint8_t ObjectFetching = 0xFF;
+	uint8_t ObjectDots = 0;
+	uint16_t ObjectsFetched = 0;	// One bit per ScanLineObjects entry
+
+	bool WindowDrawn = false;	// Whether the window started on this line
+
+	// Sets up the FIFOs and fetcher at the start of mode 3
+	void startFifo();
+
+	// Runs the fetchers and shifts out a pixel if there's one. 
+	// Returns true once the 160th pixel of the line is out.
+	bool fifoDot();
+
+	// One dot of the background/window fetcher, which
+	// pushes a tile's pixels once the FIFO is empty.
+	void fetchBackground();
+
+	// Adds the fetched object's row to ObjectFifo
+	void mergeObject();
+
 	// Useful data strucutre for interpreting OAM objects
 	struct Object
 	{
@@ -136,7 +349,7 @@ private:
 				uint8_t XFlip : 1;	// 1 : Entire OBJ is horizontally mirrored
 				uint8_t YFlip : 1;	// 1 : Entire OBJ is vertically mirrored
 				uint8_t Priority : 1;
-				//	1 : BG and Window colors 13 are drawn over this OBJ
+				//	1 : BG and Window colors 13 are drawn over this OBJ
 				//	0 : Obj is drawn infront
 			};
 
@@ -144,6 +357,22 @@ private:
 		};
 	} *ScanLineObjects[10];
 
+	// First object on the line covering pixel x, or nullptr
+	// if there isn't one or objects aren't being drawn.
+	Object* objectAt(int x);
+
+	// Objects on each line as OAM indices, in the order they're drawn
+	uint8_t LineObjects[18 * 8][10];
+	uint8_t nLineObjects[18 * 8];
+
+	bool ObjectIndexValid = false;
+	bool ObjectIndex8x16 = false;	// Object height the lists were built for
+
+	void buildObjectIndex();
+
+	// Goes through OAM for the objects on the current line
+	void scanObjects();
+
 
 	bool FoundObject = false;
 
@@ -154,4 +383,12 @@ private:
 	
 	uint8_t nScanLineObjects = 0;
 	
-};
\ No newline at end of file
+};
+
+#if defined(PPU_DOT_RENDERER)
+typedef BasicPPU<DotRenderer> PPU;
+#elif defined(PPU_FIFO_RENDERER)
+typedef BasicPPU<FifoRenderer> PPU;
+#else
+typedef BasicPPU<ScanlineRenderer> PPU;
+#endif
\ No newline at end of file
@@ -0,0 +1,442 @@
+#include "PostProcess.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define POSTPROCESS_X86 1
+#include <emmintrin.h>
+#else
+#define POSTPROCESS_X86 0
+#endif
+
+#if POSTPROCESS_X86 && !defined(_MSC_VER)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define TARGET_SSE2
+#endif
+
+// Colour channels of an RGBA8888 pixel, the alpha is left alone
+static const uint32_t ColourMask = 0x3F3F3F00;
+
+PostProcess::~PostProcess()
+{
+	stop();
+}
+
+void PostProcess::start(uint32_t nThreads)
+{
+	stop();
+
+	if (nThreads == 0)
+	{
+		nThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	Stopping = false;
+	for (uint32_t i = 1; i < nThreads; i++)
+	{
+		Workers.push_back(std::thread(&PostProcess::run, this));
+	}
+}
+
+void PostProcess::stop()
+{
+	{
+		std::lock_guard<std::mutex> Guard(Lock);
+		Stopping = true;
+	}
+
+	Started.notify_all();
+
+	for (std::thread& Worker : Workers)
+	{
+		Worker.join();
+	}
+
+	Workers.clear();
+}
+
+bool PostProcess::enabled()
+{
+	return Ghosting || upscaler == Scale2x || Scale > 1;
+}
+
+uint32_t PostProcess::width()
+{
+	return Width * (upscaler == Scale2x ? 2 : std::max(Scale, 1u));
+}
+
+uint32_t PostProcess::height()
+{
+	return Height * (upscaler == Scale2x ? 2 : std::max(Scale, 1u));
+}
+
+double PostProcess::elapsed(std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+}
+
+const uint32_t* PostProcess::process(const uint32_t* Frame)
+{
+	uint32_t S = upscaler == Scale2x ? 2 : std::max(Scale, 1u);
+	const uint32_t* Source = Frame;
+
+	LastFrame = Timing();
+
+	// ============ Ghosting ============
+	if (Ghosting)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+
+		// The first frame has nothing to blend with
+		if (!GhostedValid)
+		{
+			Ghosted.assign(Frame, Frame + Width * Height);
+			GhostedValid = true;
+		}
+		else
+		{
+			parallel(Height, [&](uint32_t First, uint32_t Last) { ghost(Frame, First, Last); });
+		}
+
+		Source = Ghosted.data();
+		LastFrame.Ghosting = elapsed(t0);
+	}
+	else
+	{
+		GhostedValid = false;
+	}
+
+	if (S == 1)
+	{
+		nFrames++;
+		Total.Ghosting += LastFrame.Ghosting;
+		return Source;
+	}
+
+	// ============ Upscaling ============
+	auto t0 = std::chrono::steady_clock::now();
+	Out.resize(Width * S * Height * S);
+
+	if (upscaler == Scale2x)
+	{
+		parallel(Height, [&](uint32_t First, uint32_t Last) { scale2x(Source, First, Last); });
+	}
+	else
+	{
+		parallel(Height, [&](uint32_t First, uint32_t Last) { upscale(Source, First, Last); });
+	}
+
+	LastFrame.Upscale = elapsed(t0);
+
+	// ============ LCD Grid ============
+	if (LCDGrid)
+	{
+		t0 = std::chrono::steady_clock::now();
+
+		// The last row and column of each upscaled pixel are darkened
+		GridRow.assign(Width * S, ColourMask);
+		GridColumns.assign(Width * S, 0);
+		for (uint32_t x = S - 1; x < Width * S; x += S)
+		{
+			GridColumns[x] = ColourMask;
+		}
+
+		parallel(Height * S, [&](uint32_t First, uint32_t Last) { grid(First, Last); });
+
+		LastFrame.Grid = elapsed(t0);
+	}
+
+	nFrames++;
+	Total.Ghosting += LastFrame.Ghosting;
+	Total.Upscale += LastFrame.Upscale;
+	Total.Grid += LastFrame.Grid;
+
+	return Out.data();
+}
+
+TARGET_SSE2 void PostProcess::ghost(const uint32_t* Frame, uint32_t First, uint32_t Last)
+{
+	uint32_t i = First * Width;
+	uint32_t End = Last * Width;
+
+#if POSTPROCESS_X86
+	if (UseSIMD)
+	{
+		for (; i + 4 <= End; i += 4)
+		{
+			__m128i Now = _mm_loadu_si128((const __m128i*)(Frame + i));
+			__m128i Before = _mm_loadu_si128((const __m128i*)(Ghosted.data() + i));
+			_mm_storeu_si128((__m128i*)(Ghosted.data() + i), _mm_avg_epu8(Now, Before));
+		}
+	}
+#endif
+
+	// Average of each channel rounded up, the same as _mm_avg_epu8
+	for (; i < End; i++)
+	{
+		uint32_t a = Frame[i], b = Ghosted[i];
+		Ghosted[i] = (a | b) - (((a ^ b) >> 1) & 0x7F7F7F7F);
+	}
+}
+
+TARGET_SSE2 void PostProcess::upscale(const uint32_t* Source, uint32_t First, uint32_t Last)
+{
+	uint32_t S = std::max(Scale, 1u);
+	uint32_t OutWidth = Width * S;
+
+	for (uint32_t y = First; y < Last; y++)
+	{
+		const uint32_t* In = Source + y * Width;
+		uint32_t* Row = Out.data() + y * S * OutWidth;
+		uint32_t x = 0;
+
+#if POSTPROCESS_X86
+		if (UseSIMD)
+		{
+			if (S == 2)
+			{
+				for (; x + 4 <= Width; x += 4)
+				{
+					__m128i p = _mm_loadu_si128((const __m128i*)(In + x));
+					_mm_storeu_si128((__m128i*)(Row + x * 2), _mm_unpacklo_epi32(p, p));
+					_mm_storeu_si128((__m128i*)(Row + x * 2 + 4), _mm_unpackhi_epi32(p, p));
+				}
+			}
+			else if (S == 3)
+			{
+				for (; x + 4 <= Width; x += 4)
+				{
+					__m128i p = _mm_loadu_si128((const __m128i*)(In + x));
+					_mm_storeu_si128((__m128i*)(Row + x * 3), _mm_shuffle_epi32(p, _MM_SHUFFLE(1, 0, 0, 0)));
+					_mm_storeu_si128((__m128i*)(Row + x * 3 + 4), _mm_shuffle_epi32(p, _MM_SHUFFLE(2, 2, 1, 1)));
+					_mm_storeu_si128((__m128i*)(Row + x * 3 + 8), _mm_shuffle_epi32(p, _MM_SHUFFLE(3, 3, 3, 2)));
+				}
+			}
+			else if (S >= 4)
+			{
+				for (; x < Width; x++)
+				{
+					__m128i p = _mm_set1_epi32((int)In[x]);
+					uint32_t i = x * S;
+					for (; i + 4 <= x * S + S; i += 4)
+					{
+						_mm_storeu_si128((__m128i*)(Row + i), p);
+					}
+
+					for (; i < x * S + S; i++)
+					{
+						Row[i] = In[x];
+					}
+				}
+			}
+		}
+#endif
+
+		for (; x < Width; x++)
+		{
+			std::fill(Row + x * S, Row + x * S + S, In[x]);
+		}
+
+		// The rest of the rows are the same
+		for (uint32_t i = 1; i < S; i++)
+		{
+			memcpy(Row + i * OutWidth, Row, OutWidth * sizeof(uint32_t));
+		}
+	}
+}
+
+TARGET_SSE2 void PostProcess::scale2x(const uint32_t* Source, uint32_t First, uint32_t Last)
+{
+	uint32_t OutWidth = Width * 2;
+
+	for (uint32_t y = First; y < Last; y++)
+	{
+		// Neighbours outside the frame are the pixel itself
+		const uint32_t* Above = Source + (y == 0 ? y : y - 1) * Width;
+		const uint32_t* Row = Source + y * Width;
+		const uint32_t* Below = Source + (y == Height - 1 ? y : y + 1) * Width;
+
+		uint32_t* Top = Out.data() + y * 2 * OutWidth;
+		uint32_t* Bottom = Top + OutWidth;
+
+		// Scale2x, with B above, D left of, F right of and H below E:
+		//		E0 = D == B && B != F && D != H ? D : E
+		//		E1 = B == F && B != D && F != H ? F : E
+		//		E2 = D == H && D != B && H != F ? D : E
+		//		E3 = H == F && D != H && B != F ? F : E
+		auto scalar = [&](uint32_t x)
+		{
+			uint32_t B = Above[x], E = Row[x], H = Below[x];
+			uint32_t D = Row[x == 0 ? x : x - 1];
+			uint32_t F = Row[x == Width - 1 ? x : x + 1];
+
+			Top[x * 2] = D == B && B != F && D != H ? D : E;
+			Top[x * 2 + 1] = B == F && B != D && F != H ? F : E;
+			Bottom[x * 2] = D == H && D != B && H != F ? D : E;
+			Bottom[x * 2 + 1] = H == F && D != H && B != F ? F : E;
+		};
+
+		scalar(0);
+		uint32_t x = 1;
+
+#if POSTPROCESS_X86
+		if (UseSIMD)
+		{
+			// Four pixels at a time, leaving the last for
+			// scalar() since it has no right neighbour.
+			for (; x + 4 < Width; x += 4)
+			{
+				__m128i B = _mm_loadu_si128((const __m128i*)(Above + x));
+				__m128i D = _mm_loadu_si128((const __m128i*)(Row + x - 1));
+				__m128i E = _mm_loadu_si128((const __m128i*)(Row + x));
+				__m128i F = _mm_loadu_si128((const __m128i*)(Row + x + 1));
+				__m128i H = _mm_loadu_si128((const __m128i*)(Below + x));
+
+				__m128i BD = _mm_cmpeq_epi32(B, D);
+				__m128i BF = _mm_cmpeq_epi32(B, F);
+				__m128i DH = _mm_cmpeq_epi32(D, H);
+				__m128i HF = _mm_cmpeq_epi32(H, F);
+
+				__m128i M0 = _mm_andnot_si128(_mm_or_si128(BF, DH), BD);
+				__m128i M1 = _mm_andnot_si128(_mm_or_si128(BD, HF), BF);
+				__m128i M2 = _mm_andnot_si128(_mm_or_si128(BD, HF), DH);
+				__m128i M3 = _mm_andnot_si128(_mm_or_si128(DH, BF), HF);
+
+				__m128i E0 = _mm_or_si128(_mm_and_si128(M0, D), _mm_andnot_si128(M0, E));
+				__m128i E1 = _mm_or_si128(_mm_and_si128(M1, F), _mm_andnot_si128(M1, E));
+				__m128i E2 = _mm_or_si128(_mm_and_si128(M2, D), _mm_andnot_si128(M2, E));
+				__m128i E3 = _mm_or_si128(_mm_and_si128(M3, F), _mm_andnot_si128(M3, E));
+
+				_mm_storeu_si128((__m128i*)(Top + x * 2), _mm_unpacklo_epi32(E0, E1));
+				_mm_storeu_si128((__m128i*)(Top + x * 2 + 4), _mm_unpackhi_epi32(E0, E1));
+				_mm_storeu_si128((__m128i*)(Bottom + x * 2), _mm_unpacklo_epi32(E2, E3));
+				_mm_storeu_si128((__m128i*)(Bottom + x * 2 + 4), _mm_unpackhi_epi32(E2, E3));
+			}
+		}
+#endif
+
+		for (; x < Width; x++)
+		{
+			scalar(x);
+		}
+	}
+}
+
+TARGET_SSE2 void PostProcess::grid(uint32_t First, uint32_t Last)
+{
+	uint32_t S = upscaler == Scale2x ? 2 : std::max(Scale, 1u);
+	uint32_t OutWidth = Width * S;
+
+	for (uint32_t y = First; y < Last; y++)
+	{
+		uint32_t* Row = Out.data() + y * OutWidth;
+		const uint32_t* Mask = y % S == S - 1 ? GridRow.data() : GridColumns.data();
+		uint32_t x = 0;
+
+		// Each channel is darkened by a quarter
+#if POSTPROCESS_X86
+		if (UseSIMD)
+		{
+			for (; x + 4 <= OutWidth; x += 4)
+			{
+				__m128i p = _mm_loadu_si128((const __m128i*)(Row + x));
+				__m128i m = _mm_loadu_si128((const __m128i*)(Mask + x));
+				__m128i Quarter = _mm_and_si128(_mm_srli_epi32(p, 2), m);
+				_mm_storeu_si128((__m128i*)(Row + x), _mm_sub_epi32(p, Quarter));
+			}
+		}
+#endif
+
+		for (; x < OutWidth; x++)
+		{
+			Row[x] -= (Row[x] >> 2) & Mask[x];
+		}
+	}
+}
+
+void PostProcess::parallel(uint32_t nRows, const std::function<void(uint32_t First, uint32_t Last)>& Job)
+{
+	if (Workers.empty())
+	{
+		Job(0, nRows);
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> Guard(Lock);
+
+		// A thread which woke up late for the last job
+		// may still be about to find there's nothing left.
+		Finished.wait(Guard, [this] { return nWorking == 0; });
+
+		this->Job = &Job;
+		this->nRows = nRows;
+
+		// A few bands per thread so a slow one holds the rest up less
+		nBands = std::min(threads() * 4, (nRows + 7) / 8);
+		nBandsDone = 0;
+		NextBand = 0;
+		Generation++;
+	}
+
+	Started.notify_all();
+
+	{
+		std::lock_guard<std::mutex> Guard(Lock);
+		nWorking++;
+	}
+
+	work();
+
+	std::unique_lock<std::mutex> Guard(Lock);
+	Finished.wait(Guard, [this] { return nBandsDone == nBands; });
+}
+
+void PostProcess::work()
+{
+	while (true)
+	{
+		uint32_t Band = NextBand.fetch_add(1);
+		if (Band >= nBands)
+		{
+			break;
+		}
+
+		(*Job)(Band * nRows / nBands, (Band + 1) * nRows / nBands);
+
+		std::lock_guard<std::mutex> Guard(Lock);
+		nBandsDone++;
+	}
+
+	{
+		std::lock_guard<std::mutex> Guard(Lock);
+		nWorking--;
+	}
+
+	Finished.notify_all();
+}
+
+void PostProcess::run()
+{
+	uint64_t Seen = 0;
+
+	std::unique_lock<std::mutex> Guard(Lock);
+
+	while (true)
+	{
+		Started.wait(Guard, [&] { return Stopping || Generation != Seen; });
+
+		if (Stopping)
+		{
+			return;
+		}
+
+		Seen = Generation;
+		nWorking++;
+
+		Guard.unlock();
+		work();
+		Guard.lock();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/// <summary>
+/// Turns the 160x144 frame into what's shown in the window. Each
+/// stage is optional and they run in order:
+///		- Ghosting blends the frame with the ones shown before it,
+///		  like the slow LCD of the original hardware.
+///		- Upscaling repeats each pixel Scale times both ways, or
+///		  doubles the frame with Scale2x which rounds off diagonal
+///		  edges instead of leaving them blocky.
+///		- The LCD grid darkens the edges of each upscaled pixel.
+/// Each stage is split into bands of rows which are processed by a
+/// pool of threads with SSE2, so large outputs take little longer
+/// to show. Every stage gives exactly the same pixels without SSE2
+/// and with any number of threads.
+/// </summary>
+class PostProcess
+{
+public:
+	~PostProcess();
+
+	// Starts nThreads threads including the one calling
+	// process(), 0 for one for each core.
+	void start(uint32_t nThreads = 0);
+	void stop();
+
+	uint32_t threads() { return (uint32_t)Workers.size() + 1; }
+
+	enum Upscaler
+	{
+		Integer,	// Each pixel Scale times
+		Scale2x,	// Twice the size, Scale is ignored
+	} upscaler = Integer;
+
+	uint32_t Scale = 1;
+	bool LCDGrid = false;	// Only drawn when scaled at least twice
+	bool Ghosting = false;
+	bool UseSIMD = true;
+
+	// Whether process() does anything
+	bool enabled();
+
+	// Size of the processed frame
+	uint32_t width();
+	uint32_t height();
+
+	// Processes a 160x144 RGBA8888 frame. The result is
+	// kept until the next call or the settings change.
+	const uint32_t* process(const uint32_t* Frame);
+
+	// Ghosting has faded away this many frames after a change
+	static const uint32_t nGhostingFrames = 8;
+
+	// Time taken by each stage in microseconds
+	struct Timing
+	{
+		double Ghosting = 0;
+		double Upscale = 0;
+		double Grid = 0;
+	};
+
+	Timing LastFrame;	// Of the last frame processed
+	Timing Total;		// Of every frame processed
+	uint64_t nFrames = 0;
+
+private:
+	static const uint32_t Width = 20 * 8;
+	static const uint32_t Height = 18 * 8;
+
+	// Frame blended with the ones before it
+	std::vector<uint32_t> Ghosted;
+	bool GhostedValid = false;
+
+	std::vector<uint32_t> Out;
+
+	// What's subtracted from each pixel of a grid row and of
+	// the other rows, 0 or the mask of the colour channels.
+	std::vector<uint32_t> GridRow, GridColumns;
+
+	void ghost(const uint32_t* Frame, uint32_t First, uint32_t Last);
+	void upscale(const uint32_t* Source, uint32_t First, uint32_t Last);
+	void scale2x(const uint32_t* Source, uint32_t First, uint32_t Last);
+	void grid(uint32_t First, uint32_t Last);
+
+	// Runs Job on bands of nRows rows on every thread
+	// and returns once all of them are done.
+	void parallel(uint32_t nRows, const std::function<void(uint32_t First, uint32_t Last)>& Job);
+
+	// Takes bands until there are none left
+	void work();
+
+	std::vector<std::thread> Workers;
+	std::mutex Lock;
+	std::condition_variable Started;
+	std::condition_variable Finished;
+	bool Stopping = false;
+
+	// The job being run, only changed while no thread is working on it
+	const std::function<void(uint32_t, uint32_t)>* Job = nullptr;
+	uint32_t nRows = 0;
+	uint32_t nBands = 0;
+	uint64_t Generation = 0;
+
+	std::atomic<uint32_t> NextBand{ 0 };
+	uint32_t nBandsDone = 0;
+	uint32_t nWorking = 0;	// Threads which may still take a band
+
+	void run();
+
+	static double elapsed(std::chrono::steady_clock::time_point t0);
+};
\ No newline at end of file
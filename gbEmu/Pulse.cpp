@@ -6,15 +6,28 @@ Pulse::Pulse(uint8_t ChannelNum) : SoundChannel(ChannelNum)
 	
 }
 
-void Pulse::clock()
+bool Pulse::clock(uint64_t Cycle)
 {
+	bool Stepped = false;
+
 	// Increments divider which controls 
 	// period duration of wave.
-	if (gb->nClockCycles % 4 == 0)
+	if (Cycle % 4 == 0)
+	{
+		Stepped = PeriodDiv->clock();
+	}
+
+	// The rest only depends on the registers and the frame
+	// sequencer so it's only re-evaluated after a register was 
+	// written or the frame sequencer clocked a unit, in which
+	// case it's evaluated again on the next T-cycle as well.
+	if (!Dirty && gb->apu.Steps == 0)
 	{
-		PeriodDiv->clock();
+		return Stepped;
 	}
 
+	Dirty = gb->apu.Steps != 0;
+
 	// Check if DAC is off, according to 
 	// PanDocs it is on if and only if
 	// NRx2 & 0xF8 != 0. 
@@ -41,7 +54,7 @@ void Pulse::clock()
 		LenCounterOn = false;
 	}
 
-	if (gb->nClockCycles % (1 << 14) == 0 && NRx4->LenEnable)	// Called at 256Hz
+	if ((gb->apu.Steps & APU::LengthStep) && NRx4->LenEnable)	// Called at 256Hz
 	{
 		if (LenCount++ == 64)
 		{
@@ -69,7 +82,7 @@ void Pulse::clock()
 	}
 
 	// If sweep is on then increment period value at pace
-	if (SweepOn && (gb->nClockCycles % (1 << 15)) == 0 && (++SweepEntrances % CurrentPace == 0))	// Called at 128Hz / NRx0->Pace
+	if (SweepOn && (gb->apu.Steps & APU::SweepStep) && (++SweepEntrances % CurrentPace == 0))	// Called at 128Hz / NRx0->Pace
 	{
 		uint16_t DeltaP = PeriodValue >> NRx0->Step;
 
@@ -120,7 +133,7 @@ void Pulse::clock()
 		gb->apu.NR52->bCH1 = 0;
 	}
 
-	if (EnvelopeOn && gb->nClockCycles % (1 << 16) == 0 && (++EnvelopeEntrances % NRx2->SweepPace == 0))	// Called at 64Hz
+	if (EnvelopeOn && (gb->apu.Steps & APU::EnvelopeStep) && (++EnvelopeEntrances % NRx2->SweepPace == 0))	// Called at 64Hz
 	{
 		// Based on the pace we increment the volume
 		if (NRx2->EnvDir == 0)	// Decrease volume
@@ -141,6 +154,18 @@ void Pulse::clock()
 		}
 	}
 
+	return true;
+}
+
+uint64_t Pulse::nextStep(uint64_t From)
+{
+	// The duty position moves on whenever the divider overflows
+	return nthTick(From, 4, PeriodDiv->untilOverflow());
+}
+
+void Pulse::skip(uint64_t From, uint64_t To)
+{
+	PeriodDiv->advance(ticks(From, To, 4));
 }
 
 uint8_t Pulse::GetSample()
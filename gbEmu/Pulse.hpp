@@ -10,7 +10,9 @@ public:
 	~Pulse();
 
 	virtual uint8_t GetSample() override;
-	void clock();
+	bool clock(uint64_t Cycle) override;
+	uint64_t nextStep(uint64_t From) override;
+	void skip(uint64_t From, uint64_t To) override;
 	void trigger() override;
 
 	// Registers
@@ -0,0 +1,34 @@
+#include "RateControl.hpp"
+#include <algorithm>
+
+void RateControl::reset(uint32_t TargetFrames)
+{
+	Target = TargetFrames;
+	Average = TargetFrames;
+
+	Ratio = 1.0;
+	AverageFill = Average;
+}
+
+double RateControl::update(uint32_t Fill, double Seconds)
+{
+	Average += (Fill - Average) * std::min(1.0, Seconds / Smoothing);
+
+	// How far off the target the queue is, scaled so it reaches
+	// 1 (too empty) or -1 (too full) FullScale away from it.
+	double Error = (Target - Average) / Target / FullScale;
+
+	if (Error <= -1.0 || Error >= 1.0)
+	{
+		Error = std::max(-1.0, std::min(1.0, Error));
+		nSaturated++;
+	}
+
+	// More samples are made while too few are queued
+	double r = 1.0 + MaxDeviation * Error;
+
+	Ratio = r;
+	AverageFill = Average;
+
+	return r;
+}
\ No newline at end of file
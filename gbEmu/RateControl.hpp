@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+
+/// <summary>
+/// Dynamic rate control for the samples queued for the audio device.
+/// The emulator is run by the system clock but the samples are played
+/// by the audio device's, and the two never quite agree, so making a
+/// fixed number of samples per emulated second slowly fills up or
+/// drains the queue, ending in dropped samples or crackles. Instead
+/// the samples made per T-cycle are nudged up while fewer than the
+/// target are queued and down while more are. The pitch changes by 
+/// at most MaxDeviation, too little to hear, and the queue stays 
+/// close to the target however far apart the two clocks are.
+/// </summary>
+class RateControl
+{
+public:
+	// Starts over, keeping about TargetFrames stereo samples queued
+	void reset(uint32_t TargetFrames);
+
+	// Takes the number of samples queued Seconds after the last
+	// update, returns the ratio to multiply the sample rate by.
+	double update(uint32_t Fill, double Seconds);
+
+	// Most the sample rate is changed by (0.5%)
+	double MaxDeviation = 0.005;
+
+	// Distance from the target, as a fraction of it, at
+	// which the rate is changed by MaxDeviation.
+	double FullScale = 0.25;
+
+	// Seconds the fill level is averaged over. The audio device 
+	// takes samples a block at a time, the average evens that out.
+	double Smoothing = 0.1;
+
+	// State of the controller, can be read from any thread. 
+	// Ratio is the last one returned, nSaturated counts 
+	// updates where it was as far as MaxDeviation.
+	std::atomic<double> Ratio{ 1.0 };
+	std::atomic<double> AverageFill{ 0.0 };
+	std::atomic<uint32_t> Target{ 0 };
+	std::atomic<uint64_t> nSaturated{ 0 };
+
+private:
+	double Average = 0.0;
+};
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "RenderThread.hpp"
+
+#include <cstring>
+
+RenderThread::~RenderThread()
+{
+	stop();
+}
+
+void RenderThread::start(const uint8_t* RAM, uint8_t (*DotMatrix)[20 * 8], std::atomic<uint64_t>* DirtyLines)
+{
+	stop();
+
+	memcpy(this->RAM, RAM, sizeof(this->RAM));
+	this->DotMatrix = DotMatrix;
+	this->DirtyLines = DirtyLines;
+
+	// Every tile has to be expanded again from the copy
+	tileCache.connectRAM(this->RAM);
+	for (uint16_t addr = 0x8000; addr < 0x9800; addr += 0x10)
+	{
+		tileCache.invalidate(addr);
+	}
+
+	renderer.RAM = this->RAM;
+	renderer.tileCache = &tileCache;
+
+	Stopping = false;
+	Running = true;
+	Worker = std::thread(&RenderThread::run, this);
+}
+
+void RenderThread::stop()
+{
+	if (!Running)
+	{
+		return;
+	}
+
+	submit();
+
+	{
+		std::lock_guard<std::mutex> Guard(Lock);
+		Stopping = true;
+	}
+
+	Submitted.notify_one();
+	Worker.join();
+	Running = false;
+}
+
+void RenderThread::draw(const LineRenderer::Snapshot& s)
+{
+	Stretch Next;
+	Next.s = s;
+	Next.nWritesBefore = (uint32_t)Pending.Writes.size();
+
+	Pending.Stretches.push_back(Next);
+}
+
+void RenderThread::vramWritten(uint16_t addr, uint8_t data)
+{
+	Write Next;
+	Next.addr = addr;
+	Next.data = data;
+
+	Pending.Writes.push_back(Next);
+}
+
+void RenderThread::submit()
+{
+	if (Pending.Stretches.empty() && Pending.Writes.empty())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> Guard(Lock);
+		Queue.push_back(std::move(Pending));
+
+		// Reuse the memory of a log which was already drawn
+		if (!Free.empty())
+		{
+			Pending = std::move(Free.back());
+			Free.pop_back();
+		}
+		else
+		{
+			Pending = Log();
+		}
+	}
+
+	Submitted.notify_one();
+}
+
+void RenderThread::wait()
+{
+	submit();
+
+	std::unique_lock<std::mutex> Guard(Lock);
+	Drawn.wait(Guard, [this] { return Queue.empty() && !Busy; });
+}
+
+void RenderThread::run()
+{
+	std::unique_lock<std::mutex> Guard(Lock);
+
+	while (true)
+	{
+		Submitted.wait(Guard, [this] { return Stopping || !Queue.empty(); });
+
+		// Everything submitted is drawn before stopping
+		if (Queue.empty())
+		{
+			return;
+		}
+
+		Log Next = std::move(Queue.front());
+		Queue.pop_front();
+		Busy = true;
+
+		Guard.unlock();
+		replay(Next);
+		Guard.lock();
+
+		Next.Stretches.clear();
+		Next.Writes.clear();
+		Free.push_back(std::move(Next));
+
+		Busy = false;
+		Drawn.notify_all();
+	}
+}
+
+void RenderThread::replay(Log& log)
+{
+	// Each stretch is drawn with VRAM as it was when the stretch
+	// ended, so the writes made before then are caught up on first.
+	size_t Written = 0;
+
+	auto catchUp = [&](size_t nWrites)
+	{
+		for (; Written < nWrites; Written++)
+		{
+			const Write& w = log.Writes[Written];
+			RAM[w.addr] = w.data;
+
+			if (w.addr < 0x9800)
+			{
+				tileCache.invalidate(w.addr);
+			}
+		}
+	};
+
+	for (Stretch& Next : log.Stretches)
+	{
+		catchUp(Next.nWritesBefore);
+
+		if (renderer.draw(Next.s, DotMatrix[Next.s.LY]))
+		{
+			LineRenderer::markDirty(DirtyLines, Next.s.LY);
+		}
+	}
+
+	catchUp(log.Writes.size());
+
+	nStretches += log.Stretches.size();
+	nWrites += log.Writes.size();
+}
\ No newline at end of file
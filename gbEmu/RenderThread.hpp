@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "LineRenderer.hpp"
+#include "TileCache.hpp"
+
+/// <summary>
+/// Draws lines on a worker thread so the emulation thread only
+/// has to work out the PPU's timing. The PPU logs a snapshot for
+/// every stretch of a line together with the VRAM writes made in
+/// between, and hands the log over at the end of each line. The worker keeps
+/// its own copy of VRAM and expanded tiles, replays the writes in
+/// order and draws each stretch with the same LineRenderer as the
+/// PPU uses on its own, so the frames are exactly the same.
+/// </summary>
+class RenderThread
+{
+public:
+	~RenderThread();
+
+	// Starts drawing into DotMatrix with a copy of RAM,
+	// lines which change are marked in DirtyLines.
+	void start(const uint8_t* RAM, uint8_t (*DotMatrix)[20 * 8], std::atomic<uint64_t>* DirtyLines);
+
+	// Waits for everything handed over to be drawn, then stops
+	void stop();
+
+	bool Running = false;
+
+	// Called on the emulation thread, these are
+	// only seen by the worker after submit().
+	void draw(const LineRenderer::Snapshot& s);
+	void vramWritten(uint16_t addr, uint8_t data);
+	void submit();
+
+	// Waits until everything submitted has been drawn
+	void wait();
+
+	// Updated by the worker, only read them after wait()
+	uint64_t nStretches = 0;	// Stretches drawn
+	uint64_t nWrites = 0;		// VRAM writes replayed
+
+private:
+	struct Write
+	{
+		uint16_t addr;
+		uint8_t data;
+	};
+
+	struct Stretch
+	{
+		LineRenderer::Snapshot s;
+		uint32_t nWritesBefore;		// Writes made before the stretch ended
+	};
+
+	struct Log
+	{
+		std::vector<Stretch> Stretches;
+		std::vector<Write> Writes;
+	};
+
+	// Being filled by the emulation thread
+	Log Pending;
+
+	// Handed over to the worker
+	std::deque<Log> Queue;
+	std::vector<Log> Free;	// Drawn logs, kept to reuse their memory
+	bool Busy = false;
+	bool Stopping = false;
+
+	std::mutex Lock;
+	std::condition_variable Submitted;
+	std::condition_variable Drawn;
+	std::thread Worker;
+
+	// Only used by the worker
+	uint8_t RAM[0xFFFF + 1];
+	TileCache tileCache;
+	LineRenderer renderer;
+
+	uint8_t (*DotMatrix)[20 * 8] = nullptr;
+	std::atomic<uint64_t>* DirtyLines = nullptr;
+
+	void run();
+	void replay(Log& log);
+};
\ No newline at end of file
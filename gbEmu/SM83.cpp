@@ -7,6 +7,7 @@
 #include <iostream>
 #endif
 #include <sstream>
+#include <cstring>
 
 void SM83::connectGB(GBInternal* gb)
 {
@@ -59,6 +60,13 @@ void SM83::clock()
 	{
 		nMachineCycles++;
 
+		// Translated code runs ahead of the clock, check
+		// if an interrupt should have cut it short.
+		if (Run != nullptr)
+		{
+			checkRun();
+		}
+
 		// =============== Intsruction Execution =============== 
 		if (cycle == 0)
 		{
@@ -72,40 +80,62 @@ void SM83::clock()
 				}
 			}
 
-			// Fetch Next Instruction
-			uint8_t data = gb->read(PC++);
+			// Fetch Next Instruction. If it has already been 
+			// decoded then the opcode and any immediate data
+			// come from the block cache instead of memory.
+			uint8_t data;
+
+			Op = RereadInstruction || DEBUG_MODE ? nullptr : gb->blockCache.fetch(PC);
 
-			// Halt instruction bug
-			if (RereadInstruction)
+			if (Op != nullptr)
+			{
+				data = Op->Opcode;
+				PC += Op->Length;
+			}
+			else
 			{
-				// TODO: Fix potential bug here
-				PC--;
-				RereadInstruction = false;
+				data = gb->read(PC++);
+
+				// Halt instruction bug
+				if (RereadInstruction)
+				{
+					// TODO: Fix potential bug here
+					PC--;
+					RereadInstruction = false;
+				}
 			}
 
-			CurrentInstruction = InstructionSet[data];
-			cycle += CurrentInstruction.cycles;
-			a = CurrentInstruction.a;
-			b = CurrentInstruction.b;
+			// Instructions in ROM may have been translated to native 
+			// code. If so the whole run is executed here and its 
+			// cycles are counted down as usual.
+			bool Native = Op != nullptr && Op->PC < 0x8000 && gb->jit.Enabled 
+				&& IMEDelaySet == 0xFF && runNative();
 
-#if DEBUG_MODE
-			//if (PC-1 == 0xC07f)
+			if (!Native)
 			{
-				std::cout << std::hex
-					<< (int)(PC - 1)
-					<< std::dec << ' ' << CurrentInstruction.mnemonic()
-					<< ' ' << std::hex << (int)data;
+				cycle += InstructionSet[data].cycles;
+				nInstructions++;
 
-				std::cout << std::endl << std::hex << "AF = $" << (int)AF << std::endl;
-				std::cout << "BC = $" << (int)BC << std::endl;
-				std::cout << "DE = $" << (int)DE << std::endl;
-				std::cout << "HL = $" << (int)HL << std::endl;
-
-				std::cout << std::endl;
-			}
+#if DEBUG_MODE
+				//if (PC-1 == 0xC07f)
+				{
+					std::cout << std::hex
+						<< (int)(PC - 1)
+						<< std::dec << ' ' << disassemble(InstructionSet[data])
+						<< ' ' << std::hex << (int)data;
+
+					materializeFlags();
+					std::cout << std::endl << std::hex << "AF = $" << (int)AF << std::endl;
+					std::cout << "BC = $" << (int)BC << std::endl;
+					std::cout << "DE = $" << (int)DE << std::endl;
+					std::cout << "HL = $" << (int)HL << std::endl;
+
+					std::cout << std::endl;
+				}
 #endif
 
-			CurrentInstruction.op();
+				execute(data);
+			}
 
 
 			// Before fetching another instruction there
@@ -173,2137 +203,1705 @@ void SM83::InterruptServiceRoutine()
 	cycle += 5;
 }
 
-SM83::SM83()
+bool SM83::runNative()
 {
+	const JITRun* run = gb->jit.lookup(Op, gb->blockCache.remaining());
 
-	InstructionSet[0b00'000'000] =
+	// Accesses to memory have to be seen by the idle loop detector
+	if (run == nullptr || (run->Memory && gb->idleLoop.Watching))
 	{
-		[]() {
-			return "NOP ()";
-		},
-		[this]() {
+		return false;
+	}
 
-		},
-		1
-	};
+	materializeFlags();
 
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-	{
-		for (uint8_t j = 0; j <= 7; j + 1 == 0b110 ? j += 2 : j++)
-		{
-			InstructionSet[0x40 | (i << 3) | j] =
-			{
-				[this]() {
-					uint8_t r = GPRString(a);
-					uint8_t rp = GPRString(b);
-					std::stringstream s;
-					s << "LD " << r << "," << rp << " (r <-r')";
-					return s.str();
-	;			},
-				[this]() {
-					uint8_t& r = GPR(a);
-					uint8_t& rp = GPR(b);
-					r = rp;
-				},
-				1,
-				i,
-				j
-			};
-		}
-	}
+	JITRegisters r = { AF, BC, DE, HL, SP };
+	RunStart = r;
+	RunPC = Op->PC;
 
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
+	uint8_t Done = run->Code(&r);
+
+	// Stopped at the first instruction, nothing has changed
+	if (Done == 0)
 	{
-		InstructionSet[0x00 | (i << 3) | 0b110] =
-		{
-			[this]() {
-				uint8_t rStr = GPRString(a);
-				std::stringstream s;
-				s << "LD " << rStr << ", [$" << std::hex << (int)PC << std::dec << "] = $" << std::hex << (int)gb->read(PC) << std::dec << " (r <- n)";
-				return s.str();
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-				r = gb->read(PC++);
-			},
-			2,
-			i
-		};
-
-		InstructionSet[(0b01 << 6) | (i << 3) | 0b110] =
-		{
-			[]() {
-				return "LD r, (HL) (r <- (HL))";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-				r = gb->read(HL);
-			},
-			2,
-			i
-		};
+		gb->jit.nExits++;
+		return false;
 	}
 
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-	{
+	AF = r.AF;
+	BC = r.BC;
+	DE = r.DE;
+	HL = r.HL;
+	SP = r.SP;
+	PC = RunPC;
 
-		InstructionSet[0b01'110'000 | i] =
-		{
-			[]() {
-				return "LD (HL),r ((HL) <- r)";
-			},
-			[this]() {
-				uint8_t r = GPR(a);
-				gb->write(HL, r);
-			},
-			2,
-			i
-		};
+	for (uint8_t i = 0; i < Done; i++)
+	{
+		PC += Op[i].Length;
 	}
 
-	InstructionSet[0b00'110'110] =
-	{
-		[]() {
-			return "LD (HL), n ((HL) <- n)";
-		},
-		[this]() {
-			gb->write(HL, gb->read(PC++));
-		},
-		3
-	};
-
-	InstructionSet[0b00'001'010] =
-	{
-		[]() {
-			return "LD A, (BC) (A <- (BC))";
-		},
-		[this]() {
-			A = gb->read(BC);
-		},
-		2
-	};
-
-	InstructionSet[0b00'011'010] =
-	{
-		[]() {
-			return "LD A, (DE)  (A <- (DE))";
-		},
-		[this]() {
-			A = gb->read(DE);
-		},
-		2
-	};
-
-	InstructionSet[0b11'110'010] =
-	{
-		[]() {
-			return "LD A, (C) (A <- (0xFF00 + C))";
-		},
-		[this]() {
-			A = gb->read(0xFF00 + C);
-		},
-		2
-	};
-
-	InstructionSet[0b11'100'010] =
-	{
-		[]() {
-			return "LD (C), A ((0xFF00H+C) <- A)";
-		},
-		[this]() {
-			gb->write(0xFF00 + C, A);
-		},
-		2
-	};
-
-	InstructionSet[0b11'110'000] =
-	{
-		[this]() {
-			std::stringstream s;
-			s << "LD A, [$" << std::hex << (int)(0xFF00 + gb->read(PC)) << std::dec << "] = $" << std::hex << (int)gb->read(0xFF00 + gb->read(PC)) << std::dec << " (A <-(n))";
-			return s.str();
-		},
-		[this]() {
-			A = gb->read(0xFF00 + gb->read(PC++));
-		},
-		3
-	};
-
-	InstructionSet[0b11'100'000] =
-	{
-		[this]() {
-			std::stringstream s;
-			s << "LD (0x" << std::hex <<0xFF00 + gb->read(PC) << std::dec << "), A ((n) <- A)";
-			return s.str();
-		},
-		[this]() {
-			gb->write(0xFF00 + gb->read(PC++), A);
-		},
-		3
-	};
-
-	InstructionSet[0b11'111'010] =
-	{
-		[]() {
-			return "LD A, (nn)(A <- (nn))";
-		},
-		[this]() {
-			uint8_t LO, HI;
-			LO = gb->read(PC++);
-			HI = gb->read(PC++);
-			A = gb->read((HI << 8) | LO);
-		},
-		4
-	};
-
-	InstructionSet[0b11'101'010] =
-	{
-		[]() {
-			return "LD (nn), A ((nn) <- A)";
-		},
-		[this]() {
-			uint8_t LO, HI;
-			LO = gb->read(PC++);
-			HI = gb->read(PC++);
-			gb->write((HI << 8) | LO, A);
-		},
-		4
-	};
-
-	InstructionSet[0b00'101'010] =
-	{
-		[]() {
-			return "LD A, (HLI) (A <- (HL), HL <- HL + 1)";
-		},
-		[this]() {
-			A = gb->read(HL++);
-		},
-		2
-	};
-
-	InstructionSet[0b00'111'010] =
-	{
-		[]() {
-			return "LD A, (HLD) (A <- (HL), HL <- HL1)";
-		},
-		[this]() {
-			A = gb->read(HL--);
-		},
-		2
-	};
-
-	InstructionSet[0b00'000'010] =
-	{
-		[]() {
-			return "LD (BC), A ((BC) <- A)";
-		},
-		[this]() {
-			gb->write(BC, A);
-		},
-		2
-	};
-
-	InstructionSet[0b00'010'010] =
-	{
-		[]() {
-			return "LD (DE), A ((DE) <- A)";
-		},
-		[this]() {
-			gb->write(DE, A);
-		},
-		2
-	};
-
-	InstructionSet[0b00'100'010] =
+	// The interpreter carries on from the instruction which stopped it
+	RunDone = Done;
+	RunLeft = 0;
+	if (Done < run->nInstructions)
 	{
-		[]() {
-			return "LD (HLI), A ((HL) <- A HL <- HL + 1)";
-		},
-		[this]() {
-			gb->write(HL++, A);
-		},
-		2
-	};
-
-	InstructionSet[0b00'110'010] =
-	{
-		[this]() {
-			std::stringstream s;
-			s << "LD [HL-] = $" << std::hex << (int)HL << std::dec << ", A = $" << std::hex << (int)A << std::dec << " ((HL) <- A, HL <- HL-1)";
-			return s.str();
-		},
-		[this]() {
-			gb->write(HL--, A);
-		},
-		2
-	};
-
-	for (uint8_t i = 0; i < 4; i++)
-	{
-		InstructionSet[0b00'000'001 | (i << 4)] =
-		{
-			[]() {
-				return "LD dd, nn (dd <- nn)";
-			},
-			[this]() {
-				uint16_t& dd = ss(a);
-				uint8_t LO, HI;
-				LO = gb->read(PC++);
-				HI = gb->read(PC++);
-				dd = (HI << 8) | LO;
-			},
-			3,
-			i
-		};
+		RunLeft = run->Remaining[Done];
+		gb->jit.nExits++;
 	}
 
-	InstructionSet[0b11'111'001] =
-	{
-		[]() {
-			return "LD SP, HL (SP <- HL)";
-		},
-		[this]() {
-			SP = HL;
-		},
-		2
-	};
-
-	for (uint8_t i = 0; i <= 3; i++)
-	{
+	cycle += run->Cycles - RunLeft;
+	nInstructions += Done;
+	gb->blockCache.skip(Done - 1);
 
+	gb->jit.nRuns++;
+	gb->jit.nInstructions += Done;
 
-		InstructionSet[0b11'000'101 | (i << 4)] =
-		{
-			[this]() {
-				std::stringstream s;
-				s << "PUSH " << qqString(a) << " ((SP-1) <- qqH (SP - 2) <- qqL SP <- SP - 2)";
-				return s.str();
-			},
-			[this]() {
-				uint16_t r = qq(a);
-				gb->write(--SP, r >> 8);
-				gb->write(--SP, r & 0x00FF);
-			},
-			4,
-			i
-		};
+	// Runs don't contain instructions which change IME so 
+	// if it's unset no interrupt can land part way through.
+	if (IME)
+	{
+		Run = run;
 	}
 
-	for (uint8_t i = 0; i <= 2; i++)
+	return true;
+}
+
+void SM83::checkRun()
+{
+	if (cycle == 0)
 	{
-		InstructionSet[0b11'000'001 | (i << 4)] =
-		{
-			[this]() {
-				std::stringstream s;
-				s << "POP " << qqString(a) << " (qqL <- (SP) qqH <- (SP + 1) SP <- SP + 2)";
-				return s.str();
-			},
-			[this]() {
-				uint16_t& r = qq(a);
-				uint8_t LO = gb->read(SP++);
-				uint8_t HI = gb->read(SP++);
-
-				r = (HI << 8) | LO;
-			},
-			3,
-			i
-		};
+		// Run finished
+		Run = nullptr;
+		return;
 	}
 
-	InstructionSet[0b11'110'001] =
-	{
-		[this]() {
-			std::stringstream s;
-			s << "POP AF (qqL <- (SP) qqH <- (SP + 1) SP <- SP + 2)";
-			return s.str();
-		},
-		[this]() {
-			uint8_t LO = gb->read(SP++);
-			uint8_t HI = gb->read(SP++);
-
-			A = HI;
-			F = LO & 0xF0;
-		},
-		3,
-		3
-	};
-
-	InstructionSet[0b11'111'000] =
+	if ((gb->IE->reg & gb->IF->reg & 0x1F) == 0)
 	{
-		[]() {
-			return "LD, HL, SP, e (HL <- SP+e)";
-		},
-		[this]() {
-			int16_t e = (int8_t)gb->read(PC++);
-			uint16_t tmp = SP + e;
-			HL = tmp & 0xFFFF;
-
-			HC = ((SP & 0xF) + (e & 0xF)) >> 4;
-			CY = ((SP & 0xFF) + (uint8_t)(e & 0xFF)) >> 8;
-
-			Z = 0;
-			N = 0;
-
-		},
-		3
-	};
+		return;
+	}
 
-	InstructionSet[0b00'001'000] =
-	{
-		[]() {
-			return "LD (nn), SP ((nn) <- SPL (nn + 1) <- SPH)";
-		},
-		[this]() {
-			uint8_t LO, HI;
-			LO = gb->read(PC++);
-			HI = gb->read(PC++);
-			uint16_t nn = (HI << 8) | LO;
-			gb->write(nn++, SP & 0x00FF);
-			gb->write(nn, SP >> 8);
-		},
-		5
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
+	// An interrupt is pending. If the interpreter would be 
+	// fetching one of the run's instructions now, go back 
+	// and redo the instructions before it so the interrupt
+	// is serviced with the same registers and memory. All
+	// of the run's writes are undone first as the ones being
+	// redone would otherwise be applied twice.
+	for (uint8_t i = 1; i < RunDone; i++)
 	{
-		InstructionSet[0b10'000'000 | i] =
+		if (Run->Remaining[i] - RunLeft == cycle)
 		{
-			[]() {
-				return "A, r (A <- A + r)";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-				uint16_t tmp = A + r;
-				uint8_t tmp2 = ((A & 0xF) + (r & 0xF)) >> 4;
-
-				HC = tmp2 != 0;
-				CY = (tmp >> 8) != 0;
-				A = tmp;
-				Z = A == 0;
-				N = 0;
-			},
-			1,
-			i
-		};
-	}
+			gb->jit.undo(Run, 0, RunDone);
+
+			AF = RunStart.AF;
+			BC = RunStart.BC;
+			DE = RunStart.DE;
+			HL = RunStart.HL;
+			SP = RunStart.SP;
+			PC = RunPC;
+
+			// Nothing else could have changed the memory
+			// they read and the ROM bank is the same.
+			Op = nullptr;
+			for (uint8_t j = 0; j < i; j++)
+			{
+				execute(gb->read(PC++));
+			}
 
-	InstructionSet[0b11'000'110] =
-	{
-		[]() {
-			return "ADD A,n (A <- A+n)";
-		},
-		[this]() {
-			uint8_t n = gb->read(PC++);
-			uint16_t tmp = A + n;
-			uint8_t tmp2 = ((A & 0xF) + (n & 0xF)) >> 4;
-
-			HC = tmp2 != 0;
-			CY = (tmp >> 8) != 0;
-			A = tmp;
-			Z = A == 0;
-			N = 0;
-		},
-		2
-	};
-
-	InstructionSet[0b10'000'110] =
-	{
-		[]() {
-			return "ADD A, (HL) (A <- A+(HL))";
-		},
-		[this]() {
-			uint8_t D = gb->read(HL);
-			uint16_t tmp = A + D;
-
-			HC = ((A & 0xF) + (D & 0xF)) >> 4;
-			CY = (tmp >> 8) != 0;
-			A = tmp;
-
-			N = 0;
-			Z = A == 0;
-		},
-		2
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-	{
+			cycle = 0;
+			nInstructions -= RunDone - i;
 
-		InstructionSet[0b10'001'000 | i] =
-		{
-			[]() {
-				return "ADC A, r (A <- A+s+CY)";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				uint16_t tmp = A + r + CY;
-				uint8_t tmp2 = ((A & 0xF) + (r & 0xF) + CY) >> 4;
-
-				HC = tmp2 != 0;
-				CY = (tmp >> 8) != 0;
-				A = tmp;
-				Z = A == 0;
-				N = 0;
-			},
-			1,
-			i
-		};
+			gb->jit.nInstructions -= RunDone - i;
+			gb->jit.nRollbacks++;
+
+			Run = nullptr;
+			return;
+		}
 	}
+}
 
-	InstructionSet[0b11'001'110] =
-	{
-		[]() {
-		return 	" ADC A, n (A <- A+n+CY)";
-		},
-		[this]() {
-			uint8_t n = gb->read(PC++);
-			uint16_t tmp = A + n + CY;
-			uint8_t tmp2 = ((A & 0xF) + (n & 0xF) + CY) >> 4;
-
-			HC = tmp2 != 0;
-			CY = (tmp >> 8) != 0;
-			A = tmp;
-			Z = A == 0;
-			N = 0;
-		},
-		2
-	};
-
-	InstructionSet[0b10'001'110] =
-	{
-		[]() {
-		return 	" ADC A, (HL) (A <- A+n+CY)";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-			uint16_t tmp = A + M + CY;
-			uint8_t tmp2 = ((A & 0xF) + (M & 0xF) + CY) >> 4;
-
-			HC = tmp2 != 0;
-			CY = (tmp >> 8) != 0;
-			A = tmp;
-			Z = A == 0;
-			N = 0;
-		},
-		2
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
+// ============== Instruction Execution ==============
+
+inline uint8_t SM83::imm8()
+{
+	// PC has already been moved past cached instructions
+	if (Op != nullptr)
 	{
-		InstructionSet[0b10'010'000 | i] =
-		{
-			[]() {
-				return "SUB r (A <- A-r)";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				HC = (A & 0xF) < (r & 0xF);
-				CY = A < r;
-
-				A -= r;
-				Z = A == 0;
-				N = 1;
-			},
-			1,
-			i
-		};
+		return Op->Operand;
 	}
 
-	InstructionSet[0b11'010'110] =
-	{
-		[]() {
-			return "SUB n ( A <- A-n)";
-		},
-		[this]() {
-			uint8_t n = gb->read(PC++);
-
-			HC = (A & 0xF) < (n & 0xF);
-			CY = A < n;
-
-			A -= n;
-			Z = A == 0;
-			N = 1;
-		},
-		2
-	};
-
-	InstructionSet[0b10'010'110] =
-	{
-		[]() {
-			return "SUB (HL) ( A <- A-(HL))";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-
-			HC = (A & 0xF) < (M & 0xF);
-			CY = A < M;
-
-			A -= M;
-			Z = A == 0;
-			N = 1;
-		},
-		2
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-	{
+	return gb->read(PC++);
+}
 
-		InstructionSet[0b10'011'000 | i] =
-		{
-			[]() {
-				return "SBC A, r (A <- A-r-CY)";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				HC = (A & 0xF) < ((r & 0xF) + CY);
-				bool CY_tmp = A < (r + CY);
-				A -= (r + CY);
-				CY = CY_tmp;
-				Z = A == 0;
-				N = 1;
-			},
-			1,
-			i
-		};
+inline uint16_t SM83::imm16()
+{
+	if (Op != nullptr)
+	{
+		return Op->Operand;
 	}
 
-	InstructionSet[0b11'011'110] =
-	{
-		[]() {
-			return "SBC A, n (A <- A - n - CY)";
-		},
-		[this]() {
-			uint8_t n = gb->read(PC++);
+	uint8_t LO = gb->read(PC++);
+	uint8_t HI = gb->read(PC++);
+	return (HI << 8) | LO;
+}
 
-			HC = (A & 0xF) < ((n & 0xF) + CY);
-			bool CY_tmp = A < (n + CY);
+inline void SM83::push(uint16_t r)
+{
+	gb->write(--SP, r >> 8);
+	gb->write(--SP, r & 0x00FF);
+}
 
-			A -= (n + CY);
-			CY = CY_tmp;
+inline uint16_t SM83::pop()
+{
+	uint8_t LO = gb->read(SP++);
+	uint8_t HI = gb->read(SP++);
+	return (HI << 8) | LO;
+}
 
-			Z = A == 0;
-			N = 1;
-		},
-		2
-	};
+void SM83::useLazyFlags(bool Enabled)
+{
+	materializeFlags();
+	LazyFlags = Enabled;
+}
 
-	InstructionSet[0b10'011'110] =
-	{
-		[]() {
-			return "SBC A, (HL) (A <- A - (HL) - CY)";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-
-			HC = (A & 0xF) < ((M & 0xF) + CY);
-			bool CY_tmp = A < (M + CY);
-			A -= (M + CY);
-			CY = CY_tmp;
-			Z = A == 0;
-			N = 1;
-		},
-		2
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
+uint8_t SM83::flags()
+{
+	if (LazyOp == LazyNone)
 	{
-		InstructionSet[0b10'100'000 | i] =
-		{
-			[]() {
-				return "AND r (A & r)";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				A &= r;
-				CY = 0;
-				HC = 1;
-				N = 0;
-				Z = A == 0;
-			},
-			1,
-			i
-		};
+		return F;
 	}
 
-	InstructionSet[0b11'100'110] =
-	{
-		[]() {
-			return "AND n (A & n)";
-		},
-		[this]() {
-			A &= gb->read(PC++);
-			CY = 0;
-			HC = 1;
-			N = 0;
-			Z = A == 0;
-		},
-		2
-	};
-
-	InstructionSet[0b10'100'110] =
-	{
-		[]() {
-			return "AND (HL) (A & (HL))";
-		},
-		[this]() {
-			A &= gb->read(HL);
-			CY = 0;
-			HC = 1;
-			N = 0;
-			Z = A == 0;
-		},
-		2
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-	{
-		InstructionSet[0b10'110'000 | i] =
-		{
-			[]() {
-				return "OR r (A | r)";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				A |= r;
-				CY = 0;
-				HC = 0;
-				N = 0;
-				Z = A == 0;
-			},
-			1,
-			i
-		};
+	uint8_t X = LazyX;
+	uint8_t Y = LazyY;
+	bool c = LazyCarry;
+
+	bool Zero = LazyR == 0;
+	bool Subtract = false;
+	bool Half = false;
+	bool Carry = false;
+
+	switch (LazyOp)
+	{
+	case LazyAdd:
+		Half = ((X & 0xF) + (Y & 0xF) + c) >> 4;
+		Carry = (X + Y + c) >> 8;
+		break;
+	case LazySub:
+		Subtract = true;
+		Half = (X & 0xF) < ((Y & 0xF) + c);
+		Carry = X < (Y + c);
+		break;
+	case LazyAnd:
+		Half = true;
+		break;
+	case LazyOr:
+		break;
+	case LazyInc:
+		Half = (X & 0xF) == 0xF;
+		Carry = CY;
+		break;
+	case LazyDec:
+		Subtract = true;
+		Half = (X & 0xF) == 0;
+		Carry = CY;
+		break;
 	}
 
-	InstructionSet[0b11'110'110] =
-	{
-		[]() {
-			return "OR n (A | n)";
-		},
-		[this]() {
-			A |= gb->read(PC++);
-			CY = 0;
-			HC = 0;
-			N = 0;
-			Z = A == 0;
-		},
-		2
-	};
-
-	InstructionSet[0b10'110'110] =
-	{
-		[]() {
-			return "OR (HL) (A | (HL))";
-		},
-		[this]() {
-			A |= gb->read(HL);
-			CY = 0;
-			HC = 0;
-			N = 0;
-			Z = A == 0;
-		},
-		2
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-	{
-		InstructionSet[0b10'101'000 | i] =
-		{
-			[]() {
-				return "XOR r (A ^ r)";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				A ^= r;
-				CY = 0;
-				HC = 0;
-				N = 0;
-				Z = A == 0;
-			},
-			1,
-			i
-		};
-	}
+	return (Zero << 7) | (Subtract << 6) | (Half << 5) | (Carry << 4) | (F & 0x0F);
+}
 
-	InstructionSet[0b11'101'110] =
-	{
-		[]() {
-			return "XOR n (A ^ n)";
-		},
-		[this]() {
-			A ^= gb->read(PC++);
-			CY = 0;
-			HC = 0;
-			N = 0;
-			Z = A == 0;
-		},
-		2
-	};
-
-	InstructionSet[0b10'101'110] =
-	{
-		[]() {
-			return "XOR (HL) (A ^ (HL))";
-		},
-		[this]() {
-			A ^= gb->read(HL);
-			CY = 0;
-			HC = 0;
-			N = 0;
-			Z = A == 0;
-		},
-		2
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-	{
-		InstructionSet[0b10'111'000 | i] =
-		{
-			[]() {
-				return "CP r (A == r)";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				Z = A == r;
-				HC = (A & 0xF) < (r & 0xF);
-				N = 1;
-				CY = A < r;
-			},
-			1,
-			i
-		};
-	}
+inline void SM83::lazy(uint8_t Op, uint8_t X, uint8_t Y, bool Carry, uint8_t R)
+{
+	LazyOp = Op;
+	LazyX = X;
+	LazyY = Y;
+	LazyCarry = Carry;
+	LazyR = R;
+}
 
-	InstructionSet[0b11'111'110] =
-	{
-		[this]() {
-			std::stringstream s;
-			s << "CP $" << std::hex << (int)gb->read(PC) << std::dec << " (A == n)";
-			return s.str();
-		},
-		[this]() {
-			uint8_t n = gb->read(PC++);
-			Z = A == n;
-			HC = (A & 0xF) < (n & 0xF);
-			N = 1;
-			CY = A < n;
-		},
-		2
-	};
-
-	InstructionSet[0b10'111'110] =
-	{
-		[]() {
-			return "CP (HL) (A == (HL))";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-			Z = A == M;
-			HC = (A & 0xF) < (M & 0xF);
-			N = 1;
-			CY = A < M;
-		},
-		2
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-	{
-		InstructionSet[0b00'000'100 | (i << 3)] =
-		{
-			[]() {
-				return "INC r (r <- r+1)";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				HC = ((r & 0xF) + (1 & 0xF)) >> 4;
-				N = 0;
-				r += 1;
-				Z = r == 0;
-			},
-			1,
-			i
-		};
-	}
+inline bool SM83::condition(uint8_t opcode)
+{
+	materializeFlags();
 
-	InstructionSet[0b00'110'100] =
-	{
-		[]() {
-			return "INC (HL) ((HL) <- (HL)+1)";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-			HC = ((M & 0xF) + (1 & 0xF)) >> 4;
-			N = 0;
-			M += 1;
-			Z = M == 0;
-			gb->write(HL, M);
-		},
-		3
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
+	switch ((opcode >> 3) & 0b11)
 	{
-		InstructionSet[0b00'000'101 | (i << 3)] =
-		{
-			[this]() {
-				std::stringstream s;
-				uint8_t r = GPR(a);
-				char rStr = GPRString(a);
-				s << "DEC " << rStr << " = $" << std::hex << (int)r << std::dec << " (r <- r-1)";
-				return s.str();;
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-				HC = (r & 0xF) < (1 & 0xF);
-				N = 1;
-				r--;
-				Z = r == 0;
-			},
-			1,
-			i
-		};
+	case 0b00:
+		return Z == 0;
+	case 0b01:
+		return Z == 1;
+	case 0b10:
+		return CY == 0;
+	default:
+		return CY == 1;
 	}
+}
 
-	InstructionSet[0b00'110'101] =
-	{
-		[]() {
-			return "DEC (HL) ((HL) <- (HL)-1)";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-			HC = (M & 0xF) < (1 & 0xF);
-			N = 1;
-			M -= 1;
-			Z = M == 0;
-			gb->write(HL, M);
-		},
-		3
-	};
-
-	InstructionSet[0b00'001'001] =
-	{
-		[]() {
-			return "ADD HL,BC (HL <- HL+BC)";
-		},
-		[this]() {
-			HC = (((HL & 0xFFF) + (BC & 0xFFF)) >> 12) != 0;
-			CY = (((uint32_t)HL + (uint32_t)BC) >> 16) != 0;
-			HL += BC;
-			N = 0;
-		},
-		2
-	};
-
-	InstructionSet[0b00'011'001] =
-	{
-		[]() {
-			return "ADD HL,DE (HL <- HL+DE)";
-		},
-		[this]() {
-			HC = (((HL & 0xFFF) + (DE & 0xFFF)) >> 12) != 0;
-			CY = (((uint32_t)HL + (uint32_t)DE) >> 16) != 0;
-			HL += DE;
-			N = 0;
-		},
-		2
-	};
-
-	InstructionSet[0b00'101'001] =
-	{
-		[]() {
-			return "ADD HL,HL (HL <- HL+HL)";
-		},
-		[this]() {
-			HC = (((HL & 0xFFF) + (HL & 0xFFF)) >> 12) != 0;
-			CY = (((uint32_t)HL + (uint32_t)HL) >> 16) != 0;
-			HL += HL;
-			N = 0;
-		},
-		2
-	};
-
-	InstructionSet[0b00'111'001] =
-	{
-		[]() {
-			return "ADD HL,SP (HL <- HL+SP)";
-		},
-		[this]() {
-			HC = (((HL & 0xFFF) + (SP & 0xFFF)) >> 12) != 0;
-			CY = (((uint32_t)HL + (uint32_t)SP) >> 16) != 0;
-			HL += SP;
-			N = 0;
-		},
-		2
-	};
-
-	InstructionSet[0b11'101'000] =
-	{
-		[]() {
-			return "ADD SP,e (SP <- SP+e)";
-		},
-		[this]() {
-			int16_t e = (int8_t)gb->read(PC++);
-			
-			uint16_t tmp = SP + e;
-
-			HC = ((SP & 0xF) + (e & 0xF)) >> 4;
-			CY = ((SP & 0xFF) + (uint8_t)(e & 0xFF)) >> 8;
-			
-			SP = tmp;
-			N = 0;
-			Z = 0;
-		},
-		4
-	};
-
-	for (uint8_t i = 0; i <= 3; i++)
+inline void SM83::add8(uint8_t n)
+{
+	if (LazyFlags)
 	{
-		InstructionSet[0b00'000'011 | (i << 4)] =
-		{
-			[]() {
-				return "INC ss (ss <- ss + 1)";
-			},
-			[this]() {
-				uint16_t& r = ss(a);
-
-				r += 1;
-			},
-			2,
-			i
-		};
-
-		InstructionSet[0b00'001'011 | (i << 4)] =
-		{
-			[]() {
-				return "DEC ss (ss <- ss - 1)";
-			},
-			[this]() {
-				uint16_t& r = ss(a);
-
-				r -= 1;
-			},
-			2,
-			i
-		};
+		lazy(LazyAdd, A, n, 0, A + n);
+		A += n;
+		return;
 	}
 
-	InstructionSet[0b00'000'111] =
-	{
-		[]() {
-			return "RLCA";
-		},
-		[this]() {
-			CY = A >> 7;
-			A <<= 1;
-			A |= CY;
-			HC = 0;
-			N = 0;
-			Z = 0;
-		},
-		1
-	};
-
-	InstructionSet[0b00'010'111] =
-	{
-		[]() {
-			return "RLA";
-		},
-		[this]() {
-			uint8_t tmp = A >> 7;
-			A <<= 1;
-			A |= CY;
-			CY = tmp;
-			HC = 0;
-			N = 0;
-			Z = 0;
-		},
-		1
-	};
-
-	InstructionSet[0b00'001'111] =
-	{
-		[]() {
-			return "RRCA";
-		},
-		[this]() {
-			CY = A & 0x01;
-			A >>= 1;
-			A |= CY << 7;
-			HC = 0;
-			N = 0;
-			Z = 0;
-		},
-		1
-	};
-
-	InstructionSet[0b00'011'111] =
-	{
-		[]() {
-			return "RRA";
-		},
-		[this]() {
-			uint8_t tmp = A & 0x01;
-			A >>= 1;
-			A |= CY << 7;
-			CY = tmp;
-			HC = 0;
-			N = 0;
-			Z = 0;
-		},
-		1
-	};
-
-	// ========== 16-bit Opcode Instructions ==========
-
-	InstructionSet[0b11'001'011] =
-	{
-		[]() {
-			return "";
-		},
-		[this]() {
-			uint8_t data = gb->read(PC++);
-
-			CurrentInstruction16Bit = InstructionSet16Bit[data];
-			cycle += CurrentInstruction16Bit.cycles;
-			a = CurrentInstruction16Bit.a;
-			b = CurrentInstruction16Bit.b;
+	uint16_t tmp = A + n;
 
-			CurrentInstruction16Bit.op();
-		},
-		0
-	};
+	HC = (((A & 0xF) + (n & 0xF)) >> 4) != 0;
+	CY = (tmp >> 8) != 0;
+	A = tmp;
+	Z = A == 0;
+	N = 0;
+}
 
-	// Bit Instructions
+inline void SM83::adc8(uint8_t n)
+{
+	materializeFlags();
 
-	for (uint8_t c = 0; c <= 7; c++)
+	if (LazyFlags)
 	{
-		for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-		{
-			InstructionSet16Bit[0b01'000'000 | (c << 3) | i] =
-			{
-				[]() {
-					return "BIT b, r (Z <- ~rb)";
-				},
-				[this]() {
-					uint8_t& r = GPR(a);
-					
-					Z = (~r >> b) & 0b1;
-					HC = 1;
-					N = 0;
-				},
-				2,
-				i,
-				c
-			};
-		}
+		uint8_t R = A + n + CY;
+		lazy(LazyAdd, A, n, CY, R);
+		A = R;
+		return;
 	}
 
-	for (uint8_t c = 0; c <= 7; c++)
-	{
-		InstructionSet16Bit[0b01'000'110 | (c << 3)] =
-		{
-			[]() {
-				return "BIT b,(HL) (Z <- ~(HL)b)";
-			},
-			[this]() {
-				uint8_t M = gb->read(HL);
-				Z = (~M >> b) & 0b1;
-				HC = 1;
-				N = 0;
-			},
-			3,
-			0,
-			c
-		};
-	}
-	
-	for (uint8_t c = 0; c <= 7; c++)
-	{
-		for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-		{
-			InstructionSet16Bit[0b11'000'000 | (c << 3) | i] =
-			{
-				[]() {
-					return "SET b,r (rb <- 1)";
-				},
-				[this]() {
-					uint8_t& r = GPR(a);
-
-					r |= (1 << b);
-				},
-				2,
-				i,
-				c
-			};
-		}
-	}
+	uint16_t tmp = A + n + CY;
 
-	for (uint8_t c = 0; c <= 7; c++)
-	{
-		InstructionSet16Bit[0b11'000'110 | (c << 3)] =
-		{
-			[]() {
-				return "SET b,(HL) ((HL)b <- 1)";
-			},
-			[this]() {
-				uint8_t M = gb->read(HL);
-				M |= (1 << b);
-				gb->write(HL, M);
-			},
-			4,
-			0,
-			c
-		};
-	}
+	HC = (((A & 0xF) + (n & 0xF) + CY) >> 4) != 0;
+	CY = (tmp >> 8) != 0;
+	A = tmp;
+	Z = A == 0;
+	N = 0;
+}
 
-	for (uint8_t c = 0; c <= 7; c++)
+inline void SM83::sub8(uint8_t n)
+{
+	if (LazyFlags)
 	{
-		for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-		{
-			InstructionSet16Bit[0b10'000'000 | (c << 3) | i] =
-			{
-				[]() {
-					return "RES b,r (rb <- 0)";
-				},
-				[this]() {
-					uint8_t& r = GPR(a);
-
-					r &= ~(1 << b);
-				},
-				2,
-				i,
-				c
-			};
-		}
+		lazy(LazySub, A, n, 0, A - n);
+		A -= n;
+		return;
 	}
 
-	for (uint8_t c = 0; c <= 7; c++)
-	{
-		InstructionSet16Bit[0b10'000'110 | (c << 3)] =
-		{
-			[]() {
-				return "RES b,(HL) ((HL)b <- 0)";
-			},
-			[this]() {
-				uint8_t M = gb->read(HL);
-				M &= ~(1 << b);
-				gb->write(HL, M);
-			},
-			4,
-			0,
-			c
-		};
-	}
+	HC = (A & 0xF) < (n & 0xF);
+	CY = A < n;
 
-	// Shift Instructions
+	A -= n;
+	Z = A == 0;
+	N = 1;
+}
 
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-	{
-		InstructionSet16Bit[0b00'000'000 | i] =
-		{
-			[]() {
-				return "RLC r";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				CY = r >> 7;
-				r <<= 1;
-				r |= CY;
-				HC = 0;
-				N = 0;
-				Z = r == 0;
-			},
-			2,
-			i
-		};
-	}
+inline void SM83::sbc8(uint8_t n)
+{
+	materializeFlags();
 
-	InstructionSet16Bit[0b00'000'110] =
+	if (LazyFlags)
 	{
-		[]() {
-			return "RLC (HL)";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-			CY = M >> 7;
-			M <<= 1;
-			M |= CY;
-			gb->write(HL, M);
-			N = 0;
-			HC = 0;
-			Z = M == 0;
-		},
-		4
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
-	{
-		InstructionSet16Bit[0b00'010'000 | i] =
-		{
-			[]() {
-				return "RL r";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				uint8_t tmp = r >> 7;
-				r <<= 1;
-				r |= CY;
-				CY = tmp;
-				HC = 0;
-				N = 0;
-				Z = r == 0;
-			},
-			2,
-			i
-		};
+		uint8_t R = A - n - CY;
+		lazy(LazySub, A, n, CY, R);
+		A = R;
+		return;
 	}
 
-	InstructionSet16Bit[0b00'010'110] =
-	{
-		[]() {
-			return "RL (HL)";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-			uint8_t tmp = M >> 7;
-			M <<= 1;
-			M |= CY;
-			gb->write(HL, M);
-			CY = tmp;
-			N = 0;
-			HC = 0;
-			Z = M == 0;
-		},
-		4
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
+	HC = (A & 0xF) < ((n & 0xF) + CY);
+	bool CY_tmp = A < (n + CY);
+
+	A -= (n + CY);
+	CY = CY_tmp;
+	Z = A == 0;
+	N = 1;
+}
+
+inline void SM83::and8(uint8_t n)
+{
+	if (LazyFlags)
 	{
-		InstructionSet16Bit[0b00'001'000 | i] =
-		{
-			[]() {
-				return "RRC r";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				CY = r & 0x01;
-				r >>= 1;
-				r |= CY << 7;
-				HC = 0;
-				N = 0;
-				Z = r == 0;
-			},
-			2,
-			i
-		};
+		A &= n;
+		lazy(LazyAnd, 0, 0, 0, A);
+		return;
 	}
 
-	InstructionSet16Bit[0b00'001'110] =
-	{
-		[]() {
-			return "RRC (HL)";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-			CY = M & 0x01;
-			M >>= 1;
-			M |= CY << 7;
-			gb->write(HL, M);
-			N = 0;
-			HC = 0;
-			Z = M == 0;
-		},
-		4
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
+	A &= n;
+	CY = 0;
+	HC = 1;
+	N = 0;
+	Z = A == 0;
+}
+
+inline void SM83::xor8(uint8_t n)
+{
+	if (LazyFlags)
 	{
-		InstructionSet16Bit[0b00'011'000 | i] =
-		{
-			[]() {
-				return "";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				uint8_t tmp = r & 0x01;
-				r >>= 1;
-				r |= CY << 7;
-				CY = tmp;
-				HC = 0;
-				N = 0;
-				Z = r == 0;
-			},
-			2,
-			i
-		};
+		A ^= n;
+		lazy(LazyOr, 0, 0, 0, A);
+		return;
 	}
 
-	InstructionSet16Bit[0b00'011'110] =
-	{
-		[]() {
-			return "RR (HL)";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-			uint8_t tmp = M & 0x01;
-			M >>= 1;
-			M |= CY << 7;
-			CY = tmp;
-			gb->write(HL, M);
-			N = 0;
-			HC = 0;
-			Z = M == 0;
-		},
-		4
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
+	A ^= n;
+	CY = 0;
+	HC = 0;
+	N = 0;
+	Z = A == 0;
+}
+
+inline void SM83::or8(uint8_t n)
+{
+	if (LazyFlags)
 	{
-		InstructionSet16Bit[0b00'100'000 | i] =
-		{
-			[]() {
-				return "SLA r";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				CY = r >> 7;
-				r <<= 1;
-				HC = 0;
-				N = 0;
-				Z = r == 0;
-			},
-			2,
-			i
-		};
+		A |= n;
+		lazy(LazyOr, 0, 0, 0, A);
+		return;
 	}
 
-	InstructionSet16Bit[0b00'100'110] =
-	{
-		[]() {
-			return "SLA (HL)";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-			CY = M >> 7;
-			M <<= 1;
-			HC = 0;
-			N = 0;
-			Z = M == 0;
-			gb->write(HL, M);
-		},
-		4
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
+	A |= n;
+	CY = 0;
+	HC = 0;
+	N = 0;
+	Z = A == 0;
+}
+
+inline void SM83::cp8(uint8_t n)
+{
+	if (LazyFlags)
 	{
-		InstructionSet16Bit[0b00'101'000 | i] =
-		{
-			[]() {
-				return "SRA r";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				uint8_t tmp = r & 0x80;
-				CY = r & 0x01;
-				r >>= 1;
-				r |= tmp;
-				HC = 0;
-				N = 0;
-				Z = r == 0;
-			},
-			2,
-			i
-		};
+		lazy(LazySub, A, n, 0, A - n);
+		return;
 	}
 
-	InstructionSet16Bit[0b00'101'110] =
-	{
-		[]() {
-			return "SRA (HL)";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-			uint8_t tmp = M & 0x80;
-			CY = M & 0x01;
-			M >>= 1;
-			M |= tmp;
-			HC = 0;
-			N = 0;
-			Z = M == 0;
-			gb->write(HL, M);
-		},
-		4
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
+	Z = A == n;
+	HC = (A & 0xF) < (n & 0xF);
+	N = 1;
+	CY = A < n;
+}
+
+inline uint8_t SM83::inc8(uint8_t n)
+{
+	// CY is left as it was
+	materializeFlags();
+
+	if (LazyFlags)
 	{
-		InstructionSet16Bit[0b00'111'000 | i] =
-		{
-			[]() {
-				return "SRL r";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				CY = r & 0x01;
-				r >>= 1;
-				HC = 0;
-				N = 0;
-				Z = r == 0;
-			},
-			2,
-			i
-		};
+		lazy(LazyInc, n, 0, 0, n + 1);
+		return n + 1;
 	}
 
-	InstructionSet16Bit[0b00'111'110] =
-	{
-		[]() {
-			return "SRL (HL)";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-			CY = M & 0x01;
-			M >>= 1;
-			HC = 0;
-			N = 0;
-			Z = M == 0;
-			gb->write(HL, M);
-		},
-		4
-	};
-
-	for (uint8_t i = 0; i <= 7; i + 1 == 0b110 ? i += 2 : i++)
+	HC = ((n & 0xF) + 1) >> 4;
+	N = 0;
+	n += 1;
+	Z = n == 0;
+	return n;
+}
+
+inline uint8_t SM83::dec8(uint8_t n)
+{
+	materializeFlags();
+
+	if (LazyFlags)
 	{
-		InstructionSet16Bit[0b00'110'000 | i] =
-		{
-			[]() {
-				return "SWAP r";
-			},
-			[this]() {
-				uint8_t& r = GPR(a);
-
-				uint8_t rH = r >> 4;
-				r = (r << 4) | rH;
-
-				Z = r == 0;
-				CY = 0;
-				HC = 0;
-				N = 0;
-			},
-			2,
-			i
-		};
+		lazy(LazyDec, n, 0, 0, n - 1);
+		return n - 1;
 	}
 
-	InstructionSet16Bit[0b00'110'110] =
-	{
-		[]() {
-			return "SWAP (HL)";
-		},
-		[this]() {
-			uint8_t M = gb->read(HL);
-			uint8_t MH = M >> 4;
-			M = (M << 4) | MH;
-			gb->write(HL, M);
-
-			Z = M == 0;
-			CY = 0;
-			HC = 0;
-			N = 0;
-		},
-		4
-	};
+	HC = (n & 0xF) < 1;
+	N = 1;
+	n -= 1;
+	Z = n == 0;
+	return n;
+}
 
-	// ========================================
+inline void SM83::addHL(uint16_t n)
+{
+	// Z is left as it was
+	materializeFlags();
 
+	HC = (((HL & 0xFFF) + (n & 0xFFF)) >> 12) != 0;
+	CY = (((uint32_t)HL + (uint32_t)n) >> 16) != 0;
+	HL += n;
+	N = 0;
+}
 
-	InstructionSet[0b11'000'011] =
-	{
-		[this]() {
-			uint8_t LO = gb->read(PC);
-			uint8_t HI = gb->read(PC + 1);
-			std::stringstream s;
-			s << "JP $" << std::hex << (int)((HI << 8) | LO) << std::dec << " (PC <- nn)";
-			return s.str();
-		},
-		[this]() {
-			uint8_t LO = gb->read(PC++);
-			uint8_t HI = gb->read(PC++);
-			PC = (HI << 8) | LO;
-		},
-		4
-	};
-
-	InstructionSet[0b11'000'010] =
-	{
-		[]() {
-			return "JP ~Z, nn (If ~Z: PC <- nn)";
-		},
-		[this]() {
-			if (Z == 0)
-			{
-				uint8_t LO = gb->read(PC++);
-				uint8_t HI = gb->read(PC++);
-				PC = (HI << 8) | LO;
-				cycle += 1;
-			}
-			else
-			{
-				PC += 2;
-			}
-		},
-		3
-	};
+inline uint16_t SM83::addSPe()
+{
+	// Shared by ADD SP,e and LD HL,SP+e
+	int16_t e = (int8_t)imm8();
 
-	InstructionSet[0b11'001'010] =
-	{
-		[]() {
-			return "JP Z, nn (If Z: PC <- nn)";
-		},
-		[this]() {
-			if (Z == 1)
-			{
-				uint8_t LO = gb->read(PC++);
-				uint8_t HI = gb->read(PC++);
-				PC = (HI << 8) | LO;
-				cycle += 1;
-			}
-			else
-			{
-				PC += 2;
-			}
-		},
-		3
-	};
+	// Every flag is overwritten
+	LazyOp = LazyNone;
 
-	InstructionSet[0b11'010'010] =
-	{
-		[]() {
-			return "JP ~CY, nn (If ~CY: PC <- nn)";
-		},
-		[this]() {
-			if (CY == 0)
-			{
-				uint8_t LO = gb->read(PC++);
-				uint8_t HI = gb->read(PC++);
-				PC = (HI << 8) | LO;
-				cycle += 1;
-			}
-			else
-			{
-				PC += 2;
-			}
-		},
-		3
-	};
+	HC = ((SP & 0xF) + (e & 0xF)) >> 4;
+	CY = ((SP & 0xFF) + (uint8_t)(e & 0xFF)) >> 8;
+	Z = 0;
+	N = 0;
 
-	InstructionSet[0b11'011'010] =
-	{
-		[]() {
-			return "JP CY, nn (If CY: PC <- nn)";
-		},
-		[this]() {
-			if (CY == 1)
-			{
-				uint8_t LO = gb->read(PC++);
-				uint8_t HI = gb->read(PC++);
-				PC = (HI << 8) | LO;
-				cycle += 1;
-			}
-			else
-			{
-				PC += 2;
-			}
-		},
-		3
-	};
+	return SP + e;
+}
 
-	InstructionSet[0b00'011'000] =
-	{
-		[]() {
-			return "JR e (PC <- PC+e)";
-		},
-		[this]() {
-			int8_t e = gb->read(PC++);
-			PC += e;
-		},
-		3
-	};
+inline uint8_t SM83::rlc(uint8_t n)
+{
+	LazyOp = LazyNone;
+
+	CY = n >> 7;
+	n <<= 1;
+	n |= CY;
+	HC = 0;
+	N = 0;
+	Z = n == 0;
+	return n;
+}
 
-	InstructionSet[0b00'100'000] =
-	{
-		[]() {
-			return "JR ~Z, e (If ~Z: PC <- PC+e)";
-		},
-		[this]() {
-			if (Z == 0)
-			{
-				int8_t e = gb->read(PC++);
-				PC += e;
-				cycle++;
-			}
-			else
-			{
-				PC++;
-			}
-		},
-		2
-	};
+inline uint8_t SM83::rl(uint8_t n)
+{
+	materializeFlags();
+
+	uint8_t tmp = n >> 7;
+	n <<= 1;
+	n |= CY;
+	CY = tmp;
+	HC = 0;
+	N = 0;
+	Z = n == 0;
+	return n;
+}
 
-	InstructionSet[0b00'101'000] =
-	{
-		[]() {
-			return "JR Z, e (If Z: PC <- PC+e)";
-		},
-		[this]() {
-			if (Z == 1)
-			{
-				int8_t e = gb->read(PC++);
-				PC += e;
-				cycle++;
-			}
-			else
-			{
-				PC++;
-			}
-		},
-		2
-	};
+inline uint8_t SM83::rrc(uint8_t n)
+{
+	LazyOp = LazyNone;
+
+	CY = n & 0x01;
+	n >>= 1;
+	n |= CY << 7;
+	HC = 0;
+	N = 0;
+	Z = n == 0;
+	return n;
+}
 
-	InstructionSet[0b00'110'000] =
-	{
-		[]() {
-			return "JR ~CY, e (If ~CY: PC <- PC+e)";
-		},
-		[this]() {
-			if (CY == 0)
-			{
-				int8_t e = gb->read(PC++);
-				PC += e;
-				cycle++;
-			}
-			else
-			{
-				PC++;
-			}
-		},
-		2
-	};
+inline uint8_t SM83::rr(uint8_t n)
+{
+	materializeFlags();
+
+	uint8_t tmp = n & 0x01;
+	n >>= 1;
+	n |= CY << 7;
+	CY = tmp;
+	HC = 0;
+	N = 0;
+	Z = n == 0;
+	return n;
+}
 
-	InstructionSet[0b00'111'000] =
-	{
-		[]() {
-			return "JR CY, e (If CY: PC <- PC+e)";
-		},
-		[this]() {
-			if (CY == 1)
-			{
-				int8_t e = gb->read(PC++);
-				PC += e;
-				cycle++;
-			}
-			else
-			{
-				PC++;
-			}
-		},
-		2
-	};
+inline uint8_t SM83::sla(uint8_t n)
+{
+	LazyOp = LazyNone;
+
+	CY = n >> 7;
+	n <<= 1;
+	HC = 0;
+	N = 0;
+	Z = n == 0;
+	return n;
+}
 
-	InstructionSet[0b11'101'001] =
-	{
-		[]() {
-			return "JP (HL) (PC <- HL)";
-		},
-		[this]() {
-			PC = HL;
-		},
-		1
-	};
-
-	InstructionSet[0b11'001'101] =
-	{
-		[]() {
-			return "CALL nn";
-		},
-		[this]() {
-			uint8_t LO = gb->read(PC++);
-			uint8_t HI = gb->read(PC++);
-
-			gb->write(--SP, PC >> 8);
-			gb->write(--SP, PC & 0x00FF);
-
-			PC = (HI << 8) | LO;
-		},
-		6
-	};
-
-	InstructionSet[0b11'000'100] =
-	{
-		[]() {
-			return "CALL cc, ~Z";
-		},
-		[this]() {
-			if (Z == 0)
-			{
-				uint8_t LO = gb->read(PC++);
-				uint8_t HI = gb->read(PC++);
+inline uint8_t SM83::sra(uint8_t n)
+{
+	LazyOp = LazyNone;
+
+	uint8_t tmp = n & 0x80;
+	CY = n & 0x01;
+	n >>= 1;
+	n |= tmp;
+	HC = 0;
+	N = 0;
+	Z = n == 0;
+	return n;
+}
 
-				gb->write(--SP, PC >> 8);
-				gb->write(--SP, PC & 0x00FF);
+inline uint8_t SM83::swap(uint8_t n)
+{
+	LazyOp = LazyNone;
+
+	n = (n << 4) | (n >> 4);
+	Z = n == 0;
+	CY = 0;
+	HC = 0;
+	N = 0;
+	return n;
+}
 
-				PC = (HI << 8) | LO;
+inline uint8_t SM83::srl(uint8_t n)
+{
+	LazyOp = LazyNone;
+
+	CY = n & 0x01;
+	n >>= 1;
+	HC = 0;
+	N = 0;
+	Z = n == 0;
+	return n;
+}
 
-				cycle += 3;
-			}
-			else
-			{
-				PC += 2;
-			}
-		},
-		3
-	};
+void SM83::execute(uint8_t opcode)
+{
+	// Instructions are grouped by the bit patterns used in
+	// the opcode tables, e.g. LD r, r' is 0b01'rrr'r'r'r'. 
+	// Register operands are decoded from the opcode with 
+	// GPR(), ss() and qq().
+	switch (opcode)
+	{
+	case 0b00'000'000:	// NOP
+		break;
+
+	// ================== 8-bit Transfer ==================
+
+	// LD r, r' (r <- r')
+	case 0x40: case 0x41: case 0x42: case 0x43: case 0x44: case 0x45: case 0x47:
+	case 0x48: case 0x49: case 0x4A: case 0x4B: case 0x4C: case 0x4D: case 0x4F:
+	case 0x50: case 0x51: case 0x52: case 0x53: case 0x54: case 0x55: case 0x57:
+	case 0x58: case 0x59: case 0x5A: case 0x5B: case 0x5C: case 0x5D: case 0x5F:
+	case 0x60: case 0x61: case 0x62: case 0x63: case 0x64: case 0x65: case 0x67:
+	case 0x68: case 0x69: case 0x6A: case 0x6B: case 0x6C: case 0x6D: case 0x6F:
+	case 0x78: case 0x79: case 0x7A: case 0x7B: case 0x7C: case 0x7D: case 0x7F:
+		GPR((opcode >> 3) & 0b111) = GPR(opcode & 0b111);
+		break;
+
+	// LD r, n (r <- n)
+	case 0x06: case 0x0E: case 0x16: case 0x1E: case 0x26: case 0x2E: case 0x3E:
+		GPR((opcode >> 3) & 0b111) = imm8();
+		break;
+
+	// LD r, (HL) (r <- (HL))
+	case 0x46: case 0x4E: case 0x56: case 0x5E: case 0x66: case 0x6E: case 0x7E:
+		GPR((opcode >> 3) & 0b111) = gb->read(HL);
+		break;
+
+	// LD (HL), r ((HL) <- r)
+	case 0x70: case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x77:
+		gb->write(HL, GPR(opcode & 0b111));
+		break;
+
+	case 0b00'110'110:	// LD (HL), n ((HL) <- n)
+		gb->write(HL, imm8());
+		break;
+
+	case 0b00'001'010:	// LD A, (BC) (A <- (BC))
+		A = gb->read(BC);
+		break;
+
+	case 0b00'011'010:	// LD A, (DE)  (A <- (DE))
+		A = gb->read(DE);
+		break;
+
+	case 0b11'110'010:	// LD A, (C) (A <- (0xFF00 + C))
+		A = gb->read(0xFF00 + C);
+		break;
+
+	case 0b11'100'010:	// LD (C), A ((0xFF00H+C) <- A)
+		gb->write(0xFF00 + C, A);
+		break;
+
+	case 0b11'110'000:	// LD A, (n) (A <- (0xFF00 + n))
+		A = gb->read(0xFF00 + imm8());
+		break;
+
+	case 0b11'100'000:	// LD (n), A ((0xFF00 + n) <- A)
+		gb->write(0xFF00 + imm8(), A);
+		break;
+
+	case 0b11'111'010:	// LD A, (nn) (A <- (nn))
+		A = gb->read(imm16());
+		break;
+
+	case 0b11'101'010:	// LD (nn), A ((nn) <- A)
+		gb->write(imm16(), A);
+		break;
+
+	case 0b00'101'010:	// LD A, (HLI) (A <- (HL), HL <- HL + 1)
+		A = gb->read(HL++);
+		break;
+
+	case 0b00'111'010:	// LD A, (HLD) (A <- (HL), HL <- HL - 1)
+		A = gb->read(HL--);
+		break;
+
+	case 0b00'000'010:	// LD (BC), A ((BC) <- A)
+		gb->write(BC, A);
+		break;
+
+	case 0b00'010'010:	// LD (DE), A ((DE) <- A)
+		gb->write(DE, A);
+		break;
+
+	case 0b00'100'010:	// LD (HLI), A ((HL) <- A, HL <- HL + 1)
+		gb->write(HL++, A);
+		break;
+
+	case 0b00'110'010:	// LD (HLD), A ((HL) <- A, HL <- HL - 1)
+		gb->write(HL--, A);
+		break;
+
+	// ================== 16-bit Transfer ==================
+
+	// LD dd, nn (dd <- nn)
+	case 0x01: case 0x11: case 0x21: case 0x31:
+		ss((opcode >> 4) & 0b11) = imm16();
+		break;
+
+	case 0b11'111'001:	// LD SP, HL (SP <- HL)
+		SP = HL;
+		break;
+
+	// PUSH qq ((SP-1) <- qqH, (SP-2) <- qqL, SP <- SP-2)
+	case 0xC5: case 0xD5: case 0xE5: case 0xF5:
+		materializeFlags();
+		push(qq((opcode >> 4) & 0b11));
+		break;
+
+	// POP qq (qqL <- (SP), qqH <- (SP+1), SP <- SP+2)
+	case 0xC1: case 0xD1: case 0xE1:
+		qq((opcode >> 4) & 0b11) = pop();
+		break;
+
+	case 0b11'110'001:	// POP AF
+		// Lower nibble of F is always zero
+		AF = pop() & 0xFFF0;
+		LazyOp = LazyNone;
+		break;
+
+	case 0b11'111'000:	// LD HL, SP+e (HL <- SP+e)
+		HL = addSPe();
+		break;
+
+	case 0b00'001'000:	// LD (nn), SP ((nn) <- SPL, (nn+1) <- SPH)
+	{
+		uint16_t nn = imm16();
+		gb->write(nn++, SP & 0x00FF);
+		gb->write(nn, SP >> 8);
+		break;
+	}
 
-	InstructionSet[0b11'001'100] =
+	// ================== 8-bit Arithmetic and Logic ==================
+
+	// ADD A, r (A <- A+r)
+	case 0x80: case 0x81: case 0x82: case 0x83: case 0x84: case 0x85: case 0x87:
+		add8(GPR(opcode & 0b111));
+		break;
+
+	case 0b11'000'110:	// ADD A, n (A <- A+n)
+		add8(imm8());
+		break;
+
+	case 0b10'000'110:	// ADD A, (HL) (A <- A+(HL))
+		add8(gb->read(HL));
+		break;
+
+	// ADC A, r (A <- A+r+CY)
+	case 0x88: case 0x89: case 0x8A: case 0x8B: case 0x8C: case 0x8D: case 0x8F:
+		adc8(GPR(opcode & 0b111));
+		break;
+
+	case 0b11'001'110:	// ADC A, n (A <- A+n+CY)
+		adc8(imm8());
+		break;
+
+	case 0b10'001'110:	// ADC A, (HL) (A <- A+(HL)+CY)
+		adc8(gb->read(HL));
+		break;
+
+	// SUB r (A <- A-r)
+	case 0x90: case 0x91: case 0x92: case 0x93: case 0x94: case 0x95: case 0x97:
+		sub8(GPR(opcode & 0b111));
+		break;
+
+	case 0b11'010'110:	// SUB n (A <- A-n)
+		sub8(imm8());
+		break;
+
+	case 0b10'010'110:	// SUB (HL) (A <- A-(HL))
+		sub8(gb->read(HL));
+		break;
+
+	// SBC A, r (A <- A-r-CY)
+	case 0x98: case 0x99: case 0x9A: case 0x9B: case 0x9C: case 0x9D: case 0x9F:
+		sbc8(GPR(opcode & 0b111));
+		break;
+
+	case 0b11'011'110:	// SBC A, n (A <- A-n-CY)
+		sbc8(imm8());
+		break;
+
+	case 0b10'011'110:	// SBC A, (HL) (A <- A-(HL)-CY)
+		sbc8(gb->read(HL));
+		break;
+
+	// AND r (A <- A & r)
+	case 0xA0: case 0xA1: case 0xA2: case 0xA3: case 0xA4: case 0xA5: case 0xA7:
+		and8(GPR(opcode & 0b111));
+		break;
+
+	case 0b11'100'110:	// AND n (A <- A & n)
+		and8(imm8());
+		break;
+
+	case 0b10'100'110:	// AND (HL) (A <- A & (HL))
+		and8(gb->read(HL));
+		break;
+
+	// XOR r (A <- A ^ r)
+	case 0xA8: case 0xA9: case 0xAA: case 0xAB: case 0xAC: case 0xAD: case 0xAF:
+		xor8(GPR(opcode & 0b111));
+		break;
+
+	case 0b11'101'110:	// XOR n (A <- A ^ n)
+		xor8(imm8());
+		break;
+
+	case 0b10'101'110:	// XOR (HL) (A <- A ^ (HL))
+		xor8(gb->read(HL));
+		break;
+
+	// OR r (A <- A | r)
+	case 0xB0: case 0xB1: case 0xB2: case 0xB3: case 0xB4: case 0xB5: case 0xB7:
+		or8(GPR(opcode & 0b111));
+		break;
+
+	case 0b11'110'110:	// OR n (A <- A | n)
+		or8(imm8());
+		break;
+
+	case 0b10'110'110:	// OR (HL) (A <- A | (HL))
+		or8(gb->read(HL));
+		break;
+
+	// CP r (A == r)
+	case 0xB8: case 0xB9: case 0xBA: case 0xBB: case 0xBC: case 0xBD: case 0xBF:
+		cp8(GPR(opcode & 0b111));
+		break;
+
+	case 0b11'111'110:	// CP n (A == n)
+		cp8(imm8());
+		break;
+
+	case 0b10'111'110:	// CP (HL) (A == (HL))
+		cp8(gb->read(HL));
+		break;
+
+	// INC r (r <- r+1)
+	case 0x04: case 0x0C: case 0x14: case 0x1C: case 0x24: case 0x2C: case 0x3C:
+	{
+		uint8_t& r = GPR((opcode >> 3) & 0b111);
+		r = inc8(r);
+		break;
+	}
+
+	case 0b00'110'100:	// INC (HL) ((HL) <- (HL)+1)
+		gb->write(HL, inc8(gb->read(HL)));
+		break;
+
+	// DEC r (r <- r-1)
+	case 0x05: case 0x0D: case 0x15: case 0x1D: case 0x25: case 0x2D: case 0x3D:
 	{
-		[]() {
-			return "CALL cc, Z";
-		},
-		[this]() {
-			if (Z == 1)
-			{
-				uint8_t LO = gb->read(PC++);
-				uint8_t HI = gb->read(PC++);
+		uint8_t& r = GPR((opcode >> 3) & 0b111);
+		r = dec8(r);
+		break;
+	}
 
-				gb->write(--SP, PC >> 8);
-				gb->write(--SP, PC & 0x00FF);
+	case 0b00'110'101:	// DEC (HL) ((HL) <- (HL)-1)
+		gb->write(HL, dec8(gb->read(HL)));
+		break;
 
-				PC = (HI << 8) | LO;
+	// ================== 16-bit Arithmetic ==================
 
-				cycle += 3;
-			}
-			else
-			{
-				PC += 2;
-			}
-		},
-		3
-	};
+	// ADD HL, ss (HL <- HL+ss)
+	case 0x09: case 0x19: case 0x29: case 0x39:
+		addHL(ss((opcode >> 4) & 0b11));
+		break;
 
-	InstructionSet[0b11'010'100] =
-	{
-		[]() {
-			return "CALL cc, ~CY";
-		},
-		[this]() {
-			if (CY == 0)
-			{
-				uint8_t LO = gb->read(PC++);
-				uint8_t HI = gb->read(PC++);
+	case 0b11'101'000:	// ADD SP, e (SP <- SP+e)
+		SP = addSPe();
+		break;
 
-				gb->write(--SP, PC >> 8);
-				gb->write(--SP, PC & 0x00FF);
+	// INC ss (ss <- ss+1)
+	case 0x03: case 0x13: case 0x23: case 0x33:
+		ss((opcode >> 4) & 0b11) += 1;
+		break;
 
-				PC = (HI << 8) | LO;
+	// DEC ss (ss <- ss-1)
+	case 0x0B: case 0x1B: case 0x2B: case 0x3B:
+		ss((opcode >> 4) & 0b11) -= 1;
+		break;
 
-				cycle += 3;
-			}
-			else
-			{
-				PC += 2;
-			}
-		},
-		3
-	};
+	// ================== Rotate ==================
 
-	InstructionSet[0b11'011'100] =
-	{
-		[]() {
-			return "CALL cc, CY";
-		},
-		[this]() {
-			if (CY == 1)
-			{
-				uint8_t LO = gb->read(PC++);
-				uint8_t HI = gb->read(PC++);
+	case 0b00'000'111:	// RLCA
+		A = rlc(A);
+		Z = 0;
+		break;
 
-				gb->write(--SP, PC >> 8);
-				gb->write(--SP, PC & 0x00FF);
+	case 0b00'010'111:	// RLA
+		A = rl(A);
+		Z = 0;
+		break;
 
-				PC = (HI << 8) | LO;
+	case 0b00'001'111:	// RRCA
+		A = rrc(A);
+		Z = 0;
+		break;
 
-				cycle += 3;
-			}
-			else
-			{
-				PC += 2;
-			}
-		},
-		3
-	};
+	case 0b00'011'111:	// RRA
+		A = rr(A);
+		Z = 0;
+		break;
 
-	InstructionSet[0b11'001'001] =
-	{
-		[]() {
-			return "RET";
-		},
-		[this]() {
-			uint8_t LO = gb->read(SP++);
-			uint8_t HI = gb->read(SP++);
-			PC = (HI << 8) | LO;
-		},
-		4
-	};
-
-	InstructionSet[0b11'011'001] =
-	{
-		[]() {
-			return "RETI";
-		},
-		[this]() {
-			uint8_t LO = gb->read(SP++);
-			uint8_t HI = gb->read(SP++);
-			PC = (HI << 8) | LO;
-			IME = 1;
-		},
-		4
-	};
-
-	InstructionSet[0b11'000'000] =
+	case 0b11'001'011:	// 0xCB prefixed instructions
 	{
-		[]() {
-			return "RET ~Z";
-		},
-		[this]() {
-			if (Z == 0)
-			{
-				uint8_t LO = gb->read(SP++);
-				uint8_t HI = gb->read(SP++);
-				PC = (HI << 8) | LO;
+		uint8_t data = imm8();
+		cycle += InstructionSet16Bit[data].cycles;
+		executeCB(data);
+		break;
+	}
 
-				cycle += 3;
-			}
-		},
-		2
-	};
+	// ================== Jumps ==================
 
-	InstructionSet[0b11'001'000] =
-	{
-		[]() {
-			return "RET Z";
-		},
-		[this]() {
-			if (Z == 1)
-			{
-				uint8_t LO = gb->read(SP++);
-				uint8_t HI = gb->read(SP++);
-				PC = (HI << 8) | LO;
+	case 0b11'000'011:	// JP nn (PC <- nn)
+		PC = imm16();
+		break;
 
-				cycle += 3;
-			}
-		},
-		2
-	};
+	// JP cc, nn (If cc: PC <- nn)
+	case 0xC2: case 0xCA: case 0xD2: case 0xDA:
+		if (condition(opcode))
+		{
+			PC = imm16();
+			cycle += 1;
+		}
+		else
+		{
+			imm16();	// Skip nn
+		}
+		break;
 
-	InstructionSet[0b11'010'000] =
+	case 0b00'011'000:	// JR e (PC <- PC+e)
 	{
-		[]() {
-			return "RET ~CY";
-		},
-		[this]() {
-			if (CY == 0)
-			{
-				uint8_t LO = gb->read(SP++);
-				uint8_t HI = gb->read(SP++);
-				PC = (HI << 8) | LO;
+		int8_t e = imm8();
+		PC += e;
+		break;
+	}
 
-				cycle += 3;
-			}
-		},
-		2
-	};
+	// JR cc, e (If cc: PC <- PC+e)
+	case 0x20: case 0x28: case 0x30: case 0x38:
+		if (condition(opcode))
+		{
+			int8_t e = imm8();
+			PC += e;
+			cycle++;
+		}
+		else
+		{
+			imm8();	// Skip e
+		}
+		break;
 
-	InstructionSet[0b11'011'000] =
-	{
-		[]() {
-			return "RET CY";
-		},
-		[this]() {
-			if (CY == 1)
-			{
-				uint8_t LO = gb->read(SP++);
-				uint8_t HI = gb->read(SP++);
-				PC = (HI << 8) | LO;
+	case 0b11'101'001:	// JP (HL) (PC <- HL)
+		PC = HL;
+		break;
 
-				cycle += 3;
-			}
-		},
-		2
-	};
+	// ================== Calls and Returns ==================
 
-	for (uint8_t t = 0; t <= 7; t++)
+	case 0b11'001'101:	// CALL nn
 	{
-		InstructionSet[0b11'000'111 | (t << 3)] =
-		{
-			[]() {
-				return "RST t";
-			},
-			[this]() {
-				gb->write(--SP, PC >> 8);
-				gb->write(--SP, PC & 0x00FF);
-				PC = a << 3;
-			},
-			4,
-			t
-		};
+		uint16_t nn = imm16();
+		push(PC);
+		PC = nn;
+		break;
 	}
 
-	InstructionSet[0b00'100'111] =
+	// CALL cc, nn
+	case 0xC4: case 0xCC: case 0xD4: case 0xDC:
+		if (condition(opcode))
+		{
+			uint16_t nn = imm16();
+			push(PC);
+			PC = nn;
+
+			cycle += 3;
+		}
+		else
+		{
+			imm16();	// Skip nn
+		}
+		break;
+
+	case 0b11'001'001:	// RET
+		PC = pop();
+		break;
+
+	case 0b11'011'001:	// RETI
+		PC = pop();
+		IME = 1;
+		break;
+
+	// RET cc
+	case 0xC0: case 0xC8: case 0xD0: case 0xD8:
+		if (condition(opcode))
+		{
+			PC = pop();
+
+			cycle += 3;
+		}
+		break;
+
+	// RST t
+	case 0xC7: case 0xCF: case 0xD7: case 0xDF: case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+		push(PC);
+		PC = opcode & 0b00'111'000;
+		break;
+
+	// ================== Miscellaneous ==================
+
+	case 0b00'100'111:	// DAA
 	{
-		[]() {
-			return "DAA";
-		},
-		[this]() {
+		materializeFlags();
 
-			uint8_t Offset = 0;
+		uint8_t Offset = 0;
 
-			if ((N == 0 && (A & 0xF) > 0x09) || HC == 1) 
-			{
-				Offset |= 0x06;
-			}
+		if ((N == 0 && (A & 0xF) > 0x09) || HC == 1)
+		{
+			Offset |= 0x06;
+		}
 
-			if ((N == 0 && A > 0x99) || CY == 1) 
-			{
-				Offset |= 0x60;
+		if ((N == 0 && A > 0x99) || CY == 1)
+		{
+			Offset |= 0x60;
 			CY = 1;
-			}
-			else
-			{
-				CY = 0;
-			}
+		}
+		else
+		{
+			CY = 0;
+		}
 
-			if (N == 0)
-			{
-				A += Offset;
-			}
-			else
-			{
-				A -= Offset;
-			}
+		if (N == 0)
+		{
+			A += Offset;
+		}
+		else
+		{
+			A -= Offset;
+		}
 
-			HC = 0;
-			Z = A == 0;
+		HC = 0;
+		Z = A == 0;
+		break;
+	}
 
-		},
-		1
-	};
+	case 0b00'101'111:	// CPL (A <- ~A)
+		materializeFlags();
+		A = ~A;
+		HC = 1;
+		N = 1;
+		break;
+
+	case 0b00'111'111:	// CCF (CY <- ~CY)
+		materializeFlags();
+		CY = !CY;
+		HC = 0;
+		N = 0;
+		break;
+
+	case 0b00'110'111:	// SCF (CY <- 1)
+		materializeFlags();
+		CY = 1;
+		HC = 0;
+		N = 0;
+		break;
+
+	case 0b11'110'011:	// DI (IME <- 0)
+		IME = 0;
+		break;
+
+	case 0b11'111'011:	// EI (IME <- 1)
+		// Takes effect after the next instruction
+		IMEDelaySet = 1;
+		break;
+
+	case 0b01'110'110:	// HALT
+		// IF has to be up to date when stepping
+		gb->sync();
+
+		Halted = true;
+		if ((gb->IE->reg & gb->IF->reg & 0x1F) != 0 && IME == 0)
+		{
+			PendingInterruptWhileHalted = true;
+		}
+		break;
 
-	InstructionSet[0b00'101'111] =
-	{
-		[]() {
-			return "CPL (A <- ~A)";
-		},
-		[this]() {
-			A = ~A;
-			HC = 1;
-			N = 1;
-		},
-		1
-	};
-
-	InstructionSet[0b00'111'111] =
-	{
-		[]() {
-			return "CCF (CY <- ~CY)";
-		},
-		[this]() {
-			CY = ~CY;
-			HC = 0;
-			N = 0;
-		},
-		1
-	};
-
-	InstructionSet[0b00'110'111] =
+	case 0b00'010'000:	// STOP
+		Stopped = true;
+		// TODO
+
+		gb->sync();
+		*gb->timer.DIV = 0;
+		break;
+
+	default:
+		// The remaining opcodes (0xD3, 0xDB, 0xDD, 0xE3, 0xE4, 0xEB, 
+		// 0xEC, 0xED, 0xF4, 0xFC and 0xFD) don't exist and lock up 
+		// the CPU. We emulate this by fetching the same opcode forever.
+		PC--;
+		cycle += 1;
+		break;
+	}
+}
+
+void SM83::executeCB(uint8_t opcode)
+{
+	// The lower 3 bits select the register with 0b110 
+	// selecting (HL) instead, bits 3-5 select the bit
+	// or shift operation.
+	uint8_t r = opcode & 0b111;
+	uint8_t b = (opcode >> 3) & 0b111;
+
+	uint8_t M = r == 0b110 ? gb->read(HL) : GPR(r);
+
+	switch (opcode >> 6)
 	{
-		[]() {
-			return "SCF (CY <- 1)";
-		},
-		[this]() {
-			CY = 1;
-			HC = 0;
-			N = 0;
-		},
-		1
-	};
+	case 0b00:	// Shift Instructions
+		switch (b)
+		{
+		case 0b000:
+			M = rlc(M);
+			break;
+		case 0b001:
+			M = rrc(M);
+			break;
+		case 0b010:
+			M = rl(M);
+			break;
+		case 0b011:
+			M = rr(M);
+			break;
+		case 0b100:
+			M = sla(M);
+			break;
+		case 0b101:
+			M = sra(M);
+			break;
+		case 0b110:
+			M = swap(M);
+			break;
+		case 0b111:
+			M = srl(M);
+			break;
+		}
+		break;
+
+	case 0b01:	// BIT b, r (Z <- ~rb)
+		materializeFlags();
+		Z = (~M >> b) & 0b1;
+		HC = 1;
+		N = 0;
+
+		// Nothing is written back
+		return;
+
+	case 0b10:	// RES b, r (rb <- 0)
+		M &= ~(1 << b);
+		break;
 
-	InstructionSet[0b11'110'011] =
+	case 0b11:	// SET b, r (rb <- 1)
+		M |= (1 << b);
+		break;
+	}
+
+	if (r == 0b110)
 	{
-		[]() {
-			return "DI (IME <- 0)";
-		},
-		[this]() {
-			IME = 0;
-		},
-		1
-	};
-
-	InstructionSet[0b11'111'011] =
+		gb->write(HL, M);
+	}
+	else
 	{
-		[]() {
-			return "EI (IME <- 1)";
-		},
-		[this]() {
-			//IME = 1;
-			IMEDelaySet = 1;
-		},
-		1
-	};
-
-	InstructionSet[0b01'110'110] =
+		GPR(r) = M;
+	}
+}
+
+// Opcode tables are shared by every SM83 and are constant initialized, 
+// nothing runs when an emulator is created. Operands which are only 
+// known at runtime are written as {fields} in the mnemonics and are 
+// filled in by disassemble().
+const SM83::Opcode SM83::InstructionSet[256] = {
+	{ "NOP ()", 1, 0, 0 },	// 00
+	{ "LD dd, nn (dd <- nn)", 3, 0, 0 },	// 01
+	{ "LD (BC), A ((BC) <- A)", 2, 0, 0 },	// 02
+	{ "INC ss (ss <- ss + 1)", 2, 0, 0 },	// 03
+	{ "INC r (r <- r+1)", 1, 0, 0 },	// 04
+	{ "DEC B = ${r} (r <- r-1)", 1, 0, 0 },	// 05
+	{ "LD B, [${PC}] = ${n} (r <- n)", 2, 0, 0 },	// 06
+	{ "RLCA", 1, 0, 0 },	// 07
+	{ "LD (nn), SP ((nn) <- SPL (nn + 1) <- SPH)", 5, 0, 0 },	// 08
+	{ "ADD HL,BC (HL <- HL+BC)", 2, 0, 0 },	// 09
+	{ "LD A, (BC) (A <- (BC))", 2, 0, 0 },	// 0A
+	{ "DEC ss (ss <- ss - 1)", 2, 0, 0 },	// 0B
+	{ "INC r (r <- r+1)", 1, 1, 0 },	// 0C
+	{ "DEC C = ${r} (r <- r-1)", 1, 1, 0 },	// 0D
+	{ "LD C, [${PC}] = ${n} (r <- n)", 2, 1, 0 },	// 0E
+	{ "RRCA", 1, 0, 0 },	// 0F
+	{ "STOP", 1, 0, 0 },	// 10
+	{ "LD dd, nn (dd <- nn)", 3, 1, 0 },	// 11
+	{ "LD (DE), A ((DE) <- A)", 2, 0, 0 },	// 12
+	{ "INC ss (ss <- ss + 1)", 2, 1, 0 },	// 13
+	{ "INC r (r <- r+1)", 1, 2, 0 },	// 14
+	{ "DEC D = ${r} (r <- r-1)", 1, 2, 0 },	// 15
+	{ "LD D, [${PC}] = ${n} (r <- n)", 2, 2, 0 },	// 16
+	{ "RLA", 1, 0, 0 },	// 17
+	{ "JR e (PC <- PC+e)", 3, 0, 0 },	// 18
+	{ "ADD HL,DE (HL <- HL+DE)", 2, 0, 0 },	// 19
+	{ "LD A, (DE)  (A <- (DE))", 2, 0, 0 },	// 1A
+	{ "DEC ss (ss <- ss - 1)", 2, 1, 0 },	// 1B
+	{ "INC r (r <- r+1)", 1, 3, 0 },	// 1C
+	{ "DEC E = ${r} (r <- r-1)", 1, 3, 0 },	// 1D
+	{ "LD E, [${PC}] = ${n} (r <- n)", 2, 3, 0 },	// 1E
+	{ "RRA", 1, 0, 0 },	// 1F
+	{ "JR ~Z, e (If ~Z: PC <- PC+e)", 2, 0, 0 },	// 20
+	{ "LD dd, nn (dd <- nn)", 3, 2, 0 },	// 21
+	{ "LD (HLI), A ((HL) <- A HL <- HL + 1)", 2, 0, 0 },	// 22
+	{ "INC ss (ss <- ss + 1)", 2, 2, 0 },	// 23
+	{ "INC r (r <- r+1)", 1, 4, 0 },	// 24
+	{ "DEC H = ${r} (r <- r-1)", 1, 4, 0 },	// 25
+	{ "LD H, [${PC}] = ${n} (r <- n)", 2, 4, 0 },	// 26
+	{ "DAA", 1, 0, 0 },	// 27
+	{ "JR Z, e (If Z: PC <- PC+e)", 2, 0, 0 },	// 28
+	{ "ADD HL,HL (HL <- HL+HL)", 2, 0, 0 },	// 29
+	{ "LD A, (HLI) (A <- (HL), HL <- HL + 1)", 2, 0, 0 },	// 2A
+	{ "DEC ss (ss <- ss - 1)", 2, 2, 0 },	// 2B
+	{ "INC r (r <- r+1)", 1, 5, 0 },	// 2C
+	{ "DEC L = ${r} (r <- r-1)", 1, 5, 0 },	// 2D
+	{ "LD L, [${PC}] = ${n} (r <- n)", 2, 5, 0 },	// 2E
+	{ "CPL (A <- ~A)", 1, 0, 0 },	// 2F
+	{ "JR ~CY, e (If ~CY: PC <- PC+e)", 2, 0, 0 },	// 30
+	{ "LD dd, nn (dd <- nn)", 3, 3, 0 },	// 31
+	{ "LD [HL-] = ${HL}, A = ${A} ((HL) <- A, HL <- HL-1)", 2, 0, 0 },	// 32
+	{ "INC ss (ss <- ss + 1)", 2, 3, 0 },	// 33
+	{ "INC (HL) ((HL) <- (HL)+1)", 3, 0, 0 },	// 34
+	{ "DEC (HL) ((HL) <- (HL)-1)", 3, 0, 0 },	// 35
+	{ "LD (HL), n ((HL) <- n)", 3, 0, 0 },	// 36
+	{ "SCF (CY <- 1)", 1, 0, 0 },	// 37
+	{ "JR CY, e (If CY: PC <- PC+e)", 2, 0, 0 },	// 38
+	{ "ADD HL,SP (HL <- HL+SP)", 2, 0, 0 },	// 39
+	{ "LD A, (HLD) (A <- (HL), HL <- HL1)", 2, 0, 0 },	// 3A
+	{ "DEC ss (ss <- ss - 1)", 2, 3, 0 },	// 3B
+	{ "INC r (r <- r+1)", 1, 7, 0 },	// 3C
+	{ "DEC A = ${r} (r <- r-1)", 1, 7, 0 },	// 3D
+	{ "LD A, [${PC}] = ${n} (r <- n)", 2, 7, 0 },	// 3E
+	{ "CCF (CY <- ~CY)", 1, 0, 0 },	// 3F
+	{ "LD B,B (r <-r')", 1, 0, 0 },	// 40
+	{ "LD B,C (r <-r')", 1, 0, 1 },	// 41
+	{ "LD B,D (r <-r')", 1, 0, 2 },	// 42
+	{ "LD B,E (r <-r')", 1, 0, 3 },	// 43
+	{ "LD B,H (r <-r')", 1, 0, 4 },	// 44
+	{ "LD B,L (r <-r')", 1, 0, 5 },	// 45
+	{ "LD r, (HL) (r <- (HL))", 2, 0, 0 },	// 46
+	{ "LD B,A (r <-r')", 1, 0, 7 },	// 47
+	{ "LD C,B (r <-r')", 1, 1, 0 },	// 48
+	{ "LD C,C (r <-r')", 1, 1, 1 },	// 49
+	{ "LD C,D (r <-r')", 1, 1, 2 },	// 4A
+	{ "LD C,E (r <-r')", 1, 1, 3 },	// 4B
+	{ "LD C,H (r <-r')", 1, 1, 4 },	// 4C
+	{ "LD C,L (r <-r')", 1, 1, 5 },	// 4D
+	{ "LD r, (HL) (r <- (HL))", 2, 1, 0 },	// 4E
+	{ "LD C,A (r <-r')", 1, 1, 7 },	// 4F
+	{ "LD D,B (r <-r')", 1, 2, 0 },	// 50
+	{ "LD D,C (r <-r')", 1, 2, 1 },	// 51
+	{ "LD D,D (r <-r')", 1, 2, 2 },	// 52
+	{ "LD D,E (r <-r')", 1, 2, 3 },	// 53
+	{ "LD D,H (r <-r')", 1, 2, 4 },	// 54
+	{ "LD D,L (r <-r')", 1, 2, 5 },	// 55
+	{ "LD r, (HL) (r <- (HL))", 2, 2, 0 },	// 56
+	{ "LD D,A (r <-r')", 1, 2, 7 },	// 57
+	{ "LD E,B (r <-r')", 1, 3, 0 },	// 58
+	{ "LD E,C (r <-r')", 1, 3, 1 },	// 59
+	{ "LD E,D (r <-r')", 1, 3, 2 },	// 5A
+	{ "LD E,E (r <-r')", 1, 3, 3 },	// 5B
+	{ "LD E,H (r <-r')", 1, 3, 4 },	// 5C
+	{ "LD E,L (r <-r')", 1, 3, 5 },	// 5D
+	{ "LD r, (HL) (r <- (HL))", 2, 3, 0 },	// 5E
+	{ "LD E,A (r <-r')", 1, 3, 7 },	// 5F
+	{ "LD H,B (r <-r')", 1, 4, 0 },	// 60
+	{ "LD H,C (r <-r')", 1, 4, 1 },	// 61
+	{ "LD H,D (r <-r')", 1, 4, 2 },	// 62
+	{ "LD H,E (r <-r')", 1, 4, 3 },	// 63
+	{ "LD H,H (r <-r')", 1, 4, 4 },	// 64
+	{ "LD H,L (r <-r')", 1, 4, 5 },	// 65
+	{ "LD r, (HL) (r <- (HL))", 2, 4, 0 },	// 66
+	{ "LD H,A (r <-r')", 1, 4, 7 },	// 67
+	{ "LD L,B (r <-r')", 1, 5, 0 },	// 68
+	{ "LD L,C (r <-r')", 1, 5, 1 },	// 69
+	{ "LD L,D (r <-r')", 1, 5, 2 },	// 6A
+	{ "LD L,E (r <-r')", 1, 5, 3 },	// 6B
+	{ "LD L,H (r <-r')", 1, 5, 4 },	// 6C
+	{ "LD L,L (r <-r')", 1, 5, 5 },	// 6D
+	{ "LD r, (HL) (r <- (HL))", 2, 5, 0 },	// 6E
+	{ "LD L,A (r <-r')", 1, 5, 7 },	// 6F
+	{ "LD (HL),r ((HL) <- r)", 2, 0, 0 },	// 70
+	{ "LD (HL),r ((HL) <- r)", 2, 1, 0 },	// 71
+	{ "LD (HL),r ((HL) <- r)", 2, 2, 0 },	// 72
+	{ "LD (HL),r ((HL) <- r)", 2, 3, 0 },	// 73
+	{ "LD (HL),r ((HL) <- r)", 2, 4, 0 },	// 74
+	{ "LD (HL),r ((HL) <- r)", 2, 5, 0 },	// 75
+	{ "HALT", 1, 0, 0 },	// 76
+	{ "LD (HL),r ((HL) <- r)", 2, 7, 0 },	// 77
+	{ "LD A,B (r <-r')", 1, 7, 0 },	// 78
+	{ "LD A,C (r <-r')", 1, 7, 1 },	// 79
+	{ "LD A,D (r <-r')", 1, 7, 2 },	// 7A
+	{ "LD A,E (r <-r')", 1, 7, 3 },	// 7B
+	{ "LD A,H (r <-r')", 1, 7, 4 },	// 7C
+	{ "LD A,L (r <-r')", 1, 7, 5 },	// 7D
+	{ "LD r, (HL) (r <- (HL))", 2, 7, 0 },	// 7E
+	{ "LD A,A (r <-r')", 1, 7, 7 },	// 7F
+	{ "A, r (A <- A + r)", 1, 0, 0 },	// 80
+	{ "A, r (A <- A + r)", 1, 1, 0 },	// 81
+	{ "A, r (A <- A + r)", 1, 2, 0 },	// 82
+	{ "A, r (A <- A + r)", 1, 3, 0 },	// 83
+	{ "A, r (A <- A + r)", 1, 4, 0 },	// 84
+	{ "A, r (A <- A + r)", 1, 5, 0 },	// 85
+	{ "ADD A, (HL) (A <- A+(HL))", 2, 0, 0 },	// 86
+	{ "A, r (A <- A + r)", 1, 7, 0 },	// 87
+	{ "ADC A, r (A <- A+s+CY)", 1, 0, 0 },	// 88
+	{ "ADC A, r (A <- A+s+CY)", 1, 1, 0 },	// 89
+	{ "ADC A, r (A <- A+s+CY)", 1, 2, 0 },	// 8A
+	{ "ADC A, r (A <- A+s+CY)", 1, 3, 0 },	// 8B
+	{ "ADC A, r (A <- A+s+CY)", 1, 4, 0 },	// 8C
+	{ "ADC A, r (A <- A+s+CY)", 1, 5, 0 },	// 8D
+	{ " ADC A, (HL) (A <- A+n+CY)", 2, 0, 0 },	// 8E
+	{ "ADC A, r (A <- A+s+CY)", 1, 7, 0 },	// 8F
+	{ "SUB r (A <- A-r)", 1, 0, 0 },	// 90
+	{ "SUB r (A <- A-r)", 1, 1, 0 },	// 91
+	{ "SUB r (A <- A-r)", 1, 2, 0 },	// 92
+	{ "SUB r (A <- A-r)", 1, 3, 0 },	// 93
+	{ "SUB r (A <- A-r)", 1, 4, 0 },	// 94
+	{ "SUB r (A <- A-r)", 1, 5, 0 },	// 95
+	{ "SUB (HL) ( A <- A-(HL))", 2, 0, 0 },	// 96
+	{ "SUB r (A <- A-r)", 1, 7, 0 },	// 97
+	{ "SBC A, r (A <- A-r-CY)", 1, 0, 0 },	// 98
+	{ "SBC A, r (A <- A-r-CY)", 1, 1, 0 },	// 99
+	{ "SBC A, r (A <- A-r-CY)", 1, 2, 0 },	// 9A
+	{ "SBC A, r (A <- A-r-CY)", 1, 3, 0 },	// 9B
+	{ "SBC A, r (A <- A-r-CY)", 1, 4, 0 },	// 9C
+	{ "SBC A, r (A <- A-r-CY)", 1, 5, 0 },	// 9D
+	{ "SBC A, (HL) (A <- A - (HL) - CY)", 2, 0, 0 },	// 9E
+	{ "SBC A, r (A <- A-r-CY)", 1, 7, 0 },	// 9F
+	{ "AND r (A & r)", 1, 0, 0 },	// A0
+	{ "AND r (A & r)", 1, 1, 0 },	// A1
+	{ "AND r (A & r)", 1, 2, 0 },	// A2
+	{ "AND r (A & r)", 1, 3, 0 },	// A3
+	{ "AND r (A & r)", 1, 4, 0 },	// A4
+	{ "AND r (A & r)", 1, 5, 0 },	// A5
+	{ "AND (HL) (A & (HL))", 2, 0, 0 },	// A6
+	{ "AND r (A & r)", 1, 7, 0 },	// A7
+	{ "XOR r (A ^ r)", 1, 0, 0 },	// A8
+	{ "XOR r (A ^ r)", 1, 1, 0 },	// A9
+	{ "XOR r (A ^ r)", 1, 2, 0 },	// AA
+	{ "XOR r (A ^ r)", 1, 3, 0 },	// AB
+	{ "XOR r (A ^ r)", 1, 4, 0 },	// AC
+	{ "XOR r (A ^ r)", 1, 5, 0 },	// AD
+	{ "XOR (HL) (A ^ (HL))", 2, 0, 0 },	// AE
+	{ "XOR r (A ^ r)", 1, 7, 0 },	// AF
+	{ "OR r (A | r)", 1, 0, 0 },	// B0
+	{ "OR r (A | r)", 1, 1, 0 },	// B1
+	{ "OR r (A | r)", 1, 2, 0 },	// B2
+	{ "OR r (A | r)", 1, 3, 0 },	// B3
+	{ "OR r (A | r)", 1, 4, 0 },	// B4
+	{ "OR r (A | r)", 1, 5, 0 },	// B5
+	{ "OR (HL) (A | (HL))", 2, 0, 0 },	// B6
+	{ "OR r (A | r)", 1, 7, 0 },	// B7
+	{ "CP r (A == r)", 1, 0, 0 },	// B8
+	{ "CP r (A == r)", 1, 1, 0 },	// B9
+	{ "CP r (A == r)", 1, 2, 0 },	// BA
+	{ "CP r (A == r)", 1, 3, 0 },	// BB
+	{ "CP r (A == r)", 1, 4, 0 },	// BC
+	{ "CP r (A == r)", 1, 5, 0 },	// BD
+	{ "CP (HL) (A == (HL))", 2, 0, 0 },	// BE
+	{ "CP r (A == r)", 1, 7, 0 },	// BF
+	{ "RET ~Z", 2, 0, 0 },	// C0
+	{ "POP BC (qqL <- (SP) qqH <- (SP + 1) SP <- SP + 2)", 3, 0, 0 },	// C1
+	{ "JP ~Z, nn (If ~Z: PC <- nn)", 3, 0, 0 },	// C2
+	{ "JP ${nn} (PC <- nn)", 4, 0, 0 },	// C3
+	{ "CALL cc, ~Z", 3, 0, 0 },	// C4
+	{ "PUSH BC ((SP-1) <- qqH (SP - 2) <- qqL SP <- SP - 2)", 4, 0, 0 },	// C5
+	{ "ADD A,n (A <- A+n)", 2, 0, 0 },	// C6
+	{ "RST t", 4, 0, 0 },	// C7
+	{ "RET Z", 2, 0, 0 },	// C8
+	{ "RET", 4, 0, 0 },	// C9
+	{ "JP Z, nn (If Z: PC <- nn)", 3, 0, 0 },	// CA
+	{ "", 0, 0, 0 },	// CB
+	{ "CALL cc, Z", 3, 0, 0 },	// CC
+	{ "CALL nn", 6, 0, 0 },	// CD
+	{ " ADC A, n (A <- A+n+CY)", 2, 0, 0 },	// CE
+	{ "RST t", 4, 1, 0 },	// CF
+	{ "RET ~CY", 2, 0, 0 },	// D0
+	{ "POP DE (qqL <- (SP) qqH <- (SP + 1) SP <- SP + 2)", 3, 1, 0 },	// D1
+	{ "JP ~CY, nn (If ~CY: PC <- nn)", 3, 0, 0 },	// D2
+	{ nullptr, 0, 0, 0 },	// D3
+	{ "CALL cc, ~CY", 3, 0, 0 },	// D4
+	{ "PUSH DE ((SP-1) <- qqH (SP - 2) <- qqL SP <- SP - 2)", 4, 1, 0 },	// D5
+	{ "SUB n ( A <- A-n)", 2, 0, 0 },	// D6
+	{ "RST t", 4, 2, 0 },	// D7
+	{ "RET CY", 2, 0, 0 },	// D8
+	{ "RETI", 4, 0, 0 },	// D9
+	{ "JP CY, nn (If CY: PC <- nn)", 3, 0, 0 },	// DA
+	{ nullptr, 0, 0, 0 },	// DB
+	{ "CALL cc, CY", 3, 0, 0 },	// DC
+	{ nullptr, 0, 0, 0 },	// DD
+	{ "SBC A, n (A <- A - n - CY)", 2, 0, 0 },	// DE
+	{ "RST t", 4, 3, 0 },	// DF
+	{ "LD (0x{FFn}), A ((n) <- A)", 3, 0, 0 },	// E0
+	{ "POP HL (qqL <- (SP) qqH <- (SP + 1) SP <- SP + 2)", 3, 2, 0 },	// E1
+	{ "LD (C), A ((0xFF00H+C) <- A)", 2, 0, 0 },	// E2
+	{ nullptr, 0, 0, 0 },	// E3
+	{ nullptr, 0, 0, 0 },	// E4
+	{ "PUSH HL ((SP-1) <- qqH (SP - 2) <- qqL SP <- SP - 2)", 4, 2, 0 },	// E5
+	{ "AND n (A & n)", 2, 0, 0 },	// E6
+	{ "RST t", 4, 4, 0 },	// E7
+	{ "ADD SP,e (SP <- SP+e)", 4, 0, 0 },	// E8
+	{ "JP (HL) (PC <- HL)", 1, 0, 0 },	// E9
+	{ "LD (nn), A ((nn) <- A)", 4, 0, 0 },	// EA
+	{ nullptr, 0, 0, 0 },	// EB
+	{ nullptr, 0, 0, 0 },	// EC
+	{ nullptr, 0, 0, 0 },	// ED
+	{ "XOR n (A ^ n)", 2, 0, 0 },	// EE
+	{ "RST t", 4, 5, 0 },	// EF
+	{ "LD A, [${FFn}] = ${(FFn)} (A <-(n))", 3, 0, 0 },	// F0
+	{ "POP AF (qqL <- (SP) qqH <- (SP + 1) SP <- SP + 2)", 3, 3, 0 },	// F1
+	{ "LD A, (C) (A <- (0xFF00 + C))", 2, 0, 0 },	// F2
+	{ "DI (IME <- 0)", 1, 0, 0 },	// F3
+	{ nullptr, 0, 0, 0 },	// F4
+	{ "PUSH AF ((SP-1) <- qqH (SP - 2) <- qqL SP <- SP - 2)", 4, 3, 0 },	// F5
+	{ "OR n (A | n)", 2, 0, 0 },	// F6
+	{ "RST t", 4, 6, 0 },	// F7
+	{ "LD, HL, SP, e (HL <- SP+e)", 3, 0, 0 },	// F8
+	{ "LD SP, HL (SP <- HL)", 2, 0, 0 },	// F9
+	{ "LD A, (nn)(A <- (nn))", 4, 0, 0 },	// FA
+	{ "EI (IME <- 1)", 1, 0, 0 },	// FB
+	{ nullptr, 0, 0, 0 },	// FC
+	{ nullptr, 0, 0, 0 },	// FD
+	{ "CP ${n} (A == n)", 2, 0, 0 },	// FE
+	{ "RST t", 4, 7, 0 },	// FF
+};
+
+const SM83::Opcode SM83::InstructionSet16Bit[256] = {
+	{ "RLC r", 2, 0, 0 },	// CB 00
+	{ "RLC r", 2, 1, 0 },	// CB 01
+	{ "RLC r", 2, 2, 0 },	// CB 02
+	{ "RLC r", 2, 3, 0 },	// CB 03
+	{ "RLC r", 2, 4, 0 },	// CB 04
+	{ "RLC r", 2, 5, 0 },	// CB 05
+	{ "RLC (HL)", 4, 0, 0 },	// CB 06
+	{ "RLC r", 2, 7, 0 },	// CB 07
+	{ "RRC r", 2, 0, 0 },	// CB 08
+	{ "RRC r", 2, 1, 0 },	// CB 09
+	{ "RRC r", 2, 2, 0 },	// CB 0A
+	{ "RRC r", 2, 3, 0 },	// CB 0B
+	{ "RRC r", 2, 4, 0 },	// CB 0C
+	{ "RRC r", 2, 5, 0 },	// CB 0D
+	{ "RRC (HL)", 4, 0, 0 },	// CB 0E
+	{ "RRC r", 2, 7, 0 },	// CB 0F
+	{ "RL r", 2, 0, 0 },	// CB 10
+	{ "RL r", 2, 1, 0 },	// CB 11
+	{ "RL r", 2, 2, 0 },	// CB 12
+	{ "RL r", 2, 3, 0 },	// CB 13
+	{ "RL r", 2, 4, 0 },	// CB 14
+	{ "RL r", 2, 5, 0 },	// CB 15
+	{ "RL (HL)", 4, 0, 0 },	// CB 16
+	{ "RL r", 2, 7, 0 },	// CB 17
+	{ "", 2, 0, 0 },	// CB 18
+	{ "", 2, 1, 0 },	// CB 19
+	{ "", 2, 2, 0 },	// CB 1A
+	{ "", 2, 3, 0 },	// CB 1B
+	{ "", 2, 4, 0 },	// CB 1C
+	{ "", 2, 5, 0 },	// CB 1D
+	{ "RR (HL)", 4, 0, 0 },	// CB 1E
+	{ "", 2, 7, 0 },	// CB 1F
+	{ "SLA r", 2, 0, 0 },	// CB 20
+	{ "SLA r", 2, 1, 0 },	// CB 21
+	{ "SLA r", 2, 2, 0 },	// CB 22
+	{ "SLA r", 2, 3, 0 },	// CB 23
+	{ "SLA r", 2, 4, 0 },	// CB 24
+	{ "SLA r", 2, 5, 0 },	// CB 25
+	{ "SLA (HL)", 4, 0, 0 },	// CB 26
+	{ "SLA r", 2, 7, 0 },	// CB 27
+	{ "SRA r", 2, 0, 0 },	// CB 28
+	{ "SRA r", 2, 1, 0 },	// CB 29
+	{ "SRA r", 2, 2, 0 },	// CB 2A
+	{ "SRA r", 2, 3, 0 },	// CB 2B
+	{ "SRA r", 2, 4, 0 },	// CB 2C
+	{ "SRA r", 2, 5, 0 },	// CB 2D
+	{ "SRA (HL)", 4, 0, 0 },	// CB 2E
+	{ "SRA r", 2, 7, 0 },	// CB 2F
+	{ "SWAP r", 2, 0, 0 },	// CB 30
+	{ "SWAP r", 2, 1, 0 },	// CB 31
+	{ "SWAP r", 2, 2, 0 },	// CB 32
+	{ "SWAP r", 2, 3, 0 },	// CB 33
+	{ "SWAP r", 2, 4, 0 },	// CB 34
+	{ "SWAP r", 2, 5, 0 },	// CB 35
+	{ "SWAP (HL)", 4, 0, 0 },	// CB 36
+	{ "SWAP r", 2, 7, 0 },	// CB 37
+	{ "SRL r", 2, 0, 0 },	// CB 38
+	{ "SRL r", 2, 1, 0 },	// CB 39
+	{ "SRL r", 2, 2, 0 },	// CB 3A
+	{ "SRL r", 2, 3, 0 },	// CB 3B
+	{ "SRL r", 2, 4, 0 },	// CB 3C
+	{ "SRL r", 2, 5, 0 },	// CB 3D
+	{ "SRL (HL)", 4, 0, 0 },	// CB 3E
+	{ "SRL r", 2, 7, 0 },	// CB 3F
+	{ "BIT b, r (Z <- ~rb)", 2, 0, 0 },	// CB 40
+	{ "BIT b, r (Z <- ~rb)", 2, 1, 0 },	// CB 41
+	{ "BIT b, r (Z <- ~rb)", 2, 2, 0 },	// CB 42
+	{ "BIT b, r (Z <- ~rb)", 2, 3, 0 },	// CB 43
+	{ "BIT b, r (Z <- ~rb)", 2, 4, 0 },	// CB 44
+	{ "BIT b, r (Z <- ~rb)", 2, 5, 0 },	// CB 45
+	{ "BIT b,(HL) (Z <- ~(HL)b)", 3, 0, 0 },	// CB 46
+	{ "BIT b, r (Z <- ~rb)", 2, 7, 0 },	// CB 47
+	{ "BIT b, r (Z <- ~rb)", 2, 0, 1 },	// CB 48
+	{ "BIT b, r (Z <- ~rb)", 2, 1, 1 },	// CB 49
+	{ "BIT b, r (Z <- ~rb)", 2, 2, 1 },	// CB 4A
+	{ "BIT b, r (Z <- ~rb)", 2, 3, 1 },	// CB 4B
+	{ "BIT b, r (Z <- ~rb)", 2, 4, 1 },	// CB 4C
+	{ "BIT b, r (Z <- ~rb)", 2, 5, 1 },	// CB 4D
+	{ "BIT b,(HL) (Z <- ~(HL)b)", 3, 0, 1 },	// CB 4E
+	{ "BIT b, r (Z <- ~rb)", 2, 7, 1 },	// CB 4F
+	{ "BIT b, r (Z <- ~rb)", 2, 0, 2 },	// CB 50
+	{ "BIT b, r (Z <- ~rb)", 2, 1, 2 },	// CB 51
+	{ "BIT b, r (Z <- ~rb)", 2, 2, 2 },	// CB 52
+	{ "BIT b, r (Z <- ~rb)", 2, 3, 2 },	// CB 53
+	{ "BIT b, r (Z <- ~rb)", 2, 4, 2 },	// CB 54
+	{ "BIT b, r (Z <- ~rb)", 2, 5, 2 },	// CB 55
+	{ "BIT b,(HL) (Z <- ~(HL)b)", 3, 0, 2 },	// CB 56
+	{ "BIT b, r (Z <- ~rb)", 2, 7, 2 },	// CB 57
+	{ "BIT b, r (Z <- ~rb)", 2, 0, 3 },	// CB 58
+	{ "BIT b, r (Z <- ~rb)", 2, 1, 3 },	// CB 59
+	{ "BIT b, r (Z <- ~rb)", 2, 2, 3 },	// CB 5A
+	{ "BIT b, r (Z <- ~rb)", 2, 3, 3 },	// CB 5B
+	{ "BIT b, r (Z <- ~rb)", 2, 4, 3 },	// CB 5C
+	{ "BIT b, r (Z <- ~rb)", 2, 5, 3 },	// CB 5D
+	{ "BIT b,(HL) (Z <- ~(HL)b)", 3, 0, 3 },	// CB 5E
+	{ "BIT b, r (Z <- ~rb)", 2, 7, 3 },	// CB 5F
+	{ "BIT b, r (Z <- ~rb)", 2, 0, 4 },	// CB 60
+	{ "BIT b, r (Z <- ~rb)", 2, 1, 4 },	// CB 61
+	{ "BIT b, r (Z <- ~rb)", 2, 2, 4 },	// CB 62
+	{ "BIT b, r (Z <- ~rb)", 2, 3, 4 },	// CB 63
+	{ "BIT b, r (Z <- ~rb)", 2, 4, 4 },	// CB 64
+	{ "BIT b, r (Z <- ~rb)", 2, 5, 4 },	// CB 65
+	{ "BIT b,(HL) (Z <- ~(HL)b)", 3, 0, 4 },	// CB 66
+	{ "BIT b, r (Z <- ~rb)", 2, 7, 4 },	// CB 67
+	{ "BIT b, r (Z <- ~rb)", 2, 0, 5 },	// CB 68
+	{ "BIT b, r (Z <- ~rb)", 2, 1, 5 },	// CB 69
+	{ "BIT b, r (Z <- ~rb)", 2, 2, 5 },	// CB 6A
+	{ "BIT b, r (Z <- ~rb)", 2, 3, 5 },	// CB 6B
+	{ "BIT b, r (Z <- ~rb)", 2, 4, 5 },	// CB 6C
+	{ "BIT b, r (Z <- ~rb)", 2, 5, 5 },	// CB 6D
+	{ "BIT b,(HL) (Z <- ~(HL)b)", 3, 0, 5 },	// CB 6E
+	{ "BIT b, r (Z <- ~rb)", 2, 7, 5 },	// CB 6F
+	{ "BIT b, r (Z <- ~rb)", 2, 0, 6 },	// CB 70
+	{ "BIT b, r (Z <- ~rb)", 2, 1, 6 },	// CB 71
+	{ "BIT b, r (Z <- ~rb)", 2, 2, 6 },	// CB 72
+	{ "BIT b, r (Z <- ~rb)", 2, 3, 6 },	// CB 73
+	{ "BIT b, r (Z <- ~rb)", 2, 4, 6 },	// CB 74
+	{ "BIT b, r (Z <- ~rb)", 2, 5, 6 },	// CB 75
+	{ "BIT b,(HL) (Z <- ~(HL)b)", 3, 0, 6 },	// CB 76
+	{ "BIT b, r (Z <- ~rb)", 2, 7, 6 },	// CB 77
+	{ "BIT b, r (Z <- ~rb)", 2, 0, 7 },	// CB 78
+	{ "BIT b, r (Z <- ~rb)", 2, 1, 7 },	// CB 79
+	{ "BIT b, r (Z <- ~rb)", 2, 2, 7 },	// CB 7A
+	{ "BIT b, r (Z <- ~rb)", 2, 3, 7 },	// CB 7B
+	{ "BIT b, r (Z <- ~rb)", 2, 4, 7 },	// CB 7C
+	{ "BIT b, r (Z <- ~rb)", 2, 5, 7 },	// CB 7D
+	{ "BIT b,(HL) (Z <- ~(HL)b)", 3, 0, 7 },	// CB 7E
+	{ "BIT b, r (Z <- ~rb)", 2, 7, 7 },	// CB 7F
+	{ "RES b,r (rb <- 0)", 2, 0, 0 },	// CB 80
+	{ "RES b,r (rb <- 0)", 2, 1, 0 },	// CB 81
+	{ "RES b,r (rb <- 0)", 2, 2, 0 },	// CB 82
+	{ "RES b,r (rb <- 0)", 2, 3, 0 },	// CB 83
+	{ "RES b,r (rb <- 0)", 2, 4, 0 },	// CB 84
+	{ "RES b,r (rb <- 0)", 2, 5, 0 },	// CB 85
+	{ "RES b,(HL) ((HL)b <- 0)", 4, 0, 0 },	// CB 86
+	{ "RES b,r (rb <- 0)", 2, 7, 0 },	// CB 87
+	{ "RES b,r (rb <- 0)", 2, 0, 1 },	// CB 88
+	{ "RES b,r (rb <- 0)", 2, 1, 1 },	// CB 89
+	{ "RES b,r (rb <- 0)", 2, 2, 1 },	// CB 8A
+	{ "RES b,r (rb <- 0)", 2, 3, 1 },	// CB 8B
+	{ "RES b,r (rb <- 0)", 2, 4, 1 },	// CB 8C
+	{ "RES b,r (rb <- 0)", 2, 5, 1 },	// CB 8D
+	{ "RES b,(HL) ((HL)b <- 0)", 4, 0, 1 },	// CB 8E
+	{ "RES b,r (rb <- 0)", 2, 7, 1 },	// CB 8F
+	{ "RES b,r (rb <- 0)", 2, 0, 2 },	// CB 90
+	{ "RES b,r (rb <- 0)", 2, 1, 2 },	// CB 91
+	{ "RES b,r (rb <- 0)", 2, 2, 2 },	// CB 92
+	{ "RES b,r (rb <- 0)", 2, 3, 2 },	// CB 93
+	{ "RES b,r (rb <- 0)", 2, 4, 2 },	// CB 94
+	{ "RES b,r (rb <- 0)", 2, 5, 2 },	// CB 95
+	{ "RES b,(HL) ((HL)b <- 0)", 4, 0, 2 },	// CB 96
+	{ "RES b,r (rb <- 0)", 2, 7, 2 },	// CB 97
+	{ "RES b,r (rb <- 0)", 2, 0, 3 },	// CB 98
+	{ "RES b,r (rb <- 0)", 2, 1, 3 },	// CB 99
+	{ "RES b,r (rb <- 0)", 2, 2, 3 },	// CB 9A
+	{ "RES b,r (rb <- 0)", 2, 3, 3 },	// CB 9B
+	{ "RES b,r (rb <- 0)", 2, 4, 3 },	// CB 9C
+	{ "RES b,r (rb <- 0)", 2, 5, 3 },	// CB 9D
+	{ "RES b,(HL) ((HL)b <- 0)", 4, 0, 3 },	// CB 9E
+	{ "RES b,r (rb <- 0)", 2, 7, 3 },	// CB 9F
+	{ "RES b,r (rb <- 0)", 2, 0, 4 },	// CB A0
+	{ "RES b,r (rb <- 0)", 2, 1, 4 },	// CB A1
+	{ "RES b,r (rb <- 0)", 2, 2, 4 },	// CB A2
+	{ "RES b,r (rb <- 0)", 2, 3, 4 },	// CB A3
+	{ "RES b,r (rb <- 0)", 2, 4, 4 },	// CB A4
+	{ "RES b,r (rb <- 0)", 2, 5, 4 },	// CB A5
+	{ "RES b,(HL) ((HL)b <- 0)", 4, 0, 4 },	// CB A6
+	{ "RES b,r (rb <- 0)", 2, 7, 4 },	// CB A7
+	{ "RES b,r (rb <- 0)", 2, 0, 5 },	// CB A8
+	{ "RES b,r (rb <- 0)", 2, 1, 5 },	// CB A9
+	{ "RES b,r (rb <- 0)", 2, 2, 5 },	// CB AA
+	{ "RES b,r (rb <- 0)", 2, 3, 5 },	// CB AB
+	{ "RES b,r (rb <- 0)", 2, 4, 5 },	// CB AC
+	{ "RES b,r (rb <- 0)", 2, 5, 5 },	// CB AD
+	{ "RES b,(HL) ((HL)b <- 0)", 4, 0, 5 },	// CB AE
+	{ "RES b,r (rb <- 0)", 2, 7, 5 },	// CB AF
+	{ "RES b,r (rb <- 0)", 2, 0, 6 },	// CB B0
+	{ "RES b,r (rb <- 0)", 2, 1, 6 },	// CB B1
+	{ "RES b,r (rb <- 0)", 2, 2, 6 },	// CB B2
+	{ "RES b,r (rb <- 0)", 2, 3, 6 },	// CB B3
+	{ "RES b,r (rb <- 0)", 2, 4, 6 },	// CB B4
+	{ "RES b,r (rb <- 0)", 2, 5, 6 },	// CB B5
+	{ "RES b,(HL) ((HL)b <- 0)", 4, 0, 6 },	// CB B6
+	{ "RES b,r (rb <- 0)", 2, 7, 6 },	// CB B7
+	{ "RES b,r (rb <- 0)", 2, 0, 7 },	// CB B8
+	{ "RES b,r (rb <- 0)", 2, 1, 7 },	// CB B9
+	{ "RES b,r (rb <- 0)", 2, 2, 7 },	// CB BA
+	{ "RES b,r (rb <- 0)", 2, 3, 7 },	// CB BB
+	{ "RES b,r (rb <- 0)", 2, 4, 7 },	// CB BC
+	{ "RES b,r (rb <- 0)", 2, 5, 7 },	// CB BD
+	{ "RES b,(HL) ((HL)b <- 0)", 4, 0, 7 },	// CB BE
+	{ "RES b,r (rb <- 0)", 2, 7, 7 },	// CB BF
+	{ "SET b,r (rb <- 1)", 2, 0, 0 },	// CB C0
+	{ "SET b,r (rb <- 1)", 2, 1, 0 },	// CB C1
+	{ "SET b,r (rb <- 1)", 2, 2, 0 },	// CB C2
+	{ "SET b,r (rb <- 1)", 2, 3, 0 },	// CB C3
+	{ "SET b,r (rb <- 1)", 2, 4, 0 },	// CB C4
+	{ "SET b,r (rb <- 1)", 2, 5, 0 },	// CB C5
+	{ "SET b,(HL) ((HL)b <- 1)", 4, 0, 0 },	// CB C6
+	{ "SET b,r (rb <- 1)", 2, 7, 0 },	// CB C7
+	{ "SET b,r (rb <- 1)", 2, 0, 1 },	// CB C8
+	{ "SET b,r (rb <- 1)", 2, 1, 1 },	// CB C9
+	{ "SET b,r (rb <- 1)", 2, 2, 1 },	// CB CA
+	{ "SET b,r (rb <- 1)", 2, 3, 1 },	// CB CB
+	{ "SET b,r (rb <- 1)", 2, 4, 1 },	// CB CC
+	{ "SET b,r (rb <- 1)", 2, 5, 1 },	// CB CD
+	{ "SET b,(HL) ((HL)b <- 1)", 4, 0, 1 },	// CB CE
+	{ "SET b,r (rb <- 1)", 2, 7, 1 },	// CB CF
+	{ "SET b,r (rb <- 1)", 2, 0, 2 },	// CB D0
+	{ "SET b,r (rb <- 1)", 2, 1, 2 },	// CB D1
+	{ "SET b,r (rb <- 1)", 2, 2, 2 },	// CB D2
+	{ "SET b,r (rb <- 1)", 2, 3, 2 },	// CB D3
+	{ "SET b,r (rb <- 1)", 2, 4, 2 },	// CB D4
+	{ "SET b,r (rb <- 1)", 2, 5, 2 },	// CB D5
+	{ "SET b,(HL) ((HL)b <- 1)", 4, 0, 2 },	// CB D6
+	{ "SET b,r (rb <- 1)", 2, 7, 2 },	// CB D7
+	{ "SET b,r (rb <- 1)", 2, 0, 3 },	// CB D8
+	{ "SET b,r (rb <- 1)", 2, 1, 3 },	// CB D9
+	{ "SET b,r (rb <- 1)", 2, 2, 3 },	// CB DA
+	{ "SET b,r (rb <- 1)", 2, 3, 3 },	// CB DB
+	{ "SET b,r (rb <- 1)", 2, 4, 3 },	// CB DC
+	{ "SET b,r (rb <- 1)", 2, 5, 3 },	// CB DD
+	{ "SET b,(HL) ((HL)b <- 1)", 4, 0, 3 },	// CB DE
+	{ "SET b,r (rb <- 1)", 2, 7, 3 },	// CB DF
+	{ "SET b,r (rb <- 1)", 2, 0, 4 },	// CB E0
+	{ "SET b,r (rb <- 1)", 2, 1, 4 },	// CB E1
+	{ "SET b,r (rb <- 1)", 2, 2, 4 },	// CB E2
+	{ "SET b,r (rb <- 1)", 2, 3, 4 },	// CB E3
+	{ "SET b,r (rb <- 1)", 2, 4, 4 },	// CB E4
+	{ "SET b,r (rb <- 1)", 2, 5, 4 },	// CB E5
+	{ "SET b,(HL) ((HL)b <- 1)", 4, 0, 4 },	// CB E6
+	{ "SET b,r (rb <- 1)", 2, 7, 4 },	// CB E7
+	{ "SET b,r (rb <- 1)", 2, 0, 5 },	// CB E8
+	{ "SET b,r (rb <- 1)", 2, 1, 5 },	// CB E9
+	{ "SET b,r (rb <- 1)", 2, 2, 5 },	// CB EA
+	{ "SET b,r (rb <- 1)", 2, 3, 5 },	// CB EB
+	{ "SET b,r (rb <- 1)", 2, 4, 5 },	// CB EC
+	{ "SET b,r (rb <- 1)", 2, 5, 5 },	// CB ED
+	{ "SET b,(HL) ((HL)b <- 1)", 4, 0, 5 },	// CB EE
+	{ "SET b,r (rb <- 1)", 2, 7, 5 },	// CB EF
+	{ "SET b,r (rb <- 1)", 2, 0, 6 },	// CB F0
+	{ "SET b,r (rb <- 1)", 2, 1, 6 },	// CB F1
+	{ "SET b,r (rb <- 1)", 2, 2, 6 },	// CB F2
+	{ "SET b,r (rb <- 1)", 2, 3, 6 },	// CB F3
+	{ "SET b,r (rb <- 1)", 2, 4, 6 },	// CB F4
+	{ "SET b,r (rb <- 1)", 2, 5, 6 },	// CB F5
+	{ "SET b,(HL) ((HL)b <- 1)", 4, 0, 6 },	// CB F6
+	{ "SET b,r (rb <- 1)", 2, 7, 6 },	// CB F7
+	{ "SET b,r (rb <- 1)", 2, 0, 7 },	// CB F8
+	{ "SET b,r (rb <- 1)", 2, 1, 7 },	// CB F9
+	{ "SET b,r (rb <- 1)", 2, 2, 7 },	// CB FA
+	{ "SET b,r (rb <- 1)", 2, 3, 7 },	// CB FB
+	{ "SET b,r (rb <- 1)", 2, 4, 7 },	// CB FC
+	{ "SET b,r (rb <- 1)", 2, 5, 7 },	// CB FD
+	{ "SET b,(HL) ((HL)b <- 1)", 4, 0, 7 },	// CB FE
+	{ "SET b,r (rb <- 1)", 2, 7, 7 },	// CB FF
+};
+
+std::string SM83::disassemble(const Opcode& op)
+{
+	// Illegal opcode or the 0xCB prefix
+	if (op.mnemonic == nullptr)
 	{
-		[]() {
-			return "HALT";
-		},
-		[this]() {
-			Halted = true;
-			if ((gb->IE->reg & gb->IF->reg & 0x1F) != 0 && IME == 0)
-			{
-				PendingInterruptWhileHalted = true;
-			}
-		},
-		1 // HALT instruction remains indefinitely until interrupt but cycle 
-		  // will be subtracted so we set this to 1 so that we don't wrap around 
-		  // 0xFF.
-	};
+		return "";
+	}
 
-	InstructionSet[0b00'010'000] =
+	// PC points to the byte following the opcode
+	std::stringstream s;
+	s << std::hex;
+
+	for (const char* c = op.mnemonic; *c != '\0'; c++)
 	{
-		[]() {
-			return "STOP";
-		},
-		[this]() {
-			Stopped = true;
-			// TODO
-
-			*gb->timer.DIV = 0;
-		},
-		1
-	};
+		if (*c != '{')
+		{
+			s << *c;
+			continue;
+		}
+
+		const char* End = strchr(c, '}');
+		std::string Field(c + 1, End);
+		c = End;
+
+		if (Field == "n")
+		{
+			s << (int)gb->read(PC);
+		}
+		else if (Field == "nn")
+		{
+			s << (int)(gb->read(PC) | (gb->read(PC + 1) << 8));
+		}
+		else if (Field == "FFn")
+		{
+			s << 0xFF00 + gb->read(PC);
+		}
+		else if (Field == "(FFn)")
+		{
+			s << (int)gb->read(0xFF00 + gb->read(PC));
+		}
+		else if (Field == "PC")
+		{
+			s << (int)PC;
+		}
+		else if (Field == "HL")
+		{
+			s << (int)HL;
+		}
+		else if (Field == "A")
+		{
+			s << (int)A;
+		}
+		else if (Field == "r")
+		{
+			s << (int)GPR(op.a);
+		}
+	}
+
+	return s.str();
 }
 
 inline uint8_t& SM83::GPR(uint8_t i)
@@ -2,16 +2,19 @@
 
 #include <cstdint>
 #include <string>
-#include <functional>
+#include "BlockCache.hpp"
+#include "JIT.hpp"
 
 class GBInternal;
 
 class SM83
 {
 	friend GBInternal;
+	friend class JIT;
+	friend class IdleLoop;
+	friend class Benchmark;
 
 public:
-	SM83();
 	void reset();
 
 	void connectGB(GBInternal *gb);
@@ -22,6 +25,27 @@ public:
 
 	uint32_t nMachineCycles = 0;
 
+	// Number of instructions executed, used for benchmarking
+	uint64_t nInstructions = 0;
+
+	// Most flags set by an ALU operation are overwritten before 
+	// anything reads them. With lazy flags the operands are stored 
+	// instead and the flags are only worked out once they're needed.
+	void useLazyFlags(bool Enabled);
+
+	// F as it is or will be once the pending flags are worked out
+	uint8_t flags();
+
+	// Works out the flags left pending by the last ALU operation
+	void materializeFlags()
+	{
+		if (LazyOp != LazyNone)
+		{
+			F = flags();
+			LazyOp = LazyNone;
+		}
+	}
+
 private:
 
 	// ============== Registers ============== 
@@ -76,19 +100,111 @@ private:
 	uint16_t PC, SP; // Program Counter, Stack Pointer
 
 	// ============== Instructions ==============
-	uint8_t a, b;
-
-	struct
+	// Executes a single instruction. The opcode has already been 
+	// fetched and PC points to the byte following it.
+	void execute(uint8_t opcode);
+
+	// Executes an instruction following the 0xCB prefix.
+	void executeCB(uint8_t opcode);
+
+	// Opcode information used for timing and disassembly. The 
+	// instructions themselves are dispatched through the switch 
+	// statements in execute() and executeCB() so nothing needs 
+	// to be copied when an instruction is fetched.
+	struct Opcode
 	{
-		std::function<std::string()> mnemonic;
-		std::function<void()> op;
+		const char* mnemonic;	// nullptr for illegal opcodes
 		uint8_t cycles;
-		uint8_t a;
+		uint8_t a;	// Register or bit operands
 		uint8_t b;
-	} InstructionSet[256], 
-		CurrentInstruction, 
-		InstructionSet16Bit[256],
-		CurrentInstruction16Bit;
+	};
+
+	static const Opcode InstructionSet[256], 
+		InstructionSet16Bit[256];
+
+	// Mnemonic of an instruction which has just been fetched
+	// with its operands filled in, used for debugging.
+	std::string disassemble(const Opcode& op);
+
+	// ALU operations shared between the register, 
+	// immediate and (HL) addressing modes.
+	inline void add8(uint8_t n);
+	inline void adc8(uint8_t n);
+	inline void sub8(uint8_t n);
+	inline void sbc8(uint8_t n);
+	inline void and8(uint8_t n);
+	inline void xor8(uint8_t n);
+	inline void or8(uint8_t n);
+	inline void cp8(uint8_t n);
+	inline uint8_t inc8(uint8_t n);
+	inline uint8_t dec8(uint8_t n);
+	inline void addHL(uint16_t n);
+	inline uint16_t addSPe();
+
+	bool LazyFlags = true;
+
+	// The last ALU operation whose flags haven't been worked out
+	// yet. ADC and SBC share Add and Sub with LazyCarry set to the 
+	// carry in. Inc and Dec leave CY as it was.
+	enum : uint8_t
+	{
+		LazyNone,
+		LazyAdd,
+		LazySub,	// Also CP
+		LazyAnd,
+		LazyOr,		// Also XOR
+		LazyInc,
+		LazyDec
+	};
+
+	uint8_t LazyOp = LazyNone;
+	uint8_t LazyX, LazyY;	// Operands
+	uint8_t LazyR;			// Result
+	bool LazyCarry;
+
+	inline void lazy(uint8_t Op, uint8_t X, uint8_t Y, bool Carry, uint8_t R);
+
+	// Rotate and shift operations (0xCB prefix)
+	inline uint8_t rlc(uint8_t n);
+	inline uint8_t rl(uint8_t n);
+	inline uint8_t rrc(uint8_t n);
+	inline uint8_t rr(uint8_t n);
+	inline uint8_t sla(uint8_t n);
+	inline uint8_t sra(uint8_t n);
+	inline uint8_t swap(uint8_t n);
+	inline uint8_t srl(uint8_t n);
+
+	// Condition codes NZ, Z, NC and C encoded in bits 3-4 of an opcode
+	inline bool condition(uint8_t opcode);
+
+	// Reads the immediate operands following an opcode
+	inline uint8_t imm8();
+	inline uint16_t imm16();
+
+	// Instruction currently being executed if it came
+	// from the block cache, otherwise nullptr.
+	BlockCache::MicroOp* Op = nullptr;
+
+	// Translated run which is still being counted down, 
+	// along with the registers and PC from before it.
+	const JITRun* Run = nullptr;
+	JITRegisters RunStart;
+	uint16_t RunPC;
+
+	// Instructions the run got through and the
+	// machine cycles it stopped short by.
+	uint8_t RunDone;
+	uint8_t RunLeft;
+
+	// Executes translated code if there is any for Op
+	bool runNative();
+
+	// Rolls back the current run if an interrupt would
+	// have been serviced part way through it.
+	void checkRun();
+
+	inline void push(uint16_t r);
+	inline uint16_t pop();
 
 	uint8_t cycle;		// Cycle Number
 
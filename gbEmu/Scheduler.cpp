@@ -0,0 +1,75 @@
+#include "Scheduler.hpp"
+#include "GBInternal.hpp"
+
+void Scheduler::connectGB(GBInternal* gb)
+{
+	this->gb = gb;
+
+	for (uint8_t i = 0; i < nEvents; i++)
+	{
+		Deadline[i] = Never;
+	}
+
+	Next = Never;
+}
+
+void Scheduler::schedule(Event e, uint64_t When)
+{
+	Deadline[e] = When;
+
+	// If this pushed back the earliest event Next is left as
+	// it was, dispatch() will find nothing to do and fix it.
+	if (When < Next)
+	{
+		Next = When;
+	}
+}
+
+void Scheduler::dispatch()
+{
+	uint64_t Now = gb->nClockCycles;
+
+	for (uint8_t i = 0; i < nEvents; i++)
+	{
+		if (Deadline[i] > Now)
+		{
+			continue;
+		}
+
+		// Handlers reschedule themselves if they need to
+		Deadline[i] = Never;
+
+		switch (i)
+		{
+		case PPUDot:
+			gb->ppu.clock();
+			LastInterrupt = Now;
+			break;
+		case TimerOverflow:
+			LastInterrupt = Now;
+			gb->timer.catchUp(Now + 1);
+			gb->timer.schedule();
+			break;
+		case DMATransfer:
+			gb->dma.clock();
+			break;
+		case FrameSequencer:
+			gb->apu.frameSequencer();
+			break;
+		}
+	}
+
+	Next = Never;
+	for (uint8_t i = 0; i < nEvents; i++)
+	{
+		if (Deadline[i] < Next)
+		{
+			Next = Deadline[i];
+		}
+	}
+}
+
+uint64_t Scheduler::nextInterrupt()
+{
+	return Deadline[PPUDot] < Deadline[TimerOverflow] ? Deadline[PPUDot] : Deadline[TimerOverflow];
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+
+class GBInternal;
+
+/// <summary>
+/// Keeps track of the next T-cycle at which each component
+/// has something to do so they don't need to be clocked on
+/// every T-cycle just to find out nothing has happened. Each
+/// kind of event has a fixed slot holding its deadline, the
+/// earliest of which is kept in Next so the main loop only
+/// needs a single comparison per T-cycle. Events due on the
+/// same T-cycle are handled in slot order, which matches the
+/// order the components used to be clocked in.
+/// </summary>
+class Scheduler
+{
+public:
+	GBInternal* gb;
+
+	void connectGB(GBInternal* gb);
+
+	enum Event
+	{
+		PPUDot,			// PPU is drawing, changing mode or a register was written
+		TimerOverflow,	// TIMA overflows or the Timer needs clocking every T-cycle
+		DMATransfer,	// OAM DMA transfer starts or ends
+		FrameSequencer,	// APU length, sweep and envelope units are clocked
+		nEvents
+	};
+
+	static const uint64_t Never = UINT64_MAX;
+
+	// Sets the T-cycle at which e happens, replacing
+	// any deadline previously set for it.
+	void schedule(Event e, uint64_t When);
+
+	// Earliest deadline of all the events
+	uint64_t Next = 0;
+
+	// Handles every event due at the current T-cycle
+	void dispatch();
+
+	// Earliest event which could raise an interrupt. Only the 
+	// PPU and Timer ever set bits in IF, the serial port and 
+	// joypad interrupts are never requested.
+	uint64_t nextInterrupt();
+
+	// T-cycle of the last PPU or Timer event handled
+	uint64_t LastInterrupt = 0;
+
+private:
+	uint64_t Deadline[nEvents];
+};
\ No newline at end of file
@@ -14,7 +14,22 @@ public:
 
 	void connectGB(GBInternal* gb);
 	virtual uint8_t GetSample() = 0;
-	virtual void clock() = 0;
+
+	// Clocks the channel for T-cycle Cycle. Returns
+	// whether GetSample() may have changed.
+	virtual bool clock(uint64_t Cycle) = 0;
+
+	// Until a register is written or the frame sequencer clocks a
+	// unit the output only changes when the period divider (or the
+	// LFSR) steps, so the APU can move the channel from one step
+	// to the next instead of clocking it on every T-cycle.
+
+	// First T-cycle from From onwards on which the output steps
+	virtual uint64_t nextStep(uint64_t From) = 0;
+
+	// Same as clocking the T-cycles from From up to To, which 
+	// mustn't go past the T-cycle after the next step.
+	virtual void skip(uint64_t From, uint64_t To) = 0;
 
 	// Contains series of events to occur on
 	// channel triggering.
@@ -55,7 +70,24 @@ public:
 	// Keeps track of the DAC
 	bool DACon;
 
+	// Set when a register is written so the channel 
+	// re-evaluates its state on the next T-cycle.
+	bool Dirty = true;
+
 	// Each channel is assigned a numerical value
 	uint8_t ChannelNum;
+
+protected:
+	// Number of T-cycles from From up to To which are a multiple of Every
+	static uint64_t ticks(uint64_t From, uint64_t To, uint64_t Every)
+	{
+		return (To + Every - 1) / Every - (From + Every - 1) / Every;
+	}
+
+	// The nth T-cycle from From onwards which is a multiple of Every
+	static uint64_t nthTick(uint64_t From, uint64_t Every, uint64_t n)
+	{
+		return ((From + Every - 1) / Every + n - 1) * Every;
+	}
 };
 
@@ -0,0 +1,94 @@
+#include "TileCache.hpp"
+#include "GBInternal.hpp"
+
+void TileCache::connectGB(GBInternal* gb)
+{
+	this->gb = gb;
+
+	connectRAM(gb->RAM);
+}
+
+void TileCache::connectRAM(const uint8_t* RAM)
+{
+	this->RAM = RAM;
+}
+
+void TileCache::decodeRow(uint8_t LO, uint8_t HI, uint8_t* Row, bool XFlip)
+{
+	// Bit 7 holds the leftmost pixel
+	for (uint8_t x = 0; x < 8; x++)
+	{
+		uint8_t p = XFlip ? x : 7 - x;
+
+		Row[x] = (((HI >> p) & 0x01) << 1) | ((LO >> p) & 0x01);
+	}
+}
+
+void TileCache::decode(uint16_t Tile)
+{
+	// Each row of a tile is two bytes, low bits first
+	const uint8_t* Data = RAM + 0x8000 + Tile * 0x10;
+
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		decodeRow(Data[y * 2], Data[y * 2 + 1], Pixels[Tile][y], false);
+		decodeRow(Data[y * 2], Data[y * 2 + 1], Flipped[Tile][y], true);
+	}
+
+	Valid[Tile] = true;
+}
+
+const uint8_t* TileCache::row(uint16_t addr, bool XFlip)
+{
+	// Objects on a line where LCDC changed between OAM scan 
+	// and drawing can have their rows outside the tile data.
+	if (addr < 0x8000 || addr >= 0x9800)
+	{
+		decodeRow(RAM[addr], RAM[addr + 1], Outside, XFlip);
+		return Outside;
+	}
+
+	uint16_t Tile = (addr - 0x8000) >> 4;
+	uint8_t y = (addr >> 1) & 0x07;
+
+	// Writes aren't tracked while disabled, only the row
+	// being looked up is expanded and nothing is kept.
+	if (!Enabled)
+	{
+		uint8_t* Row = XFlip ? Flipped[Tile][y] : Pixels[Tile][y];
+		decodeRow(RAM[addr], RAM[addr + 1], Row, XFlip);
+		Valid[Tile] = false;
+
+		return Row;
+	}
+
+	if (Valid[Tile])
+	{
+		nHits++;
+	}
+	else
+	{
+		decode(Tile);
+		nMisses++;
+	}
+
+	return XFlip ? Flipped[Tile][y] : Pixels[Tile][y];
+}
+
+void TileCache::invalidate(uint16_t addr)
+{
+	uint16_t Tile = (addr - 0x8000) >> 4;
+
+	if (Valid[Tile])
+	{
+		Valid[Tile] = false;
+		nInvalidations++;
+	}
+}
+
+double TileCache::hitRate()
+{
+	uint64_t nLookups = nHits + nMisses;
+
+	return nLookups == 0 ? 0.0 : (double)nHits / nLookups;
+}
\ No newline at end of file
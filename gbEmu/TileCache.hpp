@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+
+class GBInternal;
+
+/// <summary>
+/// Keeps the 384 tiles in VRAM (0x8000-0x97FF) expanded to one
+/// colour index (0-3) per pixel so the PPU doesn't have to pick
+/// the two bits of a pixel out of the tile's low and high bytes
+/// every time it draws one. Each tile is also kept mirrored
+/// horizontally for objects with X-flip set. Tiles are expanded
+/// the first time they're drawn and again after being written
+/// to, writes to tile data go through GBInternal::write which
+/// marks the tile as stale.
+/// </summary>
+class TileCache
+{
+public:
+	GBInternal* gb;
+
+	void connectGB(GBInternal* gb);
+
+	// Reads tiles from another copy of memory instead
+	// of the one belonging to the connected GBInternal.
+	void connectRAM(const uint8_t* RAM);
+
+	// Returns the 8 colour indices of the tile row whose low byte
+	// is at addr, leftmost pixel first. When flipped
+	// the rightmost pixel comes first. Rows stay the same until 
+	// VRAM is next written, rows from anywhere else only until 
+	// the next lookup.
+	const uint8_t* row(uint16_t addr, bool XFlip);
+
+	// Called on every write to 0x8000-0x97FF
+	void invalidate(uint16_t addr);
+
+	// When disabled rows are expanded on every lookup
+	bool Enabled = true;
+
+	// Rows looked up from an already expanded tile, rows which 
+	// required expanding their tile and writes to expanded tiles.
+	uint64_t nHits = 0, nMisses = 0, nInvalidations = 0;
+
+	double hitRate();
+
+private:
+	static const uint16_t nTiles = 384;
+
+	const uint8_t* RAM = nullptr;
+
+	uint8_t Pixels[nTiles][8][8];
+	uint8_t Flipped[nTiles][8][8];
+
+	bool Valid[nTiles] = { false };
+
+	// Rows from outside the tile data, overwritten by the next one
+	uint8_t Outside[8];
+
+	void decode(uint16_t Tile);
+
+	static void decodeRow(uint8_t LO, uint8_t HI, uint8_t* Row, bool XFlip);
+};
\ No newline at end of file
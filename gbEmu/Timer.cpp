@@ -93,4 +93,129 @@ void Timer::incrementTimer()
 	}
 
 	DelayedBit = CurrentCounterBit;
+}
+
+bool Timer::needsClocking()
+{
+	bool CurrentCounterBit = (Counter >> RateBitSelect) & TAC->Enable;
+
+	return Overflowed || FourClockCyclesB > 0 || DelayedBit != CurrentCounterBit;
+}
+
+void Timer::skip(uint64_t nTicks)
+{
+	Counter += (uint16_t)nTicks;
+	(*DIV) = Counter >> 8;
+	DelayedBit = (Counter >> RateBitSelect) & TAC->Enable;
+
+	ClockedTo += nTicks;
+}
+
+void Timer::catchUp(uint64_t Until)
+{
+	while (ClockedTo < Until)
+	{
+		if (needsClocking())
+		{
+			clock();
+			ClockedTo++;
+			continue;
+		}
+
+		uint64_t nTicks = Until - ClockedTo;
+
+		if (!TAC->Enable)
+		{
+			// Only DIV changes
+			skip(nTicks);
+			continue;
+		}
+
+		// TIMA is incremented each time the selected counter bit falls,
+		// that is every Period T-cycles starting with the First.
+		uint32_t Period = 2 << RateBitSelect;
+		uint32_t First = Period - (Counter % Period);
+		uint64_t nIncrements = First > nTicks ? 0 : 1 + (nTicks - First) / Period;
+
+		if (*TIMA + nIncrements <= 0xFF)
+		{
+			*TIMA += nIncrements;
+			skip(nTicks);
+		}
+		else
+		{
+			// Move up to the T-cycle which overflows TIMA
+			// and clock it so the overflow is dealt with.
+			skip(First - 1 + (0xFF - *TIMA) * Period);
+			*TIMA = 0xFF;
+
+			clock();
+			ClockedTo++;
+		}
+	}
+}
+
+void Timer::schedule()
+{
+	uint64_t Next = Scheduler::Never;
+
+	if (needsClocking())
+	{
+		Next = ClockedTo;
+	}
+	else if (TAC->Enable)
+	{
+		uint32_t Period = 2 << RateBitSelect;
+		uint32_t First = Period - (Counter % Period);
+
+		Next = ClockedTo + First - 1 + (0xFF - *TIMA) * Period;
+	}
+
+	gb->scheduler.schedule(Scheduler::TimerOverflow, Next);
+}
+
+uint64_t Timer::nextChange(uint16_t addr)
+{
+	if (needsClocking())
+	{
+		return ClockedTo;
+	}
+
+	// DIV is the upper 8 bits of the counter
+	if (addr == 0xFF04)
+	{
+		return ClockedTo + (256 - Counter % 256) - 1;
+	}
+
+	if (!TAC->Enable)
+	{
+		return Scheduler::Never;
+	}
+
+	uint32_t Period = 2 << RateBitSelect;
+
+	return ClockedTo + Period - (Counter % Period) - 1;
+}
+
+bool Timer::changedWithin(uint16_t addr, uint32_t nTicks)
+{
+	if (needsClocking())
+	{
+		return true;
+	}
+
+	if (addr == 0xFF04)
+	{
+		return nTicks >= 256 || (uint16_t)(Counter - nTicks) >> 8 != Counter >> 8;
+	}
+
+	if (!TAC->Enable)
+	{
+		return false;
+	}
+
+	// TIMA is incremented whenever the counter reaches a multiple of Period
+	uint32_t Period = 2 << RateBitSelect;
+
+	return Counter % Period < nTicks;
 }
\ No newline at end of file
@@ -12,6 +12,27 @@ public:
 	void clock();
 	void incrementTimer();
 
+	// The Timer isn't clocked every T-cycle. Instead the T-cycles
+	// up to (but not including) Until are caught up on all at once 
+	// whenever the CPU accesses the Timer registers or TIMA
+	// overflows.
+	void catchUp(uint64_t Until);
+
+	// Schedules the next T-cycle at which TIMA overflows
+	void schedule();
+
+	// T-cycle whose clocking next changes DIV or TIMA (addr),
+	// as long as the registers aren't written before then.
+	// The Timer must be caught up first.
+	uint64_t nextChange(uint16_t addr);
+
+	// Whether DIV or TIMA (addr) changed on any of
+	// the last nTicks T-cycles which were clocked.
+	bool changedWithin(uint16_t addr, uint32_t nTicks);
+
+	// T-cycles before this one have been clocked
+	uint64_t ClockedTo = 0;
+
 	// Divider (Read/Reset)
 	uint8_t* DIV;
 
@@ -48,4 +69,12 @@ public:
 
 private:
 	bool DelayedBit = 0;
+
+	// Whether the T-cycles can be counted all at once or if each has
+	// to be clocked, either to deal with an overflow or because the
+	// counter bit changed without being clocked (DIV or TAC written).
+	bool needsClocking();
+
+	// Moves forward nTicks which don't increment TIMA
+	void skip(uint64_t nTicks);
 };
\ No newline at end of file
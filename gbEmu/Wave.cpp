@@ -6,21 +6,37 @@ Wave::Wave(uint8_t ChannelNum) : SoundChannel(ChannelNum)
 
 }
 
-void Wave::clock()
+bool Wave::clock(uint64_t Cycle)
 {
+	bool Stepped = false;
+
 	// Increments divider which controls 
 	// period duration of wave.
-	if (gb->nClockCycles % 2 == 0)	// Clocked at 4.19MHz/2
+	if (Cycle % 2 == 0)	// Clocked at 4.19MHz/2
 	{
 		if (PeriodDiv->clock())
 		{
 			PatternInd++;
 			PatternInd %= 32;
+			Stepped = true;
 		}
 	}
 
+	// The rest only depends on the registers and the frame
+	// sequencer so it's only re-evaluated after a register was 
+	// written or the frame sequencer clocked a unit, in which
+	// case it's evaluated again on the next T-cycle as well.
+	if (!Dirty && gb->apu.Steps == 0)
+	{
+		return Stepped;
+	}
+
+	Dirty = gb->apu.Steps != 0;
+
 	// Checks if DAC is enabled or disabled 
 	// which enables or mutes the channel
+	DACon = NR30->bDAC != 0;
+
 	if (NR30->bDAC == 0)
 	{
 		Mute = true;
@@ -44,7 +60,7 @@ void Wave::clock()
 		LenCounterOn = false;
 	}
 
-	if (gb->nClockCycles % (1 << 14) == 0 && NR34->LenEnable)	// Called at 256Hz
+	if ((gb->apu.Steps & APU::LengthStep) && NR34->LenEnable)	// Called at 256Hz
 	{
 		if (LenCount++ == 255)
 		{
@@ -53,6 +69,22 @@ void Wave::clock()
 			gb->apu.NR52->bCH3 = 0;
 		}
 	}
+
+	return true;
+}
+
+uint64_t Wave::nextStep(uint64_t From)
+{
+	// The next sample is played whenever the divider overflows
+	return nthTick(From, 2, PeriodDiv->untilOverflow());
+}
+
+void Wave::skip(uint64_t From, uint64_t To)
+{
+	uint64_t nOverflows = PeriodDiv->nOverflows;
+	PeriodDiv->advance(ticks(From, To, 2));
+
+	PatternInd = (PatternInd + (PeriodDiv->nOverflows - nOverflows)) % 32;
 }
 
 uint8_t Wave::GetSample()
@@ -3,15 +3,112 @@
 
 #include <iostream>
 #include "GB.hpp"
+#include "Benchmark.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <thread>
 
 #include "SDL.h"
 
+// Reads a whole decimal number between Min and Max into Value,
+// anything else is reported and Value is left as it was.
+static void parseNumber(const char* Option, const char* Text, uint32_t Min, uint32_t Max, uint32_t& Value)
+{
+    char* End;
+    unsigned long Number = std::strtoul(Text, &End, 10);
+
+    if (!std::isdigit((unsigned char)*Text) || *End != '\0' || Number < Min || Number > Max)
+    {
+        std::cerr << "Ignoring " << Option << " " << Text << ", expected a number from "
+            << Min << " to " << Max << std::endl;
+        return;
+    }
+
+    Value = (uint32_t)Number;
+}
+
 int main(int argc, char* argv[])
 {
-    GB gb;
+    // gbEmu --bench <rom> runs the benchmarks headless
+    if (argc == 3 && std::string(argv[1]) == "--bench")
+    {
+        Benchmark bench(argv[2]);
+        bench.run();
+
+        return 0;
+    }
+
+    Settings settings;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--jit")
+        {
+            settings.UseJIT = true;
+        }
+        else if (arg == "--step")
+        {
+            settings.UseStepping = true;
+        }
+        else if (arg == "--idle-loops")
+        {
+            settings.UseIdleLoops = true;
+        }
+        else if (arg == "--frameskip" && i + 1 < argc)
+        {
+            parseNumber(argv[i], argv[i + 1], 1, 60, settings.FrameSkip);
+            i++;
+        }
+        else if (arg == "--draw-shown")
+        {
+            settings.DrawShownOnly = true;
+        }
+        else if (arg == "--render-thread")
+        {
+            settings.RenderThread = true;
+        }
+        else if (arg == "--scale" && i + 1 < argc)
+        {
+            parseNumber(argv[i], argv[i + 1], 1, 8, settings.Scale);
+            i++;
+        }
+        else if (arg == "--scale2x")
+        {
+            settings.Scale2x = true;
+        }
+        else if (arg == "--lcd-grid")
+        {
+            settings.LCDGrid = true;
+        }
+        else if (arg == "--ghosting")
+        {
+            settings.Ghosting = true;
+        }
+        else if (arg == "--post-threads" && i + 1 < argc)
+        {
+            // 0 picks one for each core, more than that only adds overhead
+            uint32_t nCores = std::max(1u, std::thread::hardware_concurrency());
+            parseNumber(argv[i], argv[i + 1], 0, nCores, settings.PostThreads);
+            i++;
+        }
+        else if (arg == "--audio-latency" && i + 1 < argc)
+        {
+            parseNumber(argv[i], argv[i + 1], 1, 1000, settings.AudioLatency);
+            i++;
+        }
+        else if (arg == "--audio-stats")
+        {
+            settings.AudioStats = true;
+        }
+    }
+
+    GB gb(settings);
 
     return 0;
 }
-